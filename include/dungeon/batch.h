@@ -0,0 +1,62 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/item.h"
+#include "dungeon/rng.h"
+#include "dungeon/vec2.h"
+
+typedef struct GameBatch GameBatch;
+
+// Many games stepped in lockstep, e.g. as an environment for training a policy.
+// Player fields are stored structure-of-arrays (entry 'i' of each array belongs to game 'i'), so that the common
+// cases - moving around, bumping into walls, actions that change nothing, health changes and resets - run as loops
+// over whole arrays that the compiler can vectorise. Anything random (traps, encounters, eating) falls back to
+// Game_Step() for just that game, so every game plays out exactly as it would as a GameState.
+struct GameBatch {
+    int32_t count;
+    DungeonParams params;
+    uint64_t seed;
+    // Player state (see Player):
+    vec2_scalar* positionX;
+    vec2_scalar* positionY;
+    vec2_scalar* previousX;
+    vec2_scalar* previousY;
+    int8_t* health;
+    int8_t* maxHealth;
+    uint8_t* inventory[_ITEM_TYPE_COUNT];
+    // Game state (see GameState), with 'encounter' and 'status' stored as Encounter and GameStatus:
+    uint8_t* encounter;
+    uint8_t* status;
+    Rng* rngs;
+    Dungeon** dungeons;
+    // How many games have been started in each slot so far:
+    int64_t* episodes;
+    // Scratch space for the vectorised passes:
+    vec2_scalar* nextX;
+    vec2_scalar* nextY;
+    uint8_t* moves;
+    int32_t* pending;
+    // Every array above lives in this one allocation:
+    void* memory;
+};
+
+// Create 'count' games in dungeons described by 'params', all ready to play.
+// Games are seeded from 'seed' and their slot, so a batch always plays out the same way given the same actions.
+void GameBatch_Init(GameBatch* self, int32_t count, const DungeonParams* params, uint64_t seed);
+void GameBatch_Destroy(GameBatch* self);
+// Start a new game in every slot whose game has finished, returning how many were started.
+int32_t GameBatch_Reset(GameBatch* self);
+// Apply 'actions[i]' to game 'i', as Game_Step() would. Finished games ignore their action until reset.
+void GameBatch_Step(GameBatch* self, const Action actions[]);
+// Adjust the health of game 'i' by 'amounts[i]', as Player_AdjustHealth() would. Any game left without health dies.
+void GameBatch_AdjustHealth(GameBatch* self, const int8_t amounts[]);
+// Copy game 'index' out into 'outGame' (which shares its dungeon), e.g. to render it.
+void GameBatch_GetGame(const GameBatch* self, int32_t index, GameState* outGame);
+// Overwrite game 'index' with 'game', which must be playing in the same dungeon.
+void GameBatch_SetGame(GameBatch* self, int32_t index, const GameState* game);
+
+#endif // __BATCH_H__
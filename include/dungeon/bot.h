@@ -0,0 +1,12 @@
+#ifndef __BOT_H__
+#define __BOT_H__
+
+#include "dungeon/game.h"
+#include "dungeon/rng.h"
+
+// A simple scripted policy for automated play - it only uses information a human player would have
+// (health, inventory, the current encounter and which rooms have been explored), and draws any
+// tie-breaking randomness from 'rng' so that games stay reproducible.
+Action Bot_ChooseAction(const GameState* game, Rng* rng);
+
+#endif // __BOT_H__
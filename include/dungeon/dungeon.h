@@ -1,10 +1,14 @@
 #ifndef __DUNGEON_H__
 #define __DUNGEON_H__
 
+#include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "dungeon/item.h"
+#include "dungeon/rng.h"
+#include "dungeon/sampler.h"
 #include "dungeon/vec2.h"
 
 typedef struct Dungeon Dungeon;
@@ -35,9 +39,9 @@ static inline const char* RoomType_ToString(const RoomType self) {
     return "[ERROR]";
 }
 
+// Unpacked working copy of a room - rooms are stored as PackedRoom, and whether they have been visited separately.
 struct Room {
     RoomType type;
-    bool visited;
     union {
         uint8_t empty;
         ItemType item;
@@ -54,27 +58,254 @@ struct Room {
     };
 };
 
+// Initialise 'self' as a new room of 'type', drawing anything random from 'rng'.
+void Room_Init(Room* self, RoomType type, const Sampler* items, Rng* rng);
 void Room_InitEmpty(Room* self);
-void Room_InitItem(Room* self);
+// 'items' samples which ItemType is found (see DungeonParams::itemDistribution).
+void Room_InitItem(Room* self, const Sampler* items, Rng* rng);
 void Room_InitPit(Room* self);
-void Room_InitTrap(Room* self);
-void Room_InitEnemy(Room* self);
+void Room_InitTrap(Room* self, Rng* rng);
+void Room_InitEnemy(Room* self, Rng* rng);
 void Room_InitTreasure(Room* self);
 void Room_InitSpawn(Room* self);
 void Room_Clear(Room* self);
 
+// A Room bit-packed into 16 bits, as stored by the dungeon:
+//   bits 0-2:  RoomType
+//   bits 3-8:  ItemType (ROOM_ITEM), maxDamage (ROOM_TRAP) or health (ROOM_ENEMY)
+//   bits 9-14: maxDamage (ROOM_ENEMY)
+typedef uint16_t PackedRoom;
+
+#define PACKED_ROOM_TYPE_BITS 3
+#define PACKED_ROOM_FIELD_BITS 6
+#define PACKED_ROOM_FIELD_MAX ((1 << PACKED_ROOM_FIELD_BITS) - 1)
+
+static inline PackedRoom PackedRoom_Make(const RoomType type, const int32_t fieldA, const int32_t fieldB) {
+    assert(type >= 0 && type < _ROOM_TYPE_COUNT);
+    assert(fieldA >= 0 && fieldA <= PACKED_ROOM_FIELD_MAX);
+    assert(fieldB >= 0 && fieldB <= PACKED_ROOM_FIELD_MAX);
+    return (PackedRoom)(
+        (uint32_t)type
+        | ((uint32_t)fieldA << PACKED_ROOM_TYPE_BITS)
+        | ((uint32_t)fieldB << (PACKED_ROOM_TYPE_BITS + PACKED_ROOM_FIELD_BITS))
+    );
+}
+
+static inline RoomType PackedRoom_GetType(const PackedRoom self) {
+    return (RoomType)(self & ((1 << PACKED_ROOM_TYPE_BITS) - 1));
+}
+
+static inline int32_t PackedRoom_GetFieldA(const PackedRoom self) {
+    return (self >> PACKED_ROOM_TYPE_BITS) & PACKED_ROOM_FIELD_MAX;
+}
+
+static inline int32_t PackedRoom_GetFieldB(const PackedRoom self) {
+    return (self >> (PACKED_ROOM_TYPE_BITS + PACKED_ROOM_FIELD_BITS)) & PACKED_ROOM_FIELD_MAX;
+}
+
+static inline PackedRoom Room_Pack(const Room *const self) {
+    assert(self != NULL);
+    switch (self->type) {
+        case ROOM_ITEM: return PackedRoom_Make(self->type, self->item, 0);
+        case ROOM_TRAP: return PackedRoom_Make(self->type, self->trap.maxDamage, 0);
+        case ROOM_ENEMY: return PackedRoom_Make(self->type, self->enemy.health, self->enemy.maxDamage);
+        default: return PackedRoom_Make(self->type, 0, 0);
+    }
+}
+
+static inline Room Room_Unpack(const PackedRoom packed) {
+    Room room = { .type = PackedRoom_GetType(packed) };
+    switch (room.type) {
+        case ROOM_ITEM: {
+            room.item = (ItemType)PackedRoom_GetFieldA(packed);
+        } break;
+        case ROOM_TRAP: {
+            room.trap.maxDamage = (int8_t)PackedRoom_GetFieldA(packed);
+        } break;
+        case ROOM_ENEMY: {
+            room.enemy.health = (int8_t)PackedRoom_GetFieldA(packed);
+            room.enemy.maxDamage = (int8_t)PackedRoom_GetFieldB(packed);
+        } break;
+        default: break;
+    }
+    return room;
+}
+
+typedef struct DungeonParams DungeonParams;
+typedef struct RoomTable RoomTable;
+typedef struct RoomTableEntry RoomTableEntry;
+
+typedef enum DungeonGeneration {
+    // Every room is generated and stored up-front, so creation time and memory are O(area).
+    DUNGEON_GENERATION_DENSE,
+    // Rooms are derived on demand from a hash of (seed, x, y) and only rooms that change are stored,
+    // so creation time is O(1) and memory only grows with the rooms the player actually touches.
+    // Room types are drawn independently, so only ROOM_TREASURE and ROOM_SPAWN are guaranteed to appear.
+    DUNGEON_GENERATION_HASHED,
+    // Generated up-front in parallel, with the same per-type room counts as DUNGEON_GENERATION_DENSE.
+    // Rows are split into fixed tiles that each draw from their own stream, so the dungeon only depends on the
+    // seed, never the thread count (but differs from a dense dungeon with the same seed).
+    // The result is stored as (and reports itself as) a DUNGEON_GENERATION_DENSE dungeon.
+    DUNGEON_GENERATION_TILED,
+} DungeonGeneration;
+
+// What to do with dungeons whose treasure can't be reached safely (see Dungeon_IsSolvable()).
+// Only dungeons that store every room can be checked, so DUNGEON_GENERATION_HASHED always acts as
+// DUNGEON_VALIDATION_NONE.
+typedef enum DungeonValidation {
+    // Keep every dungeon as generated.
+    DUNGEON_VALIDATION_NONE,
+    // Throw the dungeon away and generate another, so dungeons are drawn only from the solvable ones.
+    // Falls back to DUNGEON_VALIDATION_REPAIR if nothing solvable turns up within a bounded number of attempts.
+    DUNGEON_VALIDATION_REJECT,
+    // Swap every pit and enemy on a shortest path from the spawn to the treasure with a harmless room elsewhere.
+    // Cheaper than rejecting, and every room count stays the same, but hazards end up slightly off the beaten path.
+    DUNGEON_VALIDATION_REPAIR,
+} DungeonValidation;
+
+struct DungeonParams {
+    vec2 size;
+    DungeonGeneration generation;
+    // Relative chance of each RoomType appearing - every type is guaranteed to appear at least once.
+    // ROOM_TREASURE and ROOM_SPAWN must be 0, as they are always placed exactly once.
+    int32_t roomDistribution[_ROOM_TYPE_COUNT];
+    // Relative chance of each ItemType being found in an item room.
+    int32_t itemDistribution[_ITEM_TYPE_COUNT];
+    // DUNGEON_GENERATION_TILED only: threads to generate across (see Parallel_ResolveThreadCount()).
+    int32_t threadCount;
+    // Ignored by DUNGEON_GENERATION_HASHED, which is always treated as DUNGEON_VALIDATION_NONE:
+    DungeonValidation validation;
+    // Pits a solvable dungeon may ask the player to get across (the starting kit can swing over one for certain).
+    int32_t crossablePits;
+};
+
+// Get the default generation parameters for a dungeon of 'size' rooms.
+DungeonParams DungeonParams_Default(const vec2 size);
+
+// Open-addressed hash map from room position to room.
+struct RoomTable {
+    RoomTableEntry* entries;
+    int64_t capacity;
+    int64_t count;
+};
+
+struct RoomTableEntry {
+    uint64_t key;
+    PackedRoom room;
+    bool visited;
+};
+
 struct Dungeon {
     vec2 size;
     vec2 spawnPosition;
     vec2 treasurePosition;
-    Room* rooms;
+    DungeonGeneration generation;
+    // DUNGEON_GENERATION_DENSE: every room, followed by a bitset of which rooms have been visited.
+    // Both are packed at the end of the Dungeon allocation (otherwise NULL).
+    PackedRoom* rooms;
+    uint64_t* visited;
+    // DUNGEON_GENERATION_HASHED: everything needed to regenerate any room, plus any rooms that have changed since.
+    uint64_t seed;
+    Sampler roomTypes;
+    Sampler items;
+    RoomTable changedRooms;
+    // Forks only (see Dungeon_Fork()): the dungeon whose rooms are shared, with 'changedRooms' holding
+    // every room the fork has changed since. Always the original dungeon, never another fork.
+    const Dungeon* base;
+    // Set when the dungeon lives in a mapped snapshot rather than its own allocation (see Snapshot_Load()):
+    void* mapping;
+    size_t mappingSize;
 };
 
-Dungeon* Dungeon_Create(const vec2 size);
+// Generate a new dungeon of 'size' rooms, drawing all randomness from 'rng'.
+Dungeon* Dungeon_Create(const vec2 size, Rng* rng);
+// Generate a new dungeon as described by 'params', drawing all randomness from 'rng'.
+Dungeon* Dungeon_CreateWithParams(const DungeonParams* params, Rng* rng);
+// Check whether the treasure can be reached from the spawn without fighting any enemies or getting across more than
+// 'crossablePits' pits. Only dungeons that store every room can be checked (not hashed dungeons or forks).
+bool Dungeon_IsSolvable(const Dungeon* self, int32_t crossablePits);
+// Draw just the type of every room of the dungeon Dungeon_CreateWithParams() would generate from 'rng', skipping
+// everything else about each room (items, trap damage, enemy health) - for scanning through many seeds cheaply.
+// Only dense generation without validation is supported. 'outTypes' receives one RoomType per room, indexed as in
+// Dungeon_RoomIndex(). 'rng' ends up in a different state than Dungeon_CreateWithParams() would leave it in.
+void Dungeon_GenerateLayout(
+    const DungeonParams* params,
+    Rng* rng,
+    uint8_t outTypes[],
+    vec2 outSpawnPosition,
+    vec2 outTreasurePosition
+);
+// Make a copy-on-write fork of 'parent' (which may itself be a fork) for exploring what-if branches.
+// The fork shares the parent's rooms and only stores the rooms it changes, so forking costs O(changes) rather
+// than O(rooms). The original dungeon must not change while any forks of it exist. Release with Dungeon_Destroy().
+Dungeon* Dungeon_Fork(const Dungeon* parent);
 void Dungeon_Destroy(Dungeon* self);
+// Fingerprint the current state of every room, e.g. to check that two runs ended up in the same place.
+// Dungeons only hash the same if they store their rooms the same way (so a fork never matches a copy).
+uint64_t Dungeon_Hash(const Dungeon* self);
+
+static inline int64_t Dungeon_RoomCount(const Dungeon *const self) {
+    return (int64_t)self->size[0] * self->size[1];
+}
+
+static inline int64_t Dungeon_RoomIndex(const Dungeon *const self, const vec2 position) {
+    return (int64_t)position[1] * self->size[0] + position[0];
+}
+
+// Check whether 'position' lies within the bounds of the dungeon.
+static inline bool Dungeon_Contains(const Dungeon *const self, const vec2 position) {
+    return position[0] >= 0 && position[0] < self->size[0]
+        && position[1] >= 0 && position[1] < self->size[1];
+}
+
+// Slow paths of the accessors below for rooms that aren't stored densely (hashed dungeons and forks):
+Room Dungeon_LookupRoom(const Dungeon* self, const vec2 position);
+void Dungeon_StoreRoom(Dungeon* self, const vec2 position, const Room* room);
+bool Dungeon_LookupVisited(const Dungeon* self, const vec2 position);
+void Dungeon_StoreVisited(Dungeon* self, const vec2 position);
+
+// Get the current state of the room at 'position'.
+static inline Room Dungeon_GetRoom(const Dungeon *const self, const vec2 position) {
+    if (self->rooms != NULL) {
+        return Room_Unpack(self->rooms[Dungeon_RoomIndex(self, position)]);
+    }
+    return Dungeon_LookupRoom(self, position);
+}
+
+// Get just the type of the room at 'position' - cheaper than Dungeon_GetRoom() for whole-map scans.
+static inline RoomType Dungeon_GetRoomType(const Dungeon *const self, const vec2 position) {
+    if (self->rooms != NULL) {
+        return PackedRoom_GetType(self->rooms[Dungeon_RoomIndex(self, position)]);
+    }
+    return Dungeon_LookupRoom(self, position).type;
+}
+
+// Overwrite the room at 'position', e.g. after it has been cleared.
+static inline void Dungeon_SetRoom(Dungeon *const self, const vec2 position, const Room *const room) {
+    if (self->rooms != NULL) {
+        self->rooms[Dungeon_RoomIndex(self, position)] = Room_Pack(room);
+    } else {
+        Dungeon_StoreRoom(self, position, room);
+    }
+}
+
+// Check whether the room at 'position' has been explored.
+static inline bool Dungeon_IsVisited(const Dungeon *const self, const vec2 position) {
+    if (self->visited != NULL) {
+        const int64_t index = Dungeon_RoomIndex(self, position);
+        return (self->visited[index / 64] >> (index % 64)) & 1;
+    }
+    return Dungeon_LookupVisited(self, position);
+}
 
-static inline int32_t Dungeon_RoomIndex(const Dungeon *const self, const vec2 position) {
-    return position[1] * self->size[0] + position[0];
+// Mark the room at 'position' as explored.
+static inline void Dungeon_MarkVisited(Dungeon *const self, const vec2 position) {
+    if (self->visited != NULL) {
+        const int64_t index = Dungeon_RoomIndex(self, position);
+        self->visited[index / 64] |= (uint64_t)1 << (index % 64);
+    } else {
+        Dungeon_StoreVisited(self, position);
+    }
 }
 
 #endif // __DUNGEON_H__
@@ -0,0 +1,271 @@
+#ifndef __GAME_H__
+#define __GAME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/player.h"
+#include "dungeon/rng.h"
+#include "dungeon/vec2.h"
+
+typedef struct GameState GameState;
+typedef struct GameEvent GameEvent;
+typedef struct StepResult StepResult;
+
+typedef enum Action {
+    // Anything that couldn't be parsed into a known action:
+    ACTION_NONE,
+    ACTION_EXIT,
+    ACTION_HELP,
+    ACTION_MAP,
+    ACTION_HEALTH,
+    ACTION_INVENTORY,
+    ACTION_FOOD,
+    ACTION_FORWARD,
+    ACTION_BACK,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_JUMP,
+    ACTION_SWING,
+    ACTION_RETURN,
+    ACTION_FIGHT,
+    ACTION_FLEE,
+    _ACTION_COUNT,
+} Action;
+
+static inline const char* Action_ToString(const Action self) {
+    switch (self) {
+        case ACTION_NONE: return "none";
+        case ACTION_EXIT: return "exit";
+        case ACTION_HELP: return "help";
+        case ACTION_MAP: return "map";
+        case ACTION_HEALTH: return "health";
+        case ACTION_INVENTORY: return "inventory";
+        case ACTION_FOOD: return "food";
+        case ACTION_FORWARD: return "forward";
+        case ACTION_BACK: return "back";
+        case ACTION_LEFT: return "left";
+        case ACTION_RIGHT: return "right";
+        case ACTION_JUMP: return "jump";
+        case ACTION_SWING: return "swing";
+        case ACTION_RETURN: return "return";
+        case ACTION_FIGHT: return "fight";
+        case ACTION_FLEE: return "flee";
+        case _ACTION_COUNT: return "[ERROR]";
+    }
+    return "[ERROR]";
+}
+
+// Parse a (case-insensitive) command string into an action, returning ACTION_NONE if unrecognised.
+// Besides each action's name, aliases and any unambiguous prefix are accepted (see tools/gen_action_table.c).
+Action Action_Parse(const char* input);
+// Hash of a lowercase command 'length' characters long, as used by the generated command table.
+static inline uint32_t Action_HashCommand(const char *const command, const int32_t length, const uint32_t seed) {
+    // FNV-1a, then a final avalanche so that the low bits depend on every character:
+    uint32_t hash = 2166136261u ^ seed;
+    for (int32_t i = 0; i < length; ++i) {
+        hash = (hash ^ (uint8_t)command[i]) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    return hash;
+}
+// Get the relative direction (as passed to Player_Move()) of a movement action, returning false if not a movement.
+bool Action_GetMovement(Action self, vec2 outDirection);
+
+// Which set of actions is currently available to the player.
+typedef enum Encounter {
+    // Common and movement actions:
+    ENCOUNTER_NONE,
+    // Common and pit actions:
+    ENCOUNTER_PIT,
+    // Common and combat actions:
+    ENCOUNTER_ENEMY,
+} Encounter;
+
+typedef enum GameStatus {
+    GAME_STATUS_PLAYING,
+    GAME_STATUS_WON,
+    GAME_STATUS_DIED,
+} GameStatus;
+
+static inline const char* GameStatus_ToString(const GameStatus self) {
+    switch (self) {
+        case GAME_STATUS_PLAYING: return "PLAYING";
+        case GAME_STATUS_WON: return "WON";
+        case GAME_STATUS_DIED: return "DIED";
+    }
+    return "[ERROR]";
+}
+
+typedef enum GameEventType {
+    // 'detail' is the Action that isn't valid right now:
+    GAME_EVENT_UNRECOGNISED,
+    // 'detail' is the current Encounter:
+    GAME_EVENT_HELP,
+    GAME_EVENT_MAP,
+    GAME_EVENT_HEALTH,
+    GAME_EVENT_INVENTORY,
+    GAME_EVENT_FOOD_EMPTY,
+    GAME_EVENT_FOOD_FULL,
+    // 'amount' is the HEALTH regained:
+    GAME_EVENT_FOOD_EATEN,
+    GAME_EVENT_WALL,
+    // 'detail' is the movement Action taken:
+    GAME_EVENT_MOVED,
+    // 'detail' is the RoomType of the room being entered:
+    GAME_EVENT_ROOM_ENTERED,
+    // 'detail' is the ItemType found:
+    GAME_EVENT_ITEM_FOUND,
+    // 'amount' is the damage taken:
+    GAME_EVENT_TRAP_TRIGGERED,
+    GAME_EVENT_TRAP_DESTROYED,
+    GAME_EVENT_PIT_JUMPED,
+    GAME_EVENT_PIT_FELL,
+    GAME_EVENT_PIT_SWUNG,
+    GAME_EVENT_PIT_SWING_FAILED,
+    GAME_EVENT_PIT_RETURNED,
+    // 'amount' is the damage dealt, 'detail' is true if a SWORD was used:
+    GAME_EVENT_ENEMY_HIT,
+    GAME_EVENT_ENEMY_DEFEATED,
+    // 'amount' is the damage taken:
+    GAME_EVENT_SHIELD_HIT,
+    GAME_EVENT_SHIELD_BROKEN,
+    // 'amount' is the damage taken:
+    GAME_EVENT_PLAYER_HIT,
+    // 'amount' is the damage taken (0 if evaded cleanly):
+    GAME_EVENT_FLED,
+    // 'amount' is the damage taken:
+    GAME_EVENT_FLEE_FAILED,
+    GAME_EVENT_TREASURE_FOUND,
+    GAME_EVENT_DIED,
+    _GAME_EVENT_TYPE_COUNT,
+} GameEventType;
+
+static inline const char* GameEventType_ToString(const GameEventType self) {
+    switch (self) {
+        case GAME_EVENT_UNRECOGNISED: return "UNRECOGNISED";
+        case GAME_EVENT_HELP: return "HELP";
+        case GAME_EVENT_MAP: return "MAP";
+        case GAME_EVENT_HEALTH: return "HEALTH";
+        case GAME_EVENT_INVENTORY: return "INVENTORY";
+        case GAME_EVENT_FOOD_EMPTY: return "FOOD_EMPTY";
+        case GAME_EVENT_FOOD_FULL: return "FOOD_FULL";
+        case GAME_EVENT_FOOD_EATEN: return "FOOD_EATEN";
+        case GAME_EVENT_WALL: return "WALL";
+        case GAME_EVENT_MOVED: return "MOVED";
+        case GAME_EVENT_ROOM_ENTERED: return "ROOM_ENTERED";
+        case GAME_EVENT_ITEM_FOUND: return "ITEM_FOUND";
+        case GAME_EVENT_TRAP_TRIGGERED: return "TRAP_TRIGGERED";
+        case GAME_EVENT_TRAP_DESTROYED: return "TRAP_DESTROYED";
+        case GAME_EVENT_PIT_JUMPED: return "PIT_JUMPED";
+        case GAME_EVENT_PIT_FELL: return "PIT_FELL";
+        case GAME_EVENT_PIT_SWUNG: return "PIT_SWUNG";
+        case GAME_EVENT_PIT_SWING_FAILED: return "PIT_SWING_FAILED";
+        case GAME_EVENT_PIT_RETURNED: return "PIT_RETURNED";
+        case GAME_EVENT_ENEMY_HIT: return "ENEMY_HIT";
+        case GAME_EVENT_ENEMY_DEFEATED: return "ENEMY_DEFEATED";
+        case GAME_EVENT_SHIELD_HIT: return "SHIELD_HIT";
+        case GAME_EVENT_SHIELD_BROKEN: return "SHIELD_BROKEN";
+        case GAME_EVENT_PLAYER_HIT: return "PLAYER_HIT";
+        case GAME_EVENT_FLED: return "FLED";
+        case GAME_EVENT_FLEE_FAILED: return "FLEE_FAILED";
+        case GAME_EVENT_TREASURE_FOUND: return "TREASURE_FOUND";
+        case GAME_EVENT_DIED: return "DIED";
+        case _GAME_EVENT_TYPE_COUNT: return "[ERROR]";
+    }
+    return "[ERROR]";
+}
+
+struct GameEvent {
+    GameEventType type;
+    int8_t amount;
+    uint8_t detail;
+};
+
+// No single step can currently produce more than ~5 events, so leave some headroom:
+#define GAME_MAX_EVENTS 8
+
+struct StepResult {
+    GameStatus status;
+    uint8_t eventCount;
+    GameEvent events[GAME_MAX_EVENTS];
+};
+
+// Every player starts out on (and can't heal beyond) this much HEALTH:
+#define GAME_PLAYER_MAX_HEALTH 20
+
+// Enough for everything a single step can touch (the room left, the room entered and the room cleared):
+#define GAME_MAX_DIRTY_ROOMS 8
+
+struct GameState {
+    Dungeon* dungeon;
+    Player player;
+    Rng rng;
+    Encounter encounter;
+    GameStatus status;
+    // Rooms whose contents, visited flag or occupant have changed since Game_ClearDirtyRooms(),
+    // so that front ends only need to redraw those cells:
+    struct {
+        uint8_t count;
+        // Set once more rooms have changed than fit, meaning everything needs redrawing:
+        bool overflowed;
+        vec2 positions[GAME_MAX_DIRTY_ROOMS];
+    } dirtyRooms;
+};
+
+// Initialise a new game in 'dungeon', placing the player at the spawn with the starting kit.
+// The game does not take ownership of 'dungeon', and continues drawing randomness from a copy of 'rng'.
+void Game_Init(GameState* self, Dungeon* dungeon, const Rng* rng);
+// Place a new player at 'spawnPosition' with full health and the starting kit, as Game_Init() does.
+void Game_InitPlayer(Player* player, const vec2 spawnPosition);
+// Copy 'parent' into 'outChild' to explore a branch of it, e.g. in a search. The child plays in a copy-on-write fork
+// of the parent's dungeon (see Dungeon_Fork()), which it owns - release it with Dungeon_Destroy(outChild->dungeon).
+void Game_Fork(const GameState* parent, GameState* outChild);
+// Fingerprint everything about the game that affects how it plays out from here (see Dungeon_Hash()).
+uint64_t Game_Hash(const GameState* self);
+// Chance (out of 100) that 'player' will successfully jump across a pit.
+int32_t Game_GetJumpSuccessPercentage(const Player* player);
+// Enter the spawn room - must be called once before the first Game_Step().
+StepResult Game_Start(GameState* self);
+// Report the player's health and the actions available, without entering the current room again (so nothing in it
+// happens twice) - used instead of Game_Start() to carry on a game already started, e.g. from Snapshot_Load().
+StepResult Game_Resume(GameState* self);
+// Apply a single action and report everything that happened as a result. Performs no I/O.
+StepResult Game_Step(GameState* self, Action action);
+
+// Record that the room at 'position' needs redrawing.
+static inline void Game_MarkDirty(GameState *const self, const vec2 position) {
+    if (self->dirtyRooms.overflowed || !Dungeon_Contains(self->dungeon, position)) {
+        return;
+    }
+    for (int32_t i = 0; i < self->dirtyRooms.count; ++i) {
+        if (Vec2_Equal(self->dirtyRooms.positions[i], position)) {
+            return;
+        }
+    }
+    if (self->dirtyRooms.count == GAME_MAX_DIRTY_ROOMS) {
+        self->dirtyRooms.overflowed = true;
+        return;
+    }
+    Vec2_Set(self->dirtyRooms.positions[self->dirtyRooms.count++], position);
+}
+
+// Forget about any changed rooms, e.g. once they have been redrawn.
+static inline void Game_ClearDirtyRooms(GameState *const self) {
+    self->dirtyRooms.count = 0;
+    self->dirtyRooms.overflowed = false;
+}
+
+static inline Room Game_GetCurrentRoom(const GameState *const self) {
+    return Dungeon_GetRoom(self->dungeon, self->player.position.current);
+}
+
+static inline void Game_SetCurrentRoom(GameState *const self, const Room *const room) {
+    Dungeon_SetRoom(self->dungeon, self->player.position.current, room);
+    Game_MarkDirty(self, self->player.position.current);
+}
+
+#endif // __GAME_H__
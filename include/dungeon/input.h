@@ -0,0 +1,43 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct InputReader InputReader;
+
+// Enough for thousands of piped commands per read():
+#define INPUT_BUFFER_SIZE 16384
+// Longest token that will be returned - anything longer is reported as INPUT_TOO_LONG:
+#define INPUT_MAX_TOKEN_LENGTH 31
+
+typedef enum InputStatus {
+    INPUT_TOKEN,
+    // The token was longer than INPUT_MAX_TOKEN_LENGTH, so only the start of it is returned:
+    INPUT_TOO_LONG,
+    // Input was closed (or failed), so there are no more tokens:
+    INPUT_END,
+} InputStatus;
+
+// Splits a file descriptor into whitespace-separated tokens, reading large chunks at a time
+// and handing out tokens in-place from its buffer rather than copying them.
+struct InputReader {
+    int32_t fd;
+    bool closed;
+    // Unread bytes are [start,end) of 'buffer' (plus room for a null-terminator after them):
+    int32_t start;
+    int32_t end;
+    char buffer[INPUT_BUFFER_SIZE + 1];
+    // Where the start of an overlong token is kept, as the rest of it has been thrown away:
+    char truncated[INPUT_MAX_TOKEN_LENGTH + 1];
+};
+
+void InputReader_Init(InputReader* self, int32_t fd);
+// Check whether the input is an interactive terminal (as opposed to a pipe or file).
+bool InputReader_IsInteractive(const InputReader* self);
+// Check whether another token can be returned without having to wait for more input.
+bool InputReader_HasBufferedToken(const InputReader* self);
+// Get the next token as a null-terminated string in 'outToken', which stays valid until the next call.
+InputStatus InputReader_Next(InputReader* self, const char** outToken);
+
+#endif // __INPUT_H__
@@ -0,0 +1,68 @@
+#ifndef __OUTPUT_H__
+#define __OUTPUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dungeon/game.h"
+#include "dungeon/render.h"
+#include "dungeon/text.h"
+
+typedef struct OutputSink OutputSink;
+
+typedef enum OutputMode {
+    // Prose for people (see text.h):
+    OUTPUT_TEXT,
+    // One JSON object per step:
+    OUTPUT_NDJSON,
+    // Fixed-size records (see OutputSink_StepResult()):
+    OUTPUT_BINARY,
+    // Nothing at all - no formatting work is done:
+    OUTPUT_NONE,
+    _OUTPUT_MODE_COUNT,
+} OutputMode;
+
+static inline const char* OutputMode_ToString(const OutputMode self) {
+    switch (self) {
+        case OUTPUT_TEXT: return "text";
+        case OUTPUT_NDJSON: return "ndjson";
+        case OUTPUT_BINARY: return "binary";
+        case OUTPUT_NONE: return "none";
+        case _OUTPUT_MODE_COUNT: return "[ERROR]";
+    }
+    return "[ERROR]";
+}
+
+// Identifies the start of a binary stream, followed by a single version byte:
+#define OUTPUT_BINARY_MAGIC "DGNE"
+#define OUTPUT_BINARY_VERSION 1
+
+// Where everything the game reports ends up, in whichever format was chosen at startup.
+// Output collects in 'buffer' until OutputSink_Flush() is called.
+struct OutputSink {
+    OutputMode mode;
+    RenderBuffer buffer;
+    // OUTPUT_TEXT only - how maps are drawn (see Text_AppendStepResult()):
+    TextMapCallback appendMap;
+    void* mapContext;
+};
+
+void OutputSink_Init(OutputSink* self, OutputMode mode);
+void OutputSink_Destroy(OutputSink* self);
+// Report the start of a game.
+void OutputSink_Welcome(OutputSink* self);
+// Report everything that happened in a step, where 'input' is the command that produced it.
+// OUTPUT_NDJSON writes a line like:
+//   {"status":"PLAYING","position":[3,4],"health":18,"events":[{"type":"MOVED","amount":0,"detail":7},...]}
+// OUTPUT_BINARY writes a record of: status, position x and y (int32 little-endian), health, event count,
+// then type, amount and detail for each event (all other fields are one byte each).
+void OutputSink_StepResult(OutputSink* self, const GameState* game, const StepResult* result, const char* input);
+// Ask for the next command (OUTPUT_TEXT only - 'interactive' is false when nobody is there to read the prompt).
+void OutputSink_Prompt(OutputSink* self, const GameState* game, bool interactive);
+// Report a command that was too long to be read, of which 'start' is the beginning.
+void OutputSink_InputTooLong(OutputSink* self, const char* start, int32_t maxLength);
+// Write out and clear everything collected so far, returning false on failure.
+bool OutputSink_Flush(OutputSink* self, FILE* file);
+
+#endif // __OUTPUT_H__
@@ -0,0 +1,19 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <stdint.h>
+
+// A single unit of work - 'worker' is in the range [0,threadCount) and is stable for the duration of the task,
+// so it can be used to index per-thread scratch data.
+typedef void (*ParallelTask)(void* context, int32_t index, int32_t worker);
+
+// Returns the number of logical processors available (always at least 1).
+int32_t Parallel_GetProcessorCount(void);
+// Resolve a requested thread count - 0 or less means one per logical processor.
+int32_t Parallel_ResolveThreadCount(int32_t threadCount);
+// Run 'task' for every index in [0,count) across 'threadCount' threads (see Parallel_ResolveThreadCount()),
+// returning once every task has completed. Tasks are handed out one index at a time,
+// so callers should batch small amounts of work into each index.
+void Parallel_For(int32_t count, int32_t threadCount, ParallelTask task, void* context);
+
+#endif // __PARALLEL_H__
@@ -0,0 +1,76 @@
+#ifndef __PATH_H__
+#define __PATH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/vec2.h"
+
+typedef struct DistanceField DistanceField;
+typedef struct DistanceBucket DistanceBucket;
+typedef struct DistanceSeed DistanceSeed;
+
+// Distance of rooms that can't reach any target (e.g. once every item has been picked up):
+#define DISTANCE_FIELD_UNREACHABLE INT32_MAX
+// Most it can cost to enter a single room:
+#define DISTANCE_FIELD_MAX_COST 64
+
+struct DistanceBucket {
+    int64_t* rooms;
+    int64_t count;
+    int64_t capacity;
+};
+
+struct DistanceSeed {
+    int64_t room;
+    int32_t distance;
+};
+
+// The cost of the cheapest path from every room to the nearest room of one type (e.g. the treasure), where each
+// step costs however much it does to enter the room stepped into. Built once with Dijkstra's algorithm, after which
+// looking up a room's distance, or which way to go from it, is O(1).
+// Rooms are indexed as in Dungeon_RoomIndex().
+struct DistanceField {
+    vec2 size;
+    RoomType target;
+    int32_t costs[_ROOM_TYPE_COUNT];
+    int32_t* distances;
+    // The type of every room as of the last update, to tell what has changed since:
+    uint8_t* types;
+    // Rooms waiting to be expanded, by distance. Every cost is below 'bucketCount', so everything queued is within
+    // that of the distance being expanded, and bucket 'distance % bucketCount' only ever holds a single distance:
+    DistanceBucket buckets[DISTANCE_FIELD_MAX_COST + 1];
+    int32_t bucketCount;
+    // Scratch space for updates:
+    DistanceSeed* seeds;
+    int64_t seedCount;
+    int64_t seedCapacity;
+};
+
+// Get the default cost of entering each type of room, where pits and enemies are worth going a little out of the
+// way to avoid.
+void DistanceField_GetDefaultCosts(int32_t outCosts[_ROOM_TYPE_COUNT]);
+// Build the distances from every room of 'dungeon' to the nearest room of type 'target', where entering a room of
+// type 't' costs 'costs[t]' (from 1 to DISTANCE_FIELD_MAX_COST). O(rooms).
+void DistanceField_Init(
+    DistanceField* self,
+    const Dungeon* dungeon,
+    RoomType target,
+    const int32_t costs[_ROOM_TYPE_COUNT]
+);
+void DistanceField_Destroy(DistanceField* self);
+// Catch up with any change to the room at 'position', e.g. after Room_Clear(). Only the distances that actually
+// depend on the room are worked out again, so clearing a room usually costs far less than rebuilding the field.
+// Rooms that haven't changed type are skipped, so this can be handed every room in GameState::dirtyRooms.
+void DistanceField_Update(DistanceField* self, const Dungeon* dungeon, const vec2 position);
+// Find the neighbour of 'position' to step into next on a cheapest path to the nearest target, returning false if
+// 'position' is a target or no target can be reached from it.
+bool DistanceField_GetNextStep(const DistanceField* self, const vec2 position, vec2 outPosition);
+
+// Get the cost of the cheapest path from 'position' to the nearest target (or DISTANCE_FIELD_UNREACHABLE).
+static inline int32_t DistanceField_Get(const DistanceField *const self, const vec2 position) {
+    return self->distances[(int64_t)position[1] * self->size[0] + position[0]];
+}
+
+#endif // __PATH_H__
@@ -0,0 +1,93 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Optional instrumentation of the hot paths, enabled by configuring with -DDUNGEON_PROFILE=ON.
+// Every thread records its own timings and counters, which are merged when the results are written out.
+// Without DUNGEON_PROFILE the PROFILE_* macros expand to nothing, so instrumentation costs nothing at all.
+
+// Timed regions of code:
+typedef enum ProfileZone {
+    PROFILE_ZONE_DUNGEON_CREATE,
+    PROFILE_ZONE_DUNGEON_VALIDATE,
+    PROFILE_ZONE_GAME_STEP,
+    // Game_Step() handlers, one per encounter (plus the actions that work anywhere):
+    PROFILE_ZONE_HANDLE_MOVEMENT,
+    PROFILE_ZONE_HANDLE_PIT,
+    PROFILE_ZONE_HANDLE_ENEMY,
+    PROFILE_ZONE_HANDLE_COMMON,
+    PROFILE_ZONE_ACTION_PARSE,
+    PROFILE_ZONE_RENDER_MAP,
+    _PROFILE_ZONE_COUNT,
+} ProfileZone;
+
+static inline const char* ProfileZone_ToString(const ProfileZone self) {
+    switch (self) {
+        case PROFILE_ZONE_DUNGEON_CREATE: return "dungeon_create";
+        case PROFILE_ZONE_DUNGEON_VALIDATE: return "dungeon_validate";
+        case PROFILE_ZONE_GAME_STEP: return "game_step";
+        case PROFILE_ZONE_HANDLE_MOVEMENT: return "handle_movement";
+        case PROFILE_ZONE_HANDLE_PIT: return "handle_pit";
+        case PROFILE_ZONE_HANDLE_ENEMY: return "handle_enemy";
+        case PROFILE_ZONE_HANDLE_COMMON: return "handle_common";
+        case PROFILE_ZONE_ACTION_PARSE: return "action_parse";
+        case PROFILE_ZONE_RENDER_MAP: return "render_map";
+        case _PROFILE_ZONE_COUNT: return "[ERROR]";
+    }
+    return "[ERROR]";
+}
+
+// Things that are counted rather than timed:
+typedef enum ProfileCounter {
+    PROFILE_COUNTER_RNG_DRAWS,
+    PROFILE_COUNTER_COMMANDS,
+    PROFILE_COUNTER_ROOMS_GENERATED,
+    _PROFILE_COUNTER_COUNT,
+} ProfileCounter;
+
+static inline const char* ProfileCounter_ToString(const ProfileCounter self) {
+    switch (self) {
+        case PROFILE_COUNTER_RNG_DRAWS: return "rng_draws";
+        case PROFILE_COUNTER_COMMANDS: return "commands";
+        case PROFILE_COUNTER_ROOMS_GENERATED: return "rooms_generated";
+        case _PROFILE_COUNTER_COUNT: return "[ERROR]";
+    }
+    return "[ERROR]";
+}
+
+// Each thread keeps at most this many individual zone timings for the trace (the summary covers everything):
+#define PROFILE_MAX_EVENTS (1 << 20)
+
+#if defined(DUNGEON_PROFILE)
+
+// Nanoseconds since an arbitrary (but fixed) point.
+uint64_t Profile_Now(void);
+// Record that 'zone' ran from 'start' (from Profile_Now()) until now.
+void Profile_Record(ProfileZone zone, uint64_t start);
+void Profile_Count(ProfileCounter counter, int64_t amount);
+
+// Time everything from here to the matching PROFILE_END() in the same scope:
+#define PROFILE_BEGIN(zone) const uint64_t _profileStart_##zone = Profile_Now()
+#define PROFILE_END(zone) Profile_Record((zone), _profileStart_##zone)
+#define PROFILE_COUNT(counter, amount) Profile_Count((counter), (amount))
+
+#else
+
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+
+#endif
+
+// Whether this build was compiled with instrumentation (the functions below do nothing otherwise).
+bool Profile_IsEnabled(void);
+// Write a table of time spent in each zone and every counter, across all threads.
+void Profile_WriteSummary(FILE* file);
+// Write every recorded zone as Chrome trace JSON (for chrome://tracing or https://ui.perfetto.dev),
+// returning false on failure.
+bool Profile_WriteTrace(const char* path);
+
+#endif // __PROFILE_H__
@@ -0,0 +1,60 @@
+#ifndef __REGION_H__
+#define __REGION_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/vec2.h"
+
+typedef struct RegionStats RegionStats;
+typedef struct RegionChange RegionChange;
+
+// Layers of RegionStats - one per RoomType, then one for visited rooms:
+#define REGION_LAYER_VISITED _ROOM_TYPE_COUNT
+#define REGION_LAYER_COUNT (_ROOM_TYPE_COUNT + 1)
+// Changes are folded into the tables once this many have built up:
+#define REGION_MAX_CHANGES 64
+
+struct RegionChange {
+    int32_t x;
+    int32_t y;
+    uint8_t layer;
+    int8_t delta;
+};
+
+// Counts of each room type (and of visited rooms) over any rectangle of a dungeon.
+// Each layer is a summed-area table of (width + 1) * (height + 1) counts, where entry (x, y) is the count over the
+// rooms in [0, x) * [0, y). Updating a table for a single room means touching everything below and to the right of
+// it, so changes are kept in a short list that queries add on top, and only folded into the tables (from the
+// highest row changed down) once REGION_MAX_CHANGES have built up.
+// So a query costs four table lookups plus a scan of up to REGION_MAX_CHANGES pending changes, and as a flush
+// rebuilds each changed layer from its highest changed row (about every 20 room changes), an update costs around
+// O(rooms / 20) amortised - far less than rebuilding, but not O(1).
+struct RegionStats {
+    vec2 size;
+    int32_t* tables[REGION_LAYER_COUNT];
+    // Every room as of the last update (its RoomType, with the top bit set once visited), to tell what has changed:
+    uint8_t* rooms;
+    RegionChange changes[REGION_MAX_CHANGES];
+    int32_t changeCount;
+    // Highest row of each layer that 'changes' touch (or the height of the dungeon if none):
+    int32_t firstChangedRows[REGION_LAYER_COUNT];
+};
+
+// Count every room of 'dungeon' by type and whether it's been visited. O(rooms).
+void RegionStats_Init(RegionStats* self, const Dungeon* dungeon);
+void RegionStats_Destroy(RegionStats* self);
+// Catch up with any change to the room at 'position' - to its type (e.g. after Room_Clear()) or to whether it's
+// been visited. Rooms that haven't changed are skipped, so this can be handed every room in GameState::dirtyRooms.
+void RegionStats_Update(RegionStats* self, const Dungeon* dungeon, const vec2 position);
+// Count the rooms of 'type' in the rectangle from 'min' to 'max' (inclusive), which must lie within the dungeon.
+int32_t RegionStats_CountRooms(const RegionStats* self, RoomType type, const vec2 min, const vec2 max);
+// Count the visited rooms in the rectangle from 'min' to 'max' (inclusive), which must lie within the dungeon.
+int32_t RegionStats_CountVisited(const RegionStats* self, const vec2 min, const vec2 max);
+// Count the rooms of 'type' at most 'radius' rooms from 'center' along each axis (a square clipped to the dungeon).
+int32_t RegionStats_CountRoomsNear(const RegionStats* self, RoomType type, const vec2 center, int32_t radius);
+// Count the visited rooms at most 'radius' rooms from 'center' along each axis (a square clipped to the dungeon).
+int32_t RegionStats_CountVisitedNear(const RegionStats* self, const vec2 center, int32_t radius);
+
+#endif // __REGION_H__
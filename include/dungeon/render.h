@@ -0,0 +1,74 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/player.h"
+
+typedef struct RenderBuffer RenderBuffer;
+typedef struct RenderWindow RenderWindow;
+
+// Growable text buffer that a whole frame is built into before being written out in one go.
+// Clearing keeps the allocation, so a single buffer can be reused for every frame.
+struct RenderBuffer {
+    char* data;
+    size_t length;
+    size_t capacity;
+};
+
+void RenderBuffer_Init(RenderBuffer* self);
+void RenderBuffer_Destroy(RenderBuffer* self);
+void RenderBuffer_Clear(RenderBuffer* self);
+// Extend the buffer by 'size' bytes, returning where they start so they can be filled in directly.
+char* RenderBuffer_Extend(RenderBuffer* self, size_t size);
+void RenderBuffer_Append(RenderBuffer* self, const char* data, size_t size);
+void RenderBuffer_AppendFormat(RenderBuffer* self, const char* format, ...);
+// Write the buffer's contents to 'file' with a single fwrite(), returning false on failure.
+bool RenderBuffer_Write(const RenderBuffer* self, FILE* file);
+// Write the buffer's contents to a new file at 'path' (e.g. for offline inspection), returning false on failure.
+bool RenderBuffer_WriteToFile(const RenderBuffer* self, const char* path);
+
+// The rectangle of rooms [min,max) that a map is drawn for.
+struct RenderWindow {
+    vec2 min;
+    vec2 max;
+};
+
+// A window covering the whole dungeon.
+RenderWindow RenderWindow_Full(const Dungeon* dungeon);
+// A window of up to (2 * radius + 1) rooms square, centred on the player where it fits within the dungeon.
+RenderWindow RenderWindow_AroundPlayer(const Dungeon* dungeon, const Player* player, int32_t radius);
+// Number of lines Render_MapGrid() produces for 'window'.
+int32_t RenderWindow_GetLineCount(const RenderWindow* self);
+
+// Append the map legend, the whole map and the player's current position/orientation to 'self'.
+// If 'onlyVisited' is set, rooms that haven't been explored yet are hidden.
+void Render_Map(RenderBuffer* self, const Dungeon* dungeon, const Player* player, bool onlyVisited);
+void Render_MapLegend(RenderBuffer* self);
+// Append the rooms in 'window', surrounded by a border and rulers.
+void Render_MapGrid(
+    RenderBuffer* self,
+    const Dungeon* dungeon,
+    const Player* player,
+    bool onlyVisited,
+    const RenderWindow* window
+);
+void Render_MapPosition(RenderBuffer* self, const Player* player);
+// Append ANSI escape codes that redraw just the rooms at 'positions' (ignoring any outside 'window'),
+// for a grid that Render_MapGrid() previously drew starting at terminal line 'screenLine' (1-based).
+// The cursor is restored afterwards, so this can be interleaved with regular output.
+void Render_MapCells(
+    RenderBuffer* self,
+    const Dungeon* dungeon,
+    const Player* player,
+    bool onlyVisited,
+    const RenderWindow* window,
+    int32_t screenLine,
+    const vec2 positions[],
+    int32_t count
+);
+
+#endif // __RENDER_H__
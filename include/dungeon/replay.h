@@ -0,0 +1,96 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/render.h"
+
+typedef struct ReplaySetup ReplaySetup;
+typedef struct ReplayWriter ReplayWriter;
+typedef struct ReplayReader ReplayReader;
+typedef struct ReplayStats ReplayStats;
+
+// Identifies a replay log, followed by a single version byte:
+#define REPLAY_MAGIC "DGNR"
+#define REPLAY_VERSION 1
+// Logs are read and written this much at a time:
+#define REPLAY_BUFFER_SIZE 65536
+
+// A replay log is any number of games back to back, each stored as unsigned LEB128 varints:
+//   1, seed, stream, width, height, generation, each of roomDistribution[], each of itemDistribution[]
+//   (action + 1) for every action played
+//   0, then the Game_Hash() of the final state
+// Logs can simply be concatenated, e.g. to collect games from many sessions into one file
+// (the header may appear again wherever a game could start).
+
+typedef enum ReplayStatus {
+    REPLAY_OK,
+    // There's nothing more to read - no more games, or no more actions in this game:
+    REPLAY_END,
+    // The log is truncated or wasn't written by a compatible build:
+    REPLAY_CORRUPT,
+} ReplayStatus;
+
+// Everything needed to recreate a game from scratch.
+struct ReplaySetup {
+    uint64_t seed;
+    uint64_t stream;
+    DungeonParams params;
+};
+
+// Create the dungeon for 'self' and start 'outGame' in it, exactly as it was when recorded.
+// The game does not take ownership of the dungeon - release it with Dungeon_Destroy().
+Dungeon* ReplaySetup_CreateGame(const ReplaySetup* self, GameState* outGame);
+
+struct ReplayWriter {
+    FILE* file;
+    RenderBuffer buffer;
+};
+
+// Start a new log at 'path', returning false on failure.
+bool ReplayWriter_Open(ReplayWriter* self, const char* path);
+void ReplayWriter_BeginGame(ReplayWriter* self, const ReplaySetup* setup);
+void ReplayWriter_Action(ReplayWriter* self, Action action);
+void ReplayWriter_EndGame(ReplayWriter* self, const GameState* game);
+// Write out everything so far, e.g. so that the log is complete up to here if the process dies.
+bool ReplayWriter_Flush(ReplayWriter* self);
+// Flush and close the log, returning false if anything failed to write.
+bool ReplayWriter_Close(ReplayWriter* self);
+
+struct ReplayReader {
+    FILE* file;
+    bool failed;
+    // Unread bytes are [start,end) of 'buffer':
+    int32_t start;
+    int32_t end;
+    uint8_t buffer[REPLAY_BUFFER_SIZE];
+};
+
+// Open the log at 'path' ("-" for stdin), returning false if it can't be read or isn't a replay log.
+// Logs are streamed, so they can be any size.
+bool ReplayReader_Open(ReplayReader* self, const char* path);
+void ReplayReader_Close(ReplayReader* self);
+// Read the setup of the next game, returning REPLAY_END once there are no more.
+ReplayStatus ReplayReader_NextGame(ReplayReader* self, ReplaySetup* outSetup);
+// Read the next action of the current game, returning REPLAY_END (and the recorded Game_Hash()) once it's over.
+ReplayStatus ReplayReader_NextAction(ReplayReader* self, Action* outAction, uint64_t* outHash);
+
+struct ReplayStats {
+    int64_t games;
+    int64_t actions;
+    // Games that didn't end in the state they were recorded in:
+    int64_t mismatches;
+    // Index of the first game that didn't match (or -1):
+    int64_t firstMismatch;
+};
+
+// Replay every remaining game in 'reader' headless, checking that each ends in the state it was recorded in.
+// Results are added to 'stats', which should start zeroed (with 'firstMismatch' as -1).
+// Returns REPLAY_CORRUPT if the log couldn't be read in full (anything replayed so far is still counted).
+ReplayStatus Replay_Run(ReplayReader* reader, ReplayStats* stats);
+
+#endif // __REPLAY_H__
@@ -0,0 +1,53 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stdint.h>
+
+#include "dungeon/profile.h"
+
+typedef struct Rng Rng;
+
+// PCG32 (XSH-RR) random number generator - see https://www.pcg-random.org.
+// Each Rng owns its state, so separate games/threads should each use their own.
+struct Rng {
+    uint64_t state;
+    // Must be odd - selects which of the 2^63 independent streams this generator produces:
+    uint64_t increment;
+};
+
+// Seed 'self' so that the same 'seed' and 'stream' always produce the same sequence.
+// Different 'stream' values with the same 'seed' produce independent sequences.
+void Rng_Seed(Rng* self, uint64_t seed, uint64_t stream);
+// Fill 'values' with 'count' random uint32_t's.
+void Rng_Fill(Rng* self, uint32_t values[], int32_t count);
+
+// Stateless 64-bit mixing function (the SplitMix64 finaliser), useful for deriving
+// well-distributed seeds from counters or coordinates.
+static inline uint64_t Rng_Hash64(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Fold 'value' into a running 'hash', e.g. to fingerprint a whole struct field by field.
+static inline uint64_t Rng_HashCombine(const uint64_t hash, const uint64_t value) {
+    return Rng_Hash64(hash ^ Rng_Hash64(value));
+}
+
+// Generate a uniformly distributed random uint32_t.
+static inline uint32_t Rng_Next(Rng *const self) {
+    PROFILE_COUNT(PROFILE_COUNTER_RNG_DRAWS, 1);
+    const uint64_t state = self->state;
+    self->state = state * 6364136223846793005ULL + self->increment;
+    const uint32_t xorShifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+    const uint32_t rotation = (uint32_t)(state >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+
+// Generate a uniformly distributed random uint64_t.
+static inline uint64_t Rng_Next64(Rng *const self) {
+    const uint64_t high = Rng_Next(self);
+    return (high << 32) | Rng_Next(self);
+}
+
+#endif // __RNG_H__
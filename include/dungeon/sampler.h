@@ -0,0 +1,35 @@
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include <stdint.h>
+
+#include "dungeon/rng.h"
+
+typedef struct Sampler Sampler;
+
+// Enough for any of the enum-indexed tables in the game:
+#define SAMPLER_MAX_COUNT 32
+
+// Weighted random index sampler using Walker/Vose alias tables:
+// built once in O(n), then each sample is O(1) and costs a single Rng draw.
+struct Sampler {
+    int32_t count;
+    // Probability (scaled to 2^32) of keeping each column rather than taking its alias:
+    uint32_t threshold[SAMPLER_MAX_COUNT];
+    uint8_t alias[SAMPLER_MAX_COUNT];
+};
+
+// Build a sampler over 'count' entries, where each index is chosen with probability weights[i] / sum(weights).
+// Weights must be non-negative and add up to more than 0.
+void Sampler_Init(Sampler* self, int32_t count, const int32_t weights[]);
+
+// Draw a random index in the range [0,count).
+static inline int32_t Sampler_Sample(const Sampler *const self, Rng *const rng) {
+    // The high half of the product picks a column uniformly, and the low half is
+    // (almost) uniform within that column, so one draw covers both decisions:
+    const uint64_t scaled = (uint64_t)Rng_Next(rng) * (uint32_t)self->count;
+    const int32_t column = (int32_t)(scaled >> 32);
+    return (uint32_t)scaled < self->threshold[column] ? column : self->alias[column];
+}
+
+#endif // __SAMPLER_H__
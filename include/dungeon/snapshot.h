@@ -0,0 +1,60 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/player.h"
+#include "dungeon/rng.h"
+
+typedef struct SnapshotHeader SnapshotHeader;
+
+// Identifies a snapshot file - bump the version whenever the layout of anything saved changes:
+#define SNAPSHOT_MAGIC "DGNS"
+#define SNAPSHOT_VERSION 2
+
+// Snapshots store the Dungeon allocation exactly as it is in memory, so that loading one is just mapping the file.
+// A file is laid out as:
+//   SnapshotHeader
+//   Dungeon (with pointers cleared), followed by its dense rooms and visited bitset - at 'dungeonOffset'
+//   Dungeon::changedRooms entries (DUNGEON_GENERATION_HASHED only) - at 'changedRoomsOffset'
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    // Structs are saved as-is, so they can only be loaded by a build that lays them out the same way:
+    uint32_t headerSize;
+    uint32_t dungeonSize;
+    uint32_t playerSize;
+    uint32_t scalarSize;
+    uint32_t byteOrder;
+    uint32_t reserved;
+    // Everything else about the GameState, so that a game picks up exactly where it was saved
+    // (only games still being played are saved):
+    Player player;
+    Rng rng;
+    uint32_t encounter;
+    uint32_t status;
+    // Where the Dungeon starts in the file, and how many bytes it covers (including anything packed after it):
+    uint64_t dungeonOffset;
+    uint64_t dungeonLength;
+    // Where Dungeon::rooms and Dungeon::visited start, relative to the Dungeon (0 when not stored densely):
+    uint64_t roomsOffset;
+    uint64_t visitedOffset;
+    // Where the entries of Dungeon::changedRooms start in the file (0 when there are none):
+    uint64_t changedRoomsOffset;
+};
+
+// Save 'game' (which must still be playing) and its dungeon to the file at 'path', returning false on failure.
+bool Snapshot_Save(const char* path, const GameState* game);
+// Load a game saved by Snapshot_Save() into 'outGame', returning its dungeon - continue it with Game_Resume().
+// The file is mapped copy-on-write and the dungeon is used in place, so nothing is generated or copied and changes
+// are never written back - but every stored room is still checked, so that a bad file can't index out of bounds.
+// Returns NULL if the file can't be read or isn't a valid, compatible snapshot. Release with Dungeon_Destroy().
+Dungeon* Snapshot_Load(const char* path, GameState* outGame);
+// Release a mapping made by Snapshot_Load() - only called by Dungeon_Destroy().
+void Snapshot_Unmap(void* mapping, size_t size);
+
+#endif // __SNAPSHOT_H__
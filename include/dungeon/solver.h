@@ -0,0 +1,57 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include <stdint.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/player.h"
+
+typedef struct Solver Solver;
+typedef struct SolverEntry SolverEntry;
+
+// Largest states covered by the solver's tables - anything beyond these can't be solved:
+#define SOLVER_MAX_HEALTH 63
+#define SOLVER_MAX_ENEMY_HEALTH 15
+#define SOLVER_MAX_ENEMY_DAMAGE 8
+// Carrying more of these than the tables cover is solved as if carrying exactly this many:
+#define SOLVER_MAX_FOOD 15
+#define SOLVER_MAX_SHIELDS 7
+// Pit jumps get harder with every item carried, and are impossible well before this many:
+#define SOLVER_MAX_ITEMS 31
+
+// The optimal action in an encounter, and the chance of each outcome when playing optimally from then on.
+struct SolverEntry {
+    // Getting past the encounter alive - defeating the enemy or crossing the pit:
+    float win;
+    // Getting out of the encounter alive by going back the way you came:
+    float retreat;
+    // Everything else is dying.
+    uint8_t action;
+};
+
+// Exact expectimax solutions of the enemy and pit encounters, using the same odds as Game_Step().
+// Every reachable state is solved up-front, so looking up the best action is O(1).
+// The rest of the dungeon is out of scope, so encounters are solved as if they were the whole game:
+// each state maximises (win + retreatValue * retreat).
+struct Solver {
+    int8_t maxHealth;
+    float retreatValue;
+    // Indexed by Solver_EnemyIndex():
+    SolverEntry* enemy;
+    // Indexed by Solver_PitIndex():
+    SolverEntry* pit;
+};
+
+// Solve every encounter for a player with 'maxHealth', valuing a retreat at 'retreatValue' (0 to 1) of a win.
+// The tables are filled across 'threadCount' threads (see Parallel_ResolveThreadCount()).
+void Solver_Init(Solver* self, int8_t maxHealth, float retreatValue, int32_t threadCount);
+void Solver_Destroy(Solver* self);
+// Look up the solution for 'player' fighting the enemy in 'room'.
+SolverEntry Solver_SolveEnemy(const Solver* self, const Player* player, const Room* room);
+// Look up the solution for 'player' standing at the edge of a pit.
+SolverEntry Solver_SolvePit(const Solver* self, const Player* player);
+// Choose the optimal action for the current encounter, or ACTION_NONE if there isn't one.
+Action Solver_ChooseAction(const Solver* self, const GameState* game);
+
+#endif // __SOLVER_H__
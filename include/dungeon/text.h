@@ -0,0 +1,29 @@
+#ifndef __TEXT_H__
+#define __TEXT_H__
+
+#include <stdbool.h>
+
+#include "dungeon/game.h"
+#include "dungeon/render.h"
+
+// Called whenever an event wants the map shown, so that front ends can choose how it is drawn.
+typedef void (*TextMapCallback)(void* context, RenderBuffer* buffer, const GameState* game, bool onlyVisited);
+
+// Append the introduction shown when a new game starts.
+void Text_AppendWelcome(RenderBuffer* self);
+// Append a description of every event in 'result', where 'input' is the command that produced it.
+// Maps are drawn by 'appendMap' (passing it 'context'), or in full with Render_Map() if NULL.
+void Text_AppendStepResult(
+    RenderBuffer* self,
+    const GameState* game,
+    const StepResult* result,
+    const char* input,
+    TextMapCallback appendMap,
+    void* context
+);
+// Append the state of any ongoing fight (nothing if not in combat).
+void Text_AppendStatus(RenderBuffer* self, const GameState* game);
+// Append the prompt for the next command (including the status above).
+void Text_AppendPrompt(RenderBuffer* self, const GameState* game);
+
+#endif // __TEXT_H__
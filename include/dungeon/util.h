@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "dungeon/rng.h"
+#include "dungeon/vec2.h"
+
 // Return the greater of two values.
 #define Max(a, b) ((a) > (b) ? (a) : (b))
 // Return the lesser of two values.
@@ -11,17 +14,32 @@
 // Clamp value 'x' between 'min' and 'max'.
 #define Clamp(x, min, max) Max((min), Min((max), (x)))
 
-// Generates a random float in the range of [0,1].
-float Randf32(void);
+// Generates a random float in the range of [0,1).
+float Randf32(Rng* rng);
 // Generates a random float in the range of [min,max].
-float RandRangef32(float min, float max);
+float RandRangef32(Rng* rng, float min, float max);
 // Generates a random int32_t in the range of [min,max-1].
-int32_t RandRangei32(int32_t minInclusive, int32_t maxExclusive);
+int32_t RandRangei32(Rng* rng, int32_t minInclusive, int32_t maxExclusive);
+// Generates a random int64_t in the range of [min,max-1].
+int64_t RandRangei64(Rng* rng, int64_t minInclusive, int64_t maxExclusive);
 // Generates a random int32_t index into an array of 'weightCount' size, given 'weights' distribution of probabilities.
 // 'totalWeight' is the total sum of all values in 'weights' - if 0 or less, it will be calculated automatically.
-int32_t RandIndex(int32_t weightCount, const int32_t weights[], int32_t totalWeight);
+// This is O(n) per call - when sampling the same weights repeatedly, build a Sampler (see sampler.h) instead.
+int32_t RandIndex(Rng* rng, int32_t weightCount, const int32_t weights[], int32_t totalWeight);
+
+// Returns the current time in seconds, suitable for measuring elapsed time.
+// Reads a monotonic clock (QueryPerformanceCounter() on Windows, otherwise CLOCK_MONOTONIC or C23's TIME_MONOTONIC),
+// so intervals aren't thrown off by the system clock being changed. Falls back to wall-clock time without one.
+double Time_GetSeconds(void);
 
 int32_t String_Compare_IgnoreCase(int32_t maxSize, const char a[], const char b[]);
 #define String_CompareLiteral_IgnoreCase(literal, str) String_Compare_IgnoreCase(sizeof(literal), literal, str)
+// Parse a whole unsigned decimal number, e.g. a seed - rejecting empty strings, signs and anything trailing.
+bool String_ParseUint64(const char* value, uint64_t* outValue);
+// Parse a dungeon size like '20x10', where each side is from 1 to VEC2_SCALAR_MAX.
+bool String_ParseSize(const char* value, vec2 outSize);
+// Parse up to 'maxCount' comma-separated weights (0 to INT16_MAX, not all 0) into 'weights', e.g. '50,25,10'.
+// Returns how many were parsed, or 0 if 'value' is invalid.
+int32_t String_ParseWeights(const char* value, int32_t maxCount, int32_t weights[]);
 
 #endif // __UTIL_H__
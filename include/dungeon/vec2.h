@@ -4,15 +4,24 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-typedef int8_t vec2[2];
+#if defined(DUNGEON_WIDE_COORDS)
+// Wide coordinates allow for dungeons with millions of rooms per side:
+typedef int32_t vec2_scalar;
+#define VEC2_SCALAR_MAX INT32_MAX
+#else
+typedef int8_t vec2_scalar;
+#define VEC2_SCALAR_MAX INT8_MAX
+#endif
 
-// Copy int8_t[2] value from 'src' to 'dest'.
+typedef vec2_scalar vec2[2];
+
+// Copy vec2 value from 'src' to 'dest'.
 static inline void Vec2_Set(vec2 dest, const vec2 src) {
     dest[0] = src[0];
     dest[1] = src[1];
 }
 
-// Check if 2 int8_t[2] are equal.
+// Check if 2 vec2 are equal.
 static inline bool Vec2_Equal(const vec2 a, const vec2 b) {
     return a[0] == b[0] && a[1] == b[1];
 }
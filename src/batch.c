@@ -0,0 +1,474 @@
+#include "dungeon/batch.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/player.h"
+#include "dungeon/util.h"
+
+// Every array starts on its own cache line (which also suits any vector width):
+const size_t gameBatchAlignment = 64;
+
+// What GameBatch_Step() needs to do for each game:
+typedef enum GameBatchMove {
+    // The game is over, so there is nothing to do:
+    GAME_BATCH_MOVE_FINISHED,
+    // Moving into a wall, or an action that is only reported (or isn't available right now), which changes nothing:
+    GAME_BATCH_MOVE_NOTHING,
+    // Anything other than a plain movement that changes the game, resolved by Game_Step():
+    GAME_BATCH_MOVE_STEP,
+    // A movement into another room, which is resolved here unless it needs Game_Step() after all:
+    GAME_BATCH_MOVE_ROOM,
+} GameBatchMove;
+
+static size_t GameBatch_Layout(GameBatch* self, uintptr_t base);
+static void* GameBatch_Take(uintptr_t base, size_t* offset, size_t elementSize, int32_t count);
+static void GameBatch_StepGame(GameBatch* self, int32_t index, Action action);
+
+static void GameBatch_PlanMoves(
+    int32_t count,
+    const vec2 size,
+    const Action* restrict actions,
+    const vec2_scalar* restrict positionX,
+    const vec2_scalar* restrict positionY,
+    const vec2_scalar* restrict previousX,
+    const vec2_scalar* restrict previousY,
+    const uint8_t* restrict encounter,
+    const uint8_t* restrict status,
+    vec2_scalar* restrict nextX,
+    vec2_scalar* restrict nextY,
+    uint8_t* restrict moves
+);
+static void GameBatch_ApplyMoves(
+    int32_t count,
+    const uint8_t* restrict moves,
+    const vec2_scalar* restrict nextX,
+    const vec2_scalar* restrict nextY,
+    vec2_scalar* restrict positionX,
+    vec2_scalar* restrict positionY,
+    vec2_scalar* restrict previousX,
+    vec2_scalar* restrict previousY
+);
+static void GameBatch_ApplyHealth(
+    int32_t count,
+    const int8_t* restrict amounts,
+    const int8_t* restrict maxHealth,
+    int8_t* restrict health,
+    uint8_t* restrict status
+);
+static void GameBatch_ResetPlayers(GameBatch* self, const Player* start);
+static void GameBatch_ResetArray(
+    int32_t count,
+    const uint8_t* restrict reset,
+    const vec2_scalar* restrict source,
+    vec2_scalar offset,
+    vec2_scalar* restrict destination
+);
+static void GameBatch_ResetBytes(int32_t count, const uint8_t* restrict reset, uint8_t value, uint8_t* restrict bytes);
+
+void GameBatch_Init(
+    GameBatch *const self,
+    const int32_t count,
+    const DungeonParams *const params,
+    const uint64_t seed
+) {
+    assert(self != NULL);
+    assert(count > 0);
+    assert(params != NULL);
+
+    *self = (GameBatch) {
+        .count = count,
+        .params = *params,
+        .seed = seed,
+    };
+    // Measure everything up-front, then carve it all out of one allocation:
+    const size_t size = GameBatch_Layout(self, 0);
+    self->memory = calloc(1, size + gameBatchAlignment);
+    assert(self->memory != NULL);
+    GameBatch_Layout(self, ((uintptr_t)self->memory + gameBatchAlignment - 1) & ~(uintptr_t)(gameBatchAlignment - 1));
+
+    // Every slot starts out finished (and without a dungeon), so this starts a game in all of them:
+    memset(self->status, GAME_STATUS_DIED, sizeof(self->status[0]) * (size_t)count);
+    const int32_t _result = GameBatch_Reset(self);
+    assert(_result == count);
+    (void)_result;
+}
+
+void GameBatch_Destroy(GameBatch *const self) {
+    assert(self != NULL);
+    for (int32_t i = 0; i < self->count; ++i) {
+        if (self->dungeons[i] != NULL) {
+            Dungeon_Destroy(self->dungeons[i]);
+        }
+    }
+    free(self->memory);
+    *self = (GameBatch) { 0 };
+}
+
+int32_t GameBatch_Reset(GameBatch *const self) {
+    assert(self != NULL);
+
+    // Most steps don't finish any games at all, so check for that first:
+    const uint8_t *const status = self->status;
+    int32_t finished = 0;
+    for (int32_t i = 0; i < self->count; ++i) {
+        finished += status[i] != GAME_STATUS_PLAYING;
+    }
+    if (finished == 0) {
+        return 0;
+    }
+
+    // Dungeons have to be generated one at a time, noting the spawn of each (and which games were reset):
+    for (int32_t i = 0; i < self->count; ++i) {
+        self->moves[i] = false;
+        if (status[i] == GAME_STATUS_PLAYING) {
+            continue;
+        }
+        if (self->dungeons[i] != NULL) {
+            Dungeon_Destroy(self->dungeons[i]);
+        }
+
+        Rng rng;
+        Rng_Seed(&rng, Rng_HashCombine(self->seed, (uint64_t)self->episodes[i]), (uint64_t)i);
+        self->episodes[i] += 1;
+        Dungeon *const dungeon = Dungeon_CreateWithParams(&self->params, &rng);
+        self->dungeons[i] = dungeon;
+        // As Game_Init(), the game carries on drawing from where generation left off:
+        self->rngs[i] = rng;
+
+        // Entering the spawn room (as Game_Start() does) only marks it as visited:
+        assert(Dungeon_GetRoomType(dungeon, dungeon->spawnPosition) == ROOM_SPAWN);
+        Dungeon_MarkVisited(dungeon, dungeon->spawnPosition);
+        self->nextX[i] = dungeon->spawnPosition[0];
+        self->nextY[i] = dungeon->spawnPosition[1];
+        self->moves[i] = true;
+    }
+
+    // Then set up every new player at once:
+    Player start;
+    Game_InitPlayer(&start, (vec2) { 0, 0 });
+    GameBatch_ResetPlayers(self, &start);
+    return finished;
+}
+
+void GameBatch_Step(GameBatch *const self, const Action actions[]) {
+    assert(self != NULL);
+    assert(actions != NULL);
+
+    GameBatch_PlanMoves(
+        self->count,
+        self->params.size,
+        actions,
+        self->positionX,
+        self->positionY,
+        self->previousX,
+        self->previousY,
+        self->encounter,
+        self->status,
+        self->nextX,
+        self->nextY,
+        self->moves
+    );
+
+    // Anything that depends on the contents of a room has to be resolved game by game. Gather those games up-front
+    // without branching, as which games they are is as unpredictable as the actions given. First, the moves
+    // (which still count as GAME_BATCH_MOVE_ROOM for GameBatch_ApplyMoves() once they're resolved):
+    int32_t *const pending = self->pending;
+    int32_t pendingCount = 0;
+    for (int32_t i = 0; i < self->count; ++i) {
+        pending[pendingCount] = i;
+        pendingCount += self->moves[i] == GAME_BATCH_MOVE_ROOM;
+    }
+    for (int32_t j = 0; j < pendingCount; ++j) {
+        const int32_t i = pending[j];
+        Dungeon *const dungeon = self->dungeons[i];
+        const vec2 position = { self->nextX[i], self->nextY[i] };
+        Room room = Dungeon_GetRoom(dungeon, position);
+        // Enter the room as Game_EnterRoom() does, unless that would draw anything random:
+        switch (room.type) {
+            case ROOM_EMPTY:
+            case ROOM_SPAWN: {
+            } break;
+            case ROOM_ITEM: {
+                self->inventory[room.item][i] += 1;
+                Room_Clear(&room);
+                Dungeon_SetRoom(dungeon, position, &room);
+            } break;
+            case ROOM_PIT: {
+                self->encounter[i] = ENCOUNTER_PIT;
+            } break;
+            case ROOM_ENEMY: {
+                self->encounter[i] = ENCOUNTER_ENEMY;
+            } break;
+            case ROOM_TREASURE: {
+                self->status[i] = GAME_STATUS_WON;
+            } break;
+            case ROOM_TRAP:
+            case _ROOM_TYPE_COUNT: {
+                self->moves[i] = GAME_BATCH_MOVE_STEP;
+                continue;
+            }
+        }
+        // Then finish up as Game_FinishStep() does (nothing here can take any health):
+        if (self->status[i] == GAME_STATUS_PLAYING && !Dungeon_IsVisited(dungeon, position)) {
+            Dungeon_MarkVisited(dungeon, position);
+        }
+    }
+
+    // Then everything that needs a full step:
+    pendingCount = 0;
+    for (int32_t i = 0; i < self->count; ++i) {
+        pending[pendingCount] = i;
+        pendingCount += self->moves[i] == GAME_BATCH_MOVE_STEP;
+    }
+    for (int32_t j = 0; j < pendingCount; ++j) {
+        GameBatch_StepGame(self, pending[j], actions[pending[j]]);
+    }
+
+    GameBatch_ApplyMoves(
+        self->count,
+        self->moves,
+        self->nextX,
+        self->nextY,
+        self->positionX,
+        self->positionY,
+        self->previousX,
+        self->previousY
+    );
+}
+
+void GameBatch_AdjustHealth(GameBatch *const self, const int8_t amounts[]) {
+    assert(self != NULL);
+    assert(amounts != NULL);
+    GameBatch_ApplyHealth(self->count, amounts, self->maxHealth, self->health, self->status);
+}
+
+void GameBatch_GetGame(const GameBatch *const self, const int32_t index, GameState *const outGame) {
+    assert(self != NULL);
+    assert(index >= 0 && index < self->count);
+    assert(outGame != NULL);
+
+    // Filled in field by field, as this is on the slow path of every step (and the dirty rooms are never read):
+    Player *const player = &outGame->player;
+    player->position.current[0] = self->positionX[index];
+    player->position.current[1] = self->positionY[index];
+    player->position.previous[0] = self->previousX[index];
+    player->position.previous[1] = self->previousY[index];
+    player->health.current = self->health[index];
+    player->health.max = self->maxHealth[index];
+    outGame->dungeon = self->dungeons[index];
+    outGame->rng = self->rngs[index];
+    outGame->encounter = (Encounter)self->encounter[index];
+    outGame->status = (GameStatus)self->status[index];
+    // Batches don't track what needs redrawing:
+    outGame->dirtyRooms.count = 0;
+    outGame->dirtyRooms.overflowed = true;
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        player->inventory[i] = self->inventory[i][index];
+    }
+}
+
+void GameBatch_SetGame(GameBatch *const self, const int32_t index, const GameState *const game) {
+    assert(self != NULL);
+    assert(index >= 0 && index < self->count);
+    assert(game != NULL);
+    assert(game->dungeon == self->dungeons[index]);
+
+    const Player *const player = &game->player;
+    self->positionX[index] = player->position.current[0];
+    self->positionY[index] = player->position.current[1];
+    self->previousX[index] = player->position.previous[0];
+    self->previousY[index] = player->position.previous[1];
+    self->health[index] = player->health.current;
+    self->maxHealth[index] = player->health.max;
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        self->inventory[i][index] = player->inventory[i];
+    }
+    self->rngs[index] = game->rng;
+    self->encounter[index] = (uint8_t)game->encounter;
+    self->status[index] = (uint8_t)game->status;
+}
+
+// Point every array of 'self' into an allocation starting at 'base', returning how big it needs to be.
+static size_t GameBatch_Layout(GameBatch *const self, const uintptr_t base) {
+    const int32_t count = self->count;
+    size_t offset = 0;
+    self->positionX = GameBatch_Take(base, &offset, sizeof(self->positionX[0]), count);
+    self->positionY = GameBatch_Take(base, &offset, sizeof(self->positionY[0]), count);
+    self->previousX = GameBatch_Take(base, &offset, sizeof(self->previousX[0]), count);
+    self->previousY = GameBatch_Take(base, &offset, sizeof(self->previousY[0]), count);
+    self->health = GameBatch_Take(base, &offset, sizeof(self->health[0]), count);
+    self->maxHealth = GameBatch_Take(base, &offset, sizeof(self->maxHealth[0]), count);
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        self->inventory[i] = GameBatch_Take(base, &offset, sizeof(self->inventory[i][0]), count);
+    }
+    self->encounter = GameBatch_Take(base, &offset, sizeof(self->encounter[0]), count);
+    self->status = GameBatch_Take(base, &offset, sizeof(self->status[0]), count);
+    self->rngs = GameBatch_Take(base, &offset, sizeof(self->rngs[0]), count);
+    self->dungeons = GameBatch_Take(base, &offset, sizeof(self->dungeons[0]), count);
+    self->episodes = GameBatch_Take(base, &offset, sizeof(self->episodes[0]), count);
+    self->nextX = GameBatch_Take(base, &offset, sizeof(self->nextX[0]), count);
+    self->nextY = GameBatch_Take(base, &offset, sizeof(self->nextY[0]), count);
+    self->moves = GameBatch_Take(base, &offset, sizeof(self->moves[0]), count);
+    self->pending = GameBatch_Take(base, &offset, sizeof(self->pending[0]), count);
+    return offset;
+}
+
+static void* GameBatch_Take(const uintptr_t base, size_t *const offset, const size_t elementSize, const int32_t count) {
+    void *const array = (void*)(base + *offset);
+    *offset += (elementSize * (size_t)count + gameBatchAlignment - 1) / gameBatchAlignment * gameBatchAlignment;
+    return array;
+}
+
+// Step a single game the slow way, through a GameState.
+static void GameBatch_StepGame(GameBatch *const self, const int32_t index, const Action action) {
+    GameState game;
+    GameBatch_GetGame(self, index, &game);
+    Game_Step(&game, action);
+    GameBatch_SetGame(self, index, &game);
+}
+
+// Work out where every movement would take each player (as Player_Move() does), and what needs doing about it.
+static void GameBatch_PlanMoves(
+    const int32_t count,
+    const vec2 size,
+    const Action *restrict const actions,
+    const vec2_scalar *restrict const positionX,
+    const vec2_scalar *restrict const positionY,
+    const vec2_scalar *restrict const previousX,
+    const vec2_scalar *restrict const previousY,
+    const uint8_t *restrict const encounter,
+    const uint8_t *restrict const status,
+    vec2_scalar *restrict const nextX,
+    vec2_scalar *restrict const nextY,
+    uint8_t *restrict const moves
+) {
+    const vec2_scalar width = size[0];
+    const vec2_scalar height = size[1];
+    // Everything is computed for every game and then selected between (using '&' and '|' rather than '&&' and '||'),
+    // in types no wider than needed, so that the loop vectorises well:
+    for (int32_t i = 0; i < count; ++i) {
+        // Actions all fit in a byte, so narrow them straight away:
+        const uint8_t action = (uint8_t)actions[i];
+        const vec2_scalar directionX = (vec2_scalar)(positionX[i] - previousX[i]);
+        const vec2_scalar directionY = (vec2_scalar)(positionY[i] - previousY[i]);
+        // Each movement of Action_GetMovement(), turned to match the way the player is facing (as Player_Move()),
+        // picked out with masks (all bits set when true) as GCC won't vectorise a chain of selects:
+        const vec2_scalar forward = (vec2_scalar)-(action == ACTION_FORWARD);
+        const vec2_scalar back = (vec2_scalar)-(action == ACTION_BACK);
+        const vec2_scalar right = (vec2_scalar)-(action == ACTION_RIGHT);
+        const vec2_scalar left = (vec2_scalar)-(action == ACTION_LEFT);
+        const vec2_scalar stepX = (vec2_scalar)((directionX & forward) | (-directionX & back)
+            | (directionY & right) | (-directionY & left));
+        const vec2_scalar stepY = (vec2_scalar)((directionY & forward) | (-directionY & back)
+            | (-directionX & right) | (directionX & left));
+        // Stepping off the edge of the widest narrow dungeon wraps around to negative, which is still outside:
+        const vec2_scalar x = (vec2_scalar)(positionX[i] + stepX);
+        const vec2_scalar y = (vec2_scalar)(positionY[i] + stepY);
+        nextX[i] = x;
+        nextY[i] = y;
+
+        // Which handler in Game_Step() the action would reach (see Game_HandleCommonAction() and friends):
+        const uint8_t current = encounter[i];
+        const bool moving = (current == ENCOUNTER_NONE) & ((forward | back | right | left) != 0);
+        const bool pitAction = (action == ACTION_JUMP) | (action == ACTION_SWING) | (action == ACTION_RETURN);
+        const bool enemyAction = (action == ACTION_FIGHT) | (action == ACTION_FLEE);
+        const bool changing = (action == ACTION_FOOD) | (action == ACTION_EXIT)
+            | ((current == ENCOUNTER_PIT) & pitAction)
+            | ((current == ENCOUNTER_ENEMY) & enemyAction);
+        const bool inside = (x >= 0) & (x < width) & (y >= 0) & (y < height);
+        const uint8_t move = moving
+            ? (inside ? GAME_BATCH_MOVE_ROOM : GAME_BATCH_MOVE_NOTHING)
+            : (changing ? GAME_BATCH_MOVE_STEP : GAME_BATCH_MOVE_NOTHING);
+        moves[i] = (status[i] == GAME_STATUS_PLAYING) ? move : GAME_BATCH_MOVE_FINISHED;
+    }
+}
+
+// Move every player whose move is still GAME_BATCH_MOVE_ROOM into their next room.
+static void GameBatch_ApplyMoves(
+    const int32_t count,
+    const uint8_t *restrict const moves,
+    const vec2_scalar *restrict const nextX,
+    const vec2_scalar *restrict const nextY,
+    vec2_scalar *restrict const positionX,
+    vec2_scalar *restrict const positionY,
+    vec2_scalar *restrict const previousX,
+    vec2_scalar *restrict const previousY
+) {
+    for (int32_t i = 0; i < count; ++i) {
+        // Blended with a mask, as GCC won't vectorise this many selects:
+        const vec2_scalar mask = (vec2_scalar)-(moves[i] == GAME_BATCH_MOVE_ROOM);
+        const vec2_scalar x = positionX[i];
+        const vec2_scalar y = positionY[i];
+        previousX[i] = (vec2_scalar)((x & mask) | (previousX[i] & ~mask));
+        previousY[i] = (vec2_scalar)((y & mask) | (previousY[i] & ~mask));
+        positionX[i] = (vec2_scalar)((nextX[i] & mask) | (x & ~mask));
+        positionY[i] = (vec2_scalar)((nextY[i] & mask) | (y & ~mask));
+    }
+}
+
+static void GameBatch_ApplyHealth(
+    const int32_t count,
+    const int8_t *restrict const amounts,
+    const int8_t *restrict const maxHealth,
+    int8_t *restrict const health,
+    uint8_t *restrict const status
+) {
+    for (int32_t i = 0; i < count; ++i) {
+        // Blended with masks, as in GameBatch_ApplyMoves():
+        const uint8_t current = status[i];
+        const int8_t playing = (int8_t)-(current == GAME_STATUS_PLAYING);
+        const int32_t unclamped = health[i] + amounts[i];
+        const int32_t max = maxHealth[i];
+        const int8_t adjusted = (int8_t)Clamp(unclamped, 0, max);
+        health[i] = (int8_t)((adjusted & playing) | (health[i] & ~playing));
+        const uint8_t died = (uint8_t)(playing & -(adjusted <= 0));
+        status[i] = (uint8_t)((GAME_STATUS_DIED & died) | (current & ~died));
+    }
+}
+
+// Give every player whose move is set a fresh 'start', relative to the spawn in 'nextX' and 'nextY'.
+static void GameBatch_ResetPlayers(GameBatch *const self, const Player *const start) {
+    const int32_t count = self->count;
+    const uint8_t *const reset = self->moves;
+    GameBatch_ResetArray(count, reset, self->nextX, start->position.previous[0], self->previousX);
+    GameBatch_ResetArray(count, reset, self->nextY, start->position.previous[1], self->previousY);
+    GameBatch_ResetArray(count, reset, self->nextX, start->position.current[0], self->positionX);
+    GameBatch_ResetArray(count, reset, self->nextY, start->position.current[1], self->positionY);
+    GameBatch_ResetBytes(count, reset, (uint8_t)start->health.current, (uint8_t*)self->health);
+    GameBatch_ResetBytes(count, reset, (uint8_t)start->health.max, (uint8_t*)self->maxHealth);
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        GameBatch_ResetBytes(count, reset, start->inventory[i], self->inventory[i]);
+    }
+    GameBatch_ResetBytes(count, reset, ENCOUNTER_NONE, self->encounter);
+    GameBatch_ResetBytes(count, reset, GAME_STATUS_PLAYING, self->status);
+}
+
+static void GameBatch_ResetArray(
+    const int32_t count,
+    const uint8_t *restrict const reset,
+    const vec2_scalar *restrict const source,
+    const vec2_scalar offset,
+    vec2_scalar *restrict const destination
+) {
+    for (int32_t i = 0; i < count; ++i) {
+        const vec2_scalar value = (vec2_scalar)(source[i] + offset);
+        const vec2_scalar current = destination[i];
+        destination[i] = reset[i] ? value : current;
+    }
+}
+
+static void GameBatch_ResetBytes(
+    const int32_t count,
+    const uint8_t *restrict const reset,
+    const uint8_t value,
+    uint8_t *restrict const bytes
+) {
+    for (int32_t i = 0; i < count; ++i) {
+        const uint8_t current = bytes[i];
+        bytes[i] = reset[i] ? value : current;
+    }
+}
@@ -0,0 +1,94 @@
+#include "dungeon/bot.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "dungeon/item.h"
+#include "dungeon/player.h"
+#include "dungeon/util.h"
+
+// Eat whenever health drops to this level or below:
+const int8_t botHungryHealth = 10;
+// Don't risk a fistfight with this much health or less:
+const int8_t botCautiousHealth = 6;
+// Don't attempt a jump unless the odds are at least this good:
+const int32_t botMinimumJumpPercentage = 50;
+
+static Action Bot_ChooseMovement(const GameState* game, Rng* rng);
+
+Action Bot_ChooseAction(const GameState *const game, Rng *const rng) {
+    assert(game != NULL);
+    assert(rng != NULL);
+
+    const Player *const player = &game->player;
+    const bool canEat = player->inventory[ITEM_FOOD] > 0 && player->health.current < player->health.max;
+
+    switch (game->encounter) {
+        case ENCOUNTER_NONE: {
+            if (canEat && player->health.current <= botHungryHealth) {
+                return ACTION_FOOD;
+            }
+            return Bot_ChooseMovement(game, rng);
+        }
+        case ENCOUNTER_PIT: {
+            if (player->inventory[ITEM_HOOK] > 0 && player->inventory[ITEM_ROPE] > 0) {
+                return ACTION_SWING;
+            }
+
+            return Game_GetJumpSuccessPercentage(player) >= botMinimumJumpPercentage
+                ? ACTION_JUMP
+                : ACTION_RETURN;
+        }
+        case ENCOUNTER_ENEMY: {
+            if (canEat && player->health.current <= botCautiousHealth) {
+                return ACTION_FOOD;
+            }
+
+            const Room room = Game_GetCurrentRoom(game);
+            if (
+                player->inventory[ITEM_SWORD] > 0
+                || room.enemy.health <= 3
+                || player->health.current > botCautiousHealth
+            ) {
+                return ACTION_FIGHT;
+            }
+            return ACTION_FLEE;
+        }
+    }
+
+    assert(false);
+    return ACTION_NONE;
+}
+
+static Action Bot_ChooseMovement(const GameState *const game, Rng *const rng) {
+    const Dungeon *const dungeon = game->dungeon;
+
+    // Prefer exploring new rooms, but fall back to any room we can reach:
+    Action unvisited[4], visited[4];
+    int32_t unvisitedCount = 0, visitedCount = 0;
+    for (Action action = ACTION_FORWARD; action <= ACTION_RIGHT; ++action) {
+        vec2 direction;
+        const bool _isMovement = Action_GetMovement(action, direction);
+        assert(_isMovement);
+        (void)_isMovement;
+
+        Player target = game->player;
+        Player_Move(&target, direction);
+        if (!Dungeon_Contains(dungeon, target.position.current)) {
+            continue;
+        }
+
+        if (Dungeon_IsVisited(dungeon, target.position.current)) {
+            visited[visitedCount++] = action;
+        } else {
+            unvisited[unvisitedCount++] = action;
+        }
+    }
+
+    if (unvisitedCount > 0) {
+        return unvisited[RandRangei32(rng, 0, unvisitedCount)];
+    }
+    assert(visitedCount > 0);
+    return visited[RandRangei32(rng, 0, visitedCount)];
+}
@@ -1,10 +1,14 @@
 #include "dungeon/dungeon.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "dungeon/item.h"
+#include "dungeon/parallel.h"
+#include "dungeon/profile.h"
+#include "dungeon/snapshot.h"
 #include "dungeon/util.h"
 
 const int32_t roomDistribution[_ROOM_TYPE_COUNT] = {
@@ -24,49 +28,379 @@ const int32_t roomDistribution[_ROOM_TYPE_COUNT] = {
     0,
 };
 
-Dungeon* Dungeon_Create(const vec2 size) {
+const int32_t itemDistribution[_ITEM_TYPE_COUNT] = {
+    // ITEM_FOOD:
+    1,
+    // ITEM_SWORD:
+    1,
+    // ITEM_SHIELD:
+    1,
+    // ITEM_ROPE:
+    1,
+    // ITEM_HOOK:
+    1,
+    // ITEM_ROCK:
+    1,
+};
+
+// Position keys are never negative, so this can't collide with a real room:
+const uint64_t roomTableEmptyKey = UINT64_MAX;
+// Dense dungeons fill any rooms left over from rounding down the distribution with this:
+const RoomType dungeonDefaultRoom = ROOM_EMPTY;
+// Tiled generation splits the dungeon into tiles of whole rows with about this many rooms each:
+const int64_t dungeonTileRooms = 65536;
+// Splitting counts between tiles is exact when either side of the split is this small, or the count this uncertain
+// (its variance), and approximate otherwise:
+const int64_t dungeonExactSplitLimit = 64;
+const double dungeonExactSplitVariance = 16.0;
+
+// Validation stops regenerating a dungeon that keeps coming out unsolvable (and repairs it instead) after this many:
+const int32_t dungeonMaxGenerationAttempts = 64;
+// Repairs try this many random rooms to swap a hazard with before scanning for one:
+const int32_t dungeonRepairSamples = 64;
+
+typedef struct DungeonTileJob {
+    Dungeon* dungeon;
+    int32_t rowsPerTile;
+    // How many rooms of each type every tile gets (indexed by tile * _ROOM_TYPE_COUNT + type):
+    int64_t* roomCounts;
+} DungeonTileJob;
+
+// Bitsets over every room for Dungeon_IsSolvable(), with each row padded out to whole words
+// (bit 'x % 64' of word 'y * rowWords + x / 64' is the room at (x, y)):
+typedef struct DungeonMask {
+    int64_t rowWords;
+    int64_t height;
+    // Rooms the player can walk through without a fight (anything but pits and enemies, plus any pits crossed):
+    uint64_t* passable;
+    // Pits not crossed yet:
+    uint64_t* pits;
+    // Rooms reachable from the spawn so far:
+    uint64_t* reached;
+    // Scratch space for the pits next to a reached room:
+    uint64_t* frontier;
+} DungeonMask;
+
+static Dungeon* Dungeon_Generate(const DungeonParams* params, Rng* rng);
+static Dungeon* Dungeon_CreateDense(const DungeonParams* params, Rng* rng);
+static Dungeon* Dungeon_CreateHashed(const DungeonParams* params, Rng* rng);
+static Dungeon* Dungeon_CreateTiled(const DungeonParams* params, Rng* rng);
+static void Dungeon_GenerateTile(void* context, int32_t index, int32_t worker);
+static Dungeon* Dungeon_AllocateDense(const DungeonParams* params);
+static void Dungeon_GetRoomCounts(const DungeonParams* params, int64_t outCounts[_ROOM_TYPE_COUNT]);
+static Room Dungeon_GenerateRoom(const Dungeon* self, const vec2 position);
+static Room Dungeon_GetUnchangedRoom(const Dungeon* self, const vec2 position);
+static RoomTableEntry* Dungeon_InsertRoom(Dungeon* self, const vec2 position);
+static inline uint64_t Dungeon_PositionKey(const vec2 position);
+
+static void Dungeon_InitMask(const Dungeon* self, DungeonMask* outMask);
+static bool Dungeon_Flood(DungeonMask* mask, int64_t targetWord, uint64_t targetBit);
+static bool Dungeon_SpreadRow(
+    uint64_t* restrict reached,
+    const uint64_t* restrict neighbour,
+    const uint64_t* restrict passable,
+    int64_t rowWords,
+    bool force
+);
+static bool Dungeon_CrossPits(DungeonMask* mask);
+static inline uint64_t Dungeon_PackBits(const uint8_t bytes[64]);
+static inline uint64_t Dungeon_FillUp(uint64_t seeds, uint64_t passable);
+static inline uint64_t Dungeon_FillDown(uint64_t seeds, uint64_t passable);
+static bool Dungeon_Repair(Dungeon* self, Rng* rng);
+static int64_t Dungeon_FindHarmlessRoom(const Dungeon* self, Rng* rng);
+static bool Dungeon_IsOnCorridor(const Dungeon* self, const vec2 position);
+
+static int64_t Dungeon_SampleHypergeometric(Rng* rng, int64_t population, int64_t successes, int64_t draws);
+
+static RoomTableEntry* RoomTable_Find(const RoomTable* self, uint64_t key);
+static void RoomTable_Copy(RoomTable* self, const RoomTable* source);
+static void RoomTable_Grow(RoomTable* self);
+
+DungeonParams DungeonParams_Default(const vec2 size) {
     assert(size != NULL);
 
-    const int32_t totalRooms = size[0] * size[1];
+    DungeonParams params = {
+        .size = { size[0], size[1] },
+        .generation = DUNGEON_GENERATION_DENSE,
+        .threadCount = 0,
+        .validation = DUNGEON_VALIDATION_NONE,
+        .crossablePits = 1,
+    };
+    assert(sizeof(params.roomDistribution) == sizeof(roomDistribution));
+    memcpy(params.roomDistribution, roomDistribution, sizeof(roomDistribution));
+    assert(sizeof(params.itemDistribution) == sizeof(itemDistribution));
+    memcpy(params.itemDistribution, itemDistribution, sizeof(itemDistribution));
+    return params;
+}
+
+Dungeon* Dungeon_Create(const vec2 size, Rng *const rng) {
+    const DungeonParams params = DungeonParams_Default(size);
+    return Dungeon_CreateWithParams(&params, rng);
+}
+
+Dungeon* Dungeon_CreateWithParams(const DungeonParams *const params, Rng *const rng) {
+    assert(params != NULL);
+    assert(rng != NULL);
+    assert(params->roomDistribution[ROOM_TREASURE] == 0);
+    assert(params->roomDistribution[ROOM_SPAWN] == 0);
+    assert(params->crossablePits >= 0);
+
+    // Hashed dungeons don't store their rooms, so there's nothing to check - they're always kept as generated:
+    const DungeonValidation validation = (params->generation == DUNGEON_GENERATION_HASHED)
+        ? DUNGEON_VALIDATION_NONE
+        : params->validation;
+
+    PROFILE_BEGIN(PROFILE_ZONE_DUNGEON_CREATE);
+    Dungeon* dungeon = Dungeon_Generate(params, rng);
+    if (validation != DUNGEON_VALIDATION_NONE) {
+        for (int32_t attempt = 1; !Dungeon_IsSolvable(dungeon, params->crossablePits); ++attempt) {
+            const bool lastAttempt = attempt == dungeonMaxGenerationAttempts;
+            if ((validation == DUNGEON_VALIDATION_REPAIR || lastAttempt) && Dungeon_Repair(dungeon, rng)) {
+                break;
+            }
+            // Nothing more can be done, e.g. when almost every room is a pit:
+            if (lastAttempt) {
+                break;
+            }
+            Dungeon_Destroy(dungeon);
+            dungeon = Dungeon_Generate(params, rng);
+        }
+    }
+    PROFILE_END(PROFILE_ZONE_DUNGEON_CREATE);
+
+    assert(dungeon != NULL);
+    return dungeon;
+}
+
+bool Dungeon_IsSolvable(const Dungeon *const self, const int32_t crossablePits) {
+    assert(self != NULL);
+    assert(self->rooms != NULL);
+    assert(crossablePits >= 0);
+
+    PROFILE_BEGIN(PROFILE_ZONE_DUNGEON_VALIDATE);
+    DungeonMask mask;
+    Dungeon_InitMask(self, &mask);
+    const int64_t spawnWord = self->spawnPosition[1] * mask.rowWords + self->spawnPosition[0] / 64;
+    mask.reached[spawnWord] |= (uint64_t)1 << (self->spawnPosition[0] % 64);
+    const int64_t treasureWord = self->treasurePosition[1] * mask.rowWords + self->treasurePosition[0] / 64;
+    const uint64_t treasureBit = (uint64_t)1 << (self->treasurePosition[0] % 64);
+
+    // Flood out from the spawn, then from every pit next to what was reached, once per pit the player can cross:
+    bool solvable = false;
+    for (int32_t pitsCrossed = 0; ; ++pitsCrossed) {
+        if (Dungeon_Flood(&mask, treasureWord, treasureBit)) {
+            solvable = true;
+            break;
+        }
+        if (pitsCrossed == crossablePits || !Dungeon_CrossPits(&mask)) {
+            break;
+        }
+    }
+    free(mask.passable);
+    PROFILE_END(PROFILE_ZONE_DUNGEON_VALIDATE);
+    return solvable;
+}
+
+void Dungeon_GenerateLayout(
+    const DungeonParams *const params,
+    Rng *const rng,
+    uint8_t outTypes[],
+    vec2 outSpawnPosition,
+    vec2 outTreasurePosition
+) {
+    assert(params != NULL);
+    assert(rng != NULL);
+    assert(outTypes != NULL);
+    assert(params->generation == DUNGEON_GENERATION_DENSE);
+    assert(params->validation == DUNGEON_VALIDATION_NONE);
+    const int64_t totalRooms = (int64_t)params->size[0] * params->size[1];
     assert(totalRooms >= _ROOM_TYPE_COUNT);
-    Dungeon *const self = calloc(1, sizeof(*self) + sizeof(self->rooms[0]) * totalRooms);
+
+    // Lay the rooms out and shuffle them exactly as Dungeon_CreateDense() does, which settles every room's type:
+    int64_t roomCounts[_ROOM_TYPE_COUNT];
+    Dungeon_GetRoomCounts(params, roomCounts);
+    int64_t roomIndex = 0;
+    for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+        memset(&outTypes[roomIndex], (int)roomType, (size_t)roomCounts[roomType]);
+        roomIndex += roomCounts[roomType];
+    }
+    memset(&outTypes[roomIndex], (int)dungeonDefaultRoom, (size_t)(totalRooms - roomIndex));
+    for (int64_t i = 0; i < totalRooms; ++i) {
+        // The same draw as RandRangei64() makes for ranges that fit in 32 bits, inlined as it's most of the work:
+        const uint64_t range = (uint64_t)(totalRooms - i);
+        const int64_t swapIndex = (range <= UINT32_MAX)
+            ? i + (int64_t)(((uint64_t)Rng_Next(rng) * range) >> 32)
+            : RandRangei64(rng, i, totalRooms);
+        const uint8_t current = outTypes[i];
+        outTypes[i] = outTypes[swapIndex];
+        outTypes[swapIndex] = current;
+    }
+
+    // Room_Init() only draws what's inside each room, so it can be skipped entirely. The spawn and treasure are
+    // the only rooms of their type:
+    const uint8_t *const spawn = memchr(outTypes, ROOM_SPAWN, (size_t)totalRooms);
+    const uint8_t *const treasure = memchr(outTypes, ROOM_TREASURE, (size_t)totalRooms);
+    assert(spawn != NULL && treasure != NULL);
+    const int64_t spawnIndex = spawn - outTypes;
+    const int64_t treasureIndex = treasure - outTypes;
+    Vec2_Set(
+        outSpawnPosition,
+        (vec2) { (vec2_scalar)(spawnIndex % params->size[0]), (vec2_scalar)(spawnIndex / params->size[0]) }
+    );
+    Vec2_Set(
+        outTreasurePosition,
+        (vec2) { (vec2_scalar)(treasureIndex % params->size[0]), (vec2_scalar)(treasureIndex / params->size[0]) }
+    );
+}
+
+Dungeon* Dungeon_Fork(const Dungeon *const parent) {
+    assert(parent != NULL);
+
+    Dungeon *const self = malloc(sizeof(*self));
     assert(self != NULL);
+    *self = *parent;
+    self->rooms = NULL;
+    self->visited = NULL;
+    self->mapping = NULL;
+    self->mappingSize = 0;
+    if (parent->base != NULL) {
+        // Share the same original, and carry over every change made along the way:
+        RoomTable_Copy(&self->changedRooms, &parent->changedRooms);
+    } else {
+        self->base = parent;
+        self->changedRooms = (RoomTable) { 0 };
+    }
+    return self;
+}
 
-    Vec2_Set(self->size, size);
+void Dungeon_Destroy(Dungeon *const self) {
+    assert(self != NULL);
+    free(self->changedRooms.entries);
+    if (self->mapping != NULL) {
+        Snapshot_Unmap(self->mapping, self->mappingSize);
+    } else {
+        free(self);
+    }
+}
 
-    // Room are packed at end of Dungeon allocation:
-    self->rooms = (Room*)((uintptr_t)self + sizeof(*self));
+uint64_t Dungeon_Hash(const Dungeon *const self) {
+    assert(self != NULL);
 
-    const RoomType defaultRoom = ROOM_EMPTY;
-    {
-        assert((sizeof(roomDistribution) / sizeof(roomDistribution[0])) == _ROOM_TYPE_COUNT);
+    uint64_t hash = Rng_Hash64((uint64_t)self->generation);
+    hash = Rng_HashCombine(hash, Dungeon_PositionKey(self->size));
+    hash = Rng_HashCombine(hash, Dungeon_PositionKey(self->spawnPosition));
+    hash = Rng_HashCombine(hash, Dungeon_PositionKey(self->treasurePosition));
+    hash = Rng_HashCombine(hash, self->seed);
+    if (self->rooms != NULL) {
+        const int64_t totalRooms = Dungeon_RoomCount(self);
+        for (int64_t i = 0; i < totalRooms; ++i) {
+            hash = Rng_HashCombine(hash, self->rooms[i]);
+        }
+        for (int64_t i = 0; i < (totalRooms + 63) / 64; ++i) {
+            hash = Rng_HashCombine(hash, self->visited[i]);
+        }
+    }
 
-        int32_t totalRoomDistribution = 0;
-        for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
-            totalRoomDistribution += roomDistribution[i];
+    // Table order depends on its history, so changed rooms are summed to make the hash order-independent:
+    uint64_t changedRooms = 0;
+    for (int64_t i = 0; i < self->changedRooms.capacity; ++i) {
+        const RoomTableEntry *const entry = &self->changedRooms.entries[i];
+        if (entry->key != roomTableEmptyKey) {
+            changedRooms += Rng_HashCombine(entry->key, ((uint64_t)entry->visited << 16) | entry->room);
         }
+    }
+    hash = Rng_HashCombine(hash, changedRooms);
 
-        // Fill out the rooms linearly based on their distribution chances (rounded down):
-        int32_t roomIndex = 0;
+    if (self->base != NULL) {
+        hash = Rng_HashCombine(hash, Dungeon_Hash(self->base));
+    }
+    return hash;
+}
+
+Room Dungeon_LookupRoom(const Dungeon *const self, const vec2 position) {
+    assert(self != NULL);
+    assert(self->generation == DUNGEON_GENERATION_HASHED || self->base != NULL);
+    assert(Dungeon_Contains(self, position));
+
+    const RoomTableEntry *const entry = RoomTable_Find(&self->changedRooms, Dungeon_PositionKey(position));
+    if (entry != NULL && entry->key != roomTableEmptyKey) {
+        return Room_Unpack(entry->room);
+    }
+    return Dungeon_GetUnchangedRoom(self, position);
+}
+
+void Dungeon_StoreRoom(Dungeon *const self, const vec2 position, const Room *const room) {
+    assert(self != NULL);
+    assert(self->generation == DUNGEON_GENERATION_HASHED || self->base != NULL);
+    assert(Dungeon_Contains(self, position));
+    assert(room != NULL);
+
+    Dungeon_InsertRoom(self, position)->room = Room_Pack(room);
+}
+
+bool Dungeon_LookupVisited(const Dungeon *const self, const vec2 position) {
+    assert(self != NULL);
+    assert(self->generation == DUNGEON_GENERATION_HASHED || self->base != NULL);
+    assert(Dungeon_Contains(self, position));
+
+    const RoomTableEntry *const entry = RoomTable_Find(&self->changedRooms, Dungeon_PositionKey(position));
+    if (entry != NULL && entry->key != roomTableEmptyKey) {
+        return entry->visited;
+    }
+    return self->base != NULL && Dungeon_IsVisited(self->base, position);
+}
+
+void Dungeon_StoreVisited(Dungeon *const self, const vec2 position) {
+    assert(self != NULL);
+    assert(self->generation == DUNGEON_GENERATION_HASHED || self->base != NULL);
+    assert(Dungeon_Contains(self, position));
+
+    Dungeon_InsertRoom(self, position)->visited = true;
+}
+
+static Dungeon* Dungeon_Generate(const DungeonParams *const params, Rng *const rng) {
+    switch (params->generation) {
+        case DUNGEON_GENERATION_DENSE: {
+            return Dungeon_CreateDense(params, rng);
+        }
+        case DUNGEON_GENERATION_HASHED: {
+            return Dungeon_CreateHashed(params, rng);
+        }
+        case DUNGEON_GENERATION_TILED: {
+            return Dungeon_CreateTiled(params, rng);
+        }
+    }
+    assert(false);
+    return NULL;
+}
+
+static Dungeon* Dungeon_CreateDense(const DungeonParams *const params, Rng *const rng) {
+    const vec2_scalar *const size = params->size;
+    Dungeon *const self = Dungeon_AllocateDense(params);
+    const int64_t totalRooms = Dungeon_RoomCount(self);
+
+    // Fill out the rooms linearly by type:
+    {
+        int64_t roomCounts[_ROOM_TYPE_COUNT];
+        Dungeon_GetRoomCounts(params, roomCounts);
+        int64_t roomIndex = 0;
         for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
-            // Make sure each room type appears at least once:
-            const int32_t minimumCount = Max(1, roomDistribution[roomType] * totalRooms / totalRoomDistribution);
-            for (int32_t count = 0; count < minimumCount && roomIndex < totalRooms; ++count, ++roomIndex) {
-                self->rooms[roomIndex].type = roomType;
+            for (int64_t count = 0; count < roomCounts[roomType]; ++count, ++roomIndex) {
+                self->rooms[roomIndex] = PackedRoom_Make(roomType, 0, 0);
             }
         }
-        // Fill any remaining rooms with the default;
+        // Fill any remaining rooms with the default:
         for (; roomIndex < totalRooms; ++roomIndex) {
-            self->rooms[roomIndex].type = defaultRoom;
+            self->rooms[roomIndex] = PackedRoom_Make(dungeonDefaultRoom, 0, 0);
         }
     }
 
     // Randomly shuffle the rooms:
-    for (int32_t i = 0; i < totalRooms; ++i) {
-        const int32_t rng = RandRangei32(i, totalRooms);
-        RoomType current = self->rooms[i].type;
-        self->rooms[i].type = self->rooms[rng].type;
-        self->rooms[rng].type = current;
+    for (int64_t i = 0; i < totalRooms; ++i) {
+        const int64_t swapIndex = RandRangei64(rng, i, totalRooms);
+        const PackedRoom current = self->rooms[i];
+        self->rooms[i] = self->rooms[swapIndex];
+        self->rooms[swapIndex] = current;
     }
 
     const vec2 invalidPosition = { -1, -1 };
@@ -74,49 +408,649 @@ Dungeon* Dungeon_Create(const vec2 size) {
     Vec2_Set(self->treasurePosition, invalidPosition);
     for (vec2 position = { 0, 0 }; position[1] < size[1]; ++position[1]) {
         for (position[0] = 0; position[0] < size[0]; ++position[0]) {
-            const int32_t index = Dungeon_RoomIndex(self, position);
-            Room *const room = &self->rooms[index];
-            switch (room->type) {
-                case ROOM_EMPTY: {
-                    Room_InitEmpty(room);
-                } break;
-                case ROOM_ITEM: {
-                    Room_InitItem(room);
-                } break;
-                case ROOM_PIT: {
-                    Room_InitPit(room);
-                } break;
-                case ROOM_TRAP: {
-                    Room_InitTrap(room);
-                } break;
-                case ROOM_ENEMY: {
-                    Room_InitEnemy(room);
-                } break;
-                case ROOM_TREASURE: {
-                    assert(Vec2_Equal(self->treasurePosition, invalidPosition));
-                    Vec2_Set(self->treasurePosition, position);
-                    Room_InitTreasure(room);
-                } break;
-                case ROOM_SPAWN: {
-                    assert(Vec2_Equal(self->spawnPosition, invalidPosition));
-                    Vec2_Set(self->spawnPosition, position);
-                    Room_InitSpawn(room);
-                } break;
-                case _ROOM_TYPE_COUNT: {
-                    assert(false);
-                } break;
+            const int64_t index = Dungeon_RoomIndex(self, position);
+            const RoomType type = PackedRoom_GetType(self->rooms[index]);
+            if (type == ROOM_TREASURE) {
+                assert(Vec2_Equal(self->treasurePosition, invalidPosition));
+                Vec2_Set(self->treasurePosition, position);
+            } else if (type == ROOM_SPAWN) {
+                assert(Vec2_Equal(self->spawnPosition, invalidPosition));
+                Vec2_Set(self->spawnPosition, position);
             }
+            Room room = { 0 };
+            Room_Init(&room, type, &self->items, rng);
+            self->rooms[index] = Room_Pack(&room);
         }
     }
     assert(!Vec2_Equal(self->treasurePosition, invalidPosition));
     assert(!Vec2_Equal(self->spawnPosition, invalidPosition));
+    PROFILE_COUNT(PROFILE_COUNTER_ROOMS_GENERATED, totalRooms);
 
     return self;
 }
 
-void Dungeon_Destroy(Dungeon *const self) {
+static Dungeon* Dungeon_CreateTiled(const DungeonParams *const params, Rng *const rng) {
+    const vec2_scalar *const size = params->size;
+    Dungeon *const self = Dungeon_AllocateDense(params);
+    const int64_t totalRooms = Dungeon_RoomCount(self);
+    // The only draw from 'rng' - everything else is derived from this:
+    self->seed = Rng_Next64(rng);
+
+    // Tiles are always the same rows, however many threads there are:
+    DungeonTileJob job = {
+        .dungeon = self,
+        .rowsPerTile = (int32_t)Max(1, dungeonTileRooms / size[0]),
+    };
+    const int32_t tileCount = (int32_t)((size[1] + job.rowsPerTile - 1) / job.rowsPerTile);
+    job.roomCounts = malloc(sizeof(job.roomCounts[0]) * _ROOM_TYPE_COUNT * (size_t)tileCount);
+    assert(job.roomCounts != NULL);
+
+    // Deal the same rooms as Dungeon_CreateDense() out to the tiles, as if they had been shuffled across all of them.
+    // This is the only serial part, and only costs O(tiles) (plus a multiply per room of any type so rare that its
+    // share of a tile is worked out exactly):
+    {
+        int64_t remainingCounts[_ROOM_TYPE_COUNT];
+        Dungeon_GetRoomCounts(params, remainingCounts);
+        int64_t assignedRooms = 0;
+        for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+            assignedRooms += remainingCounts[i];
+        }
+        remainingCounts[dungeonDefaultRoom] += totalRooms - assignedRooms;
+
+        Rng splitRng;
+        Rng_Seed(&splitRng, self->seed, UINT64_MAX);
+        int64_t remainingRooms = totalRooms;
+        for (int32_t tile = 0; tile < tileCount; ++tile) {
+            const int64_t firstRow = (int64_t)tile * job.rowsPerTile;
+            const int64_t rows = Min((int64_t)job.rowsPerTile, size[1] - firstRow);
+            int64_t tileRooms = rows * size[0];
+            // Each type in turn takes its share of what the tile has left, out of every room that's left:
+            int64_t *const tileCounts = &job.roomCounts[(size_t)tile * _ROOM_TYPE_COUNT];
+            for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+                tileCounts[i] = (i == _ROOM_TYPE_COUNT - 1)
+                    ? tileRooms
+                    : Dungeon_SampleHypergeometric(&splitRng, remainingRooms, remainingCounts[i], tileRooms);
+                tileRooms -= tileCounts[i];
+                remainingRooms -= remainingCounts[i];
+                remainingCounts[i] -= tileCounts[i];
+            }
+            assert(tileRooms == 0);
+            remainingRooms = 0;
+            for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+                remainingRooms += remainingCounts[i];
+            }
+        }
+        assert(remainingRooms == 0);
+    }
+
+    const vec2 invalidPosition = { -1, -1 };
+    Vec2_Set(self->spawnPosition, invalidPosition);
+    Vec2_Set(self->treasurePosition, invalidPosition);
+    Parallel_For(tileCount, params->threadCount, Dungeon_GenerateTile, &job);
+    assert(!Vec2_Equal(self->treasurePosition, invalidPosition));
+    assert(!Vec2_Equal(self->spawnPosition, invalidPosition));
+
+    free(job.roomCounts);
+    PROFILE_COUNT(PROFILE_COUNTER_ROOMS_GENERATED, totalRooms);
+    return self;
+}
+
+// Generate every room in one tile of rows for Dungeon_CreateTiled(), in the same way as Dungeon_CreateDense()
+// but only shuffling within the tile.
+static void Dungeon_GenerateTile(void *const context, const int32_t index, const int32_t worker) {
+    (void)worker;
+    const DungeonTileJob *const job = context;
+    Dungeon *const self = job->dungeon;
+
+    // Every tile has its own stream, so it doesn't matter which thread generates it or when:
+    Rng rng;
+    Rng_Seed(&rng, self->seed, (uint64_t)index);
+
+    const int64_t firstRow = (int64_t)index * job->rowsPerTile;
+    const int64_t endRow = Min(firstRow + job->rowsPerTile, (int64_t)self->size[1]);
+    PackedRoom *const rooms = &self->rooms[firstRow * self->size[0]];
+    const int64_t tileRooms = (endRow - firstRow) * self->size[0];
+
+    const int64_t *const tileCounts = &job->roomCounts[(size_t)index * _ROOM_TYPE_COUNT];
+    int64_t roomIndex = 0;
+    for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+        for (int64_t count = 0; count < tileCounts[roomType]; ++count, ++roomIndex) {
+            rooms[roomIndex] = PackedRoom_Make(roomType, 0, 0);
+        }
+    }
+    assert(roomIndex == tileRooms);
+
+    for (int64_t i = 0; i < tileRooms; ++i) {
+        const int64_t swapIndex = RandRangei64(&rng, i, tileRooms);
+        const PackedRoom current = rooms[i];
+        rooms[i] = rooms[swapIndex];
+        rooms[swapIndex] = current;
+    }
+
+    for (int64_t i = 0; i < tileRooms; ++i) {
+        const RoomType type = PackedRoom_GetType(rooms[i]);
+        // Only the tiles holding the spawn and treasure write them, so there's no need to synchronise:
+        if (type == ROOM_TREASURE || type == ROOM_SPAWN) {
+            const vec2 position = {
+                (vec2_scalar)(i % self->size[0]),
+                (vec2_scalar)(firstRow + i / self->size[0]),
+            };
+            Vec2_Set((type == ROOM_TREASURE) ? self->treasurePosition : self->spawnPosition, position);
+        }
+        Room room = { 0 };
+        Room_Init(&room, type, &self->items, &rng);
+        rooms[i] = Room_Pack(&room);
+    }
+}
+
+// Allocate a dense dungeon of 'params->size' rooms (with nothing generated yet).
+static Dungeon* Dungeon_AllocateDense(const DungeonParams *const params) {
+    const vec2_scalar *const size = params->size;
+    const int64_t totalRooms = (int64_t)size[0] * size[1];
+    assert(totalRooms >= _ROOM_TYPE_COUNT);
+    // Rooms come straight after the Dungeon, then the visited bitset (aligned to a whole word):
+    const int64_t visitedWords = (totalRooms + 63) / 64;
+    assert((uint64_t)totalRooms <= (SIZE_MAX - sizeof(Dungeon)) / (sizeof(PackedRoom) + sizeof(uint64_t)));
+    const size_t roomsSize = (sizeof(PackedRoom) * (size_t)totalRooms + sizeof(uint64_t) - 1)
+        / sizeof(uint64_t) * sizeof(uint64_t);
+    Dungeon *const self = calloc(1, sizeof(*self) + roomsSize + sizeof(uint64_t) * (size_t)visitedWords);
     assert(self != NULL);
-    free(self);
+
+    Vec2_Set(self->size, size);
+    self->generation = DUNGEON_GENERATION_DENSE;
+    // Build the loot table once rather than per item room:
+    Sampler_Init(&self->items, _ITEM_TYPE_COUNT, params->itemDistribution);
+
+    // Rooms and visited flags are packed at end of Dungeon allocation:
+    self->rooms = (PackedRoom*)((uintptr_t)self + sizeof(*self));
+    self->visited = (uint64_t*)((uintptr_t)self->rooms + roomsSize);
+    return self;
+}
+
+// Get how many rooms of each type a dense dungeon has, based on their distribution chances (rounded down).
+// Any rooms left over are dungeonDefaultRoom.
+static void Dungeon_GetRoomCounts(const DungeonParams *const params, int64_t outCounts[_ROOM_TYPE_COUNT]) {
+    const int32_t *const distribution = params->roomDistribution;
+    const int64_t totalRooms = (int64_t)params->size[0] * params->size[1];
+
+    int32_t totalRoomDistribution = 0;
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        assert(distribution[i] >= 0);
+        totalRoomDistribution += distribution[i];
+    }
+    assert(totalRoomDistribution > 0);
+
+    // Make sure each room type appears at least once by reserving a room for each of them up-front,
+    // otherwise a distribution that adds up exactly could crowd out the treasure or spawn:
+    const int64_t distributedRooms = totalRooms - _ROOM_TYPE_COUNT;
+    int64_t assignedRooms = 0;
+    for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+        outCounts[roomType] = 1 + distribution[roomType] * distributedRooms / totalRoomDistribution;
+        assignedRooms += outCounts[roomType];
+    }
+    assert(assignedRooms <= totalRooms);
+    (void)assignedRooms;
+}
+
+static Dungeon* Dungeon_CreateHashed(const DungeonParams *const params, Rng *const rng) {
+    const vec2_scalar *const size = params->size;
+    assert((int64_t)size[0] * size[1] >= 2);
+
+    Dungeon *const self = calloc(1, sizeof(*self));
+    assert(self != NULL);
+
+    Vec2_Set(self->size, size);
+    self->generation = DUNGEON_GENERATION_HASHED;
+    self->seed = Rng_Next64(rng);
+    Sampler_Init(&self->roomTypes, _ROOM_TYPE_COUNT, params->roomDistribution);
+    Sampler_Init(&self->items, _ITEM_TYPE_COUNT, params->itemDistribution);
+
+    // The spawn and treasure are the only rooms that are placed explicitly:
+    Vec2_Set(
+        self->spawnPosition,
+        (vec2) { (vec2_scalar)RandRangei32(rng, 0, size[0]), (vec2_scalar)RandRangei32(rng, 0, size[1]) }
+    );
+    do {
+        Vec2_Set(
+            self->treasurePosition,
+            (vec2) { (vec2_scalar)RandRangei32(rng, 0, size[0]), (vec2_scalar)RandRangei32(rng, 0, size[1]) }
+        );
+    } while (Vec2_Equal(self->treasurePosition, self->spawnPosition));
+
+    return self;
+}
+
+static Room Dungeon_GenerateRoom(const Dungeon *const self, const vec2 position) {
+    Room room;
+    if (Vec2_Equal(position, self->spawnPosition)) {
+        Room_InitSpawn(&room);
+    } else if (Vec2_Equal(position, self->treasurePosition)) {
+        Room_InitTreasure(&room);
+    } else {
+        // Each room gets its own stream derived from its coordinates, so it can be (re)generated in any order:
+        Rng rng;
+        Rng_Seed(&rng, Rng_Hash64(self->seed ^ Rng_Hash64(Dungeon_PositionKey(position))), 0);
+        const RoomType type = (RoomType)Sampler_Sample(&self->roomTypes, &rng);
+        assert(type != ROOM_TREASURE && type != ROOM_SPAWN);
+        Room_Init(&room, type, &self->items, &rng);
+    }
+    PROFILE_COUNT(PROFILE_COUNTER_ROOMS_GENERATED, 1);
+    return room;
+}
+
+// Get the room at 'position' as it was before this dungeon changed it.
+static Room Dungeon_GetUnchangedRoom(const Dungeon *const self, const vec2 position) {
+    if (self->base != NULL) {
+        return Dungeon_GetRoom(self->base, position);
+    }
+    return Dungeon_GenerateRoom(self, position);
+}
+
+// Find the changed room entry for 'position', adding it as it was originally if it doesn't exist yet.
+static RoomTableEntry* Dungeon_InsertRoom(Dungeon *const self, const vec2 position) {
+    RoomTable *const table = &self->changedRooms;
+    // Keep the load factor at or below 50% so probe sequences stay short:
+    if ((table->count + 1) * 2 > table->capacity) {
+        RoomTable_Grow(table);
+    }
+
+    const uint64_t key = Dungeon_PositionKey(position);
+    RoomTableEntry *const entry = RoomTable_Find(table, key);
+    assert(entry != NULL);
+    if (entry->key == roomTableEmptyKey) {
+        const Room room = Dungeon_GetUnchangedRoom(self, position);
+        *entry = (RoomTableEntry) {
+            .key = key,
+            .room = Room_Pack(&room),
+            .visited = self->base != NULL && Dungeon_IsVisited(self->base, position),
+        };
+        table->count += 1;
+    }
+    return entry;
+}
+
+static inline uint64_t Dungeon_PositionKey(const vec2 position) {
+    return ((uint64_t)(uint32_t)position[0] << 32) | (uint32_t)position[1];
+}
+
+// Build the bitsets for checking 'self' - which rooms can be walked through, which are pits - with nothing reached
+// yet. Release with free(outMask->passable).
+static void Dungeon_InitMask(const Dungeon *const self, DungeonMask *const outMask) {
+    const int64_t width = self->size[0];
+    const int64_t rowWords = (width + 63) / 64;
+    const int64_t words = rowWords * self->size[1];
+    uint64_t *const memory = calloc(4 * (size_t)words, sizeof(uint64_t));
+    assert(memory != NULL);
+    *outMask = (DungeonMask) {
+        .rowWords = rowWords,
+        .height = self->size[1],
+        .passable = memory,
+        .pits = memory + words,
+        .reached = memory + 2 * words,
+        .frontier = memory + 3 * words,
+    };
+
+    // Classify a word's worth of rooms at a time into bytes (which vectorises), then pack those down into bits:
+    uint8_t passable[64] = { 0 };
+    uint8_t pits[64] = { 0 };
+    for (int64_t y = 0; y < outMask->height; ++y) {
+        const PackedRoom *const rooms = &self->rooms[y * width];
+        for (int64_t word = 0; word < rowWords; ++word) {
+            const int64_t start = word * 64;
+            const int64_t count = Min(width - start, 64);
+            if (count < 64) {
+                memset(passable, 0, sizeof(passable));
+                memset(pits, 0, sizeof(pits));
+            }
+            for (int64_t i = 0; i < count; ++i) {
+                const uint8_t type = (uint8_t)PackedRoom_GetType(rooms[start + i]);
+                passable[i] = type != ROOM_PIT && type != ROOM_ENEMY;
+                pits[i] = type == ROOM_PIT;
+            }
+            outMask->passable[y * rowWords + word] = Dungeon_PackBits(passable);
+            outMask->pits[y * rowWords + word] = Dungeon_PackBits(pits);
+        }
+    }
+}
+
+// Pack 64 bytes that are each 0 or 1 into a word, with byte 'i' becoming bit 'i'.
+static inline uint64_t Dungeon_PackBits(const uint8_t bytes[64]) {
+    uint64_t bits = 0;
+    for (int32_t group = 0; group < 8; ++group) {
+        uint64_t value = 0;
+        for (int32_t i = 0; i < 8; ++i) {
+            value |= (uint64_t)bytes[group * 8 + i] << (i * 8);
+        }
+        // Multiplying moves byte 'i' to bit '56 + i', without any of the partial products overlapping:
+        bits |= ((value * 0x0102040810204080) >> 56) << (group * 8);
+    }
+    return bits;
+}
+
+// Grow the reached rooms to everything connected to them through passable rooms, stopping early (and returning true)
+// if the target room is reached.
+static bool Dungeon_Flood(DungeonMask *const mask, const int64_t targetWord, const uint64_t targetBit) {
+    const int64_t rowWords = mask->rowWords;
+    // Sweep down and then up until nothing changes - each sweep follows a path as far as it goes without having to
+    // double back, so this usually settles in a couple of sweeps rather than one per room along the path.
+    // The first sweep fills along every row, after which a row only needs another look when its neighbour changes:
+    for (bool changed = true, first = true; changed; first = false) {
+        changed = false;
+        for (int64_t y = 0; y < mask->height; ++y) {
+            changed |= Dungeon_SpreadRow(
+                &mask->reached[y * rowWords],
+                (y > 0) ? &mask->reached[(y - 1) * rowWords] : NULL,
+                &mask->passable[y * rowWords],
+                rowWords,
+                first
+            );
+        }
+        if (mask->reached[targetWord] & targetBit) {
+            return true;
+        }
+        for (int64_t y = mask->height - 1; y >= 0; --y) {
+            changed |= Dungeon_SpreadRow(
+                &mask->reached[y * rowWords],
+                (y + 1 < mask->height) ? &mask->reached[(y + 1) * rowWords] : NULL,
+                &mask->passable[y * rowWords],
+                rowWords,
+                false
+            );
+        }
+        if (mask->reached[targetWord] & targetBit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reach every passable room in a row next to a reached room in 'neighbour' (the row above or below, or NULL),
+// then everything along the row connected to a reached room. Rows are skipped when 'neighbour' has nothing new
+// for them, unless 'force' is set (for rows that may not have been filled along yet).
+// Returns whether anything new was reached.
+static bool Dungeon_SpreadRow(
+    uint64_t *const restrict reached,
+    const uint64_t *const restrict neighbour,
+    const uint64_t *const restrict passable,
+    const int64_t rowWords,
+    const bool force
+) {
+    uint64_t fresh = 0;
+    const uint64_t forced = force ? UINT64_MAX : 0;
+    for (int64_t word = 0; word < rowWords; ++word) {
+        fresh |= reached[word] & forced;
+        fresh |= (neighbour != NULL) ? neighbour[word] & passable[word] & ~reached[word] : 0;
+    }
+    if (fresh == 0) {
+        return false;
+    }
+
+    uint64_t changed = 0;
+    // Fill towards the end of the row, carrying into the next word, then back towards the start:
+    uint64_t carry = 0;
+    for (int64_t word = 0; word < rowWords; ++word) {
+        const uint64_t seeds = (neighbour != NULL) ? reached[word] | neighbour[word] : reached[word];
+        const uint64_t filled = Dungeon_FillUp((seeds | carry) & passable[word], passable[word]);
+        changed |= filled ^ reached[word];
+        reached[word] = filled;
+        carry = filled >> 63;
+    }
+    carry = 0;
+    for (int64_t word = rowWords - 1; word >= 0; --word) {
+        const uint64_t filled = Dungeon_FillDown((reached[word] | (carry << 63)) & passable[word], passable[word]);
+        changed |= filled ^ reached[word];
+        reached[word] = filled;
+        carry = filled & 1;
+    }
+    return changed != 0;
+}
+
+// Cross every pit next to a reached room, returning false if there weren't any.
+static bool Dungeon_CrossPits(DungeonMask *const mask) {
+    const int64_t rowWords = mask->rowWords;
+    const int64_t words = rowWords * mask->height;
+    // Find them all before crossing any, so that a pit is never reached through another pit crossed alongside it:
+    uint64_t found = 0;
+    for (int64_t y = 0; y < mask->height; ++y) {
+        const uint64_t *const reached = &mask->reached[y * rowWords];
+        for (int64_t word = 0; word < rowWords; ++word) {
+            uint64_t near = (reached[word] << 1) | (reached[word] >> 1);
+            near |= (word > 0) ? reached[word - 1] >> 63 : 0;
+            near |= (word + 1 < rowWords) ? reached[word + 1] << 63 : 0;
+            near |= (y > 0) ? reached[word - rowWords] : 0;
+            near |= (y + 1 < mask->height) ? reached[word + rowWords] : 0;
+            const uint64_t frontier = near & mask->pits[y * rowWords + word];
+            mask->frontier[y * rowWords + word] = frontier;
+            found |= frontier;
+        }
+    }
+    for (int64_t i = 0; i < words; ++i) {
+        mask->passable[i] |= mask->frontier[i];
+        mask->reached[i] |= mask->frontier[i];
+        mask->pits[i] &= ~mask->frontier[i];
+    }
+    return found != 0;
+}
+
+// Spread 'seeds' towards higher bits through runs of 'passable' bits, doubling the distance covered at each step.
+static inline uint64_t Dungeon_FillUp(uint64_t seeds, uint64_t passable) {
+    seeds |= passable & (seeds << 1);
+    passable &= passable << 1;
+    seeds |= passable & (seeds << 2);
+    passable &= passable << 2;
+    seeds |= passable & (seeds << 4);
+    passable &= passable << 4;
+    seeds |= passable & (seeds << 8);
+    passable &= passable << 8;
+    seeds |= passable & (seeds << 16);
+    passable &= passable << 16;
+    seeds |= passable & (seeds << 32);
+    return seeds;
+}
+
+// Spread 'seeds' towards lower bits through runs of 'passable' bits (see Dungeon_FillUp()).
+static inline uint64_t Dungeon_FillDown(uint64_t seeds, uint64_t passable) {
+    seeds |= passable & (seeds >> 1);
+    passable &= passable >> 1;
+    seeds |= passable & (seeds >> 2);
+    passable &= passable >> 2;
+    seeds |= passable & (seeds >> 4);
+    passable &= passable >> 4;
+    seeds |= passable & (seeds >> 8);
+    passable &= passable >> 8;
+    seeds |= passable & (seeds >> 16);
+    passable &= passable >> 16;
+    seeds |= passable & (seeds >> 32);
+    return seeds;
+}
+
+// Clear a shortest path from the spawn to the treasure (along the spawn's row, then the treasure's column) by
+// swapping every pit and enemy on it with a harmless room elsewhere, so every room count stays the same.
+// Returns false if there weren't enough harmless rooms to go around (leaving the dungeon partly repaired).
+static bool Dungeon_Repair(Dungeon *const self, Rng *const rng) {
+    vec2 position;
+    Vec2_Set(position, self->spawnPosition);
+    while (true) {
+        const int64_t index = Dungeon_RoomIndex(self, position);
+        const RoomType type = PackedRoom_GetType(self->rooms[index]);
+        if (type == ROOM_PIT || type == ROOM_ENEMY) {
+            const int64_t swapIndex = Dungeon_FindHarmlessRoom(self, rng);
+            if (swapIndex < 0) {
+                return false;
+            }
+            const PackedRoom current = self->rooms[index];
+            self->rooms[index] = self->rooms[swapIndex];
+            self->rooms[swapIndex] = current;
+        }
+        if (Vec2_Equal(position, self->treasurePosition)) {
+            return true;
+        }
+        const int32_t axis = (position[0] != self->treasurePosition[0]) ? 0 : 1;
+        position[axis] += (position[axis] < self->treasurePosition[axis]) ? 1 : -1;
+    }
+}
+
+// Find a random empty, item or trap room off the path Dungeon_Repair() clears, or -1 if there aren't any.
+static int64_t Dungeon_FindHarmlessRoom(const Dungeon *const self, Rng *const rng) {
+    const int64_t totalRooms = Dungeon_RoomCount(self);
+    int64_t index = 0;
+    for (int64_t i = 0; i < dungeonRepairSamples + totalRooms; ++i) {
+        // Sample at first, then scan from there in case harmless rooms are rare (or the dungeon is tiny):
+        index = (i < dungeonRepairSamples) ? RandRangei64(rng, 0, totalRooms) : (index + 1) % totalRooms;
+        const vec2 position = { (vec2_scalar)(index % self->size[0]), (vec2_scalar)(index / self->size[0]) };
+        const RoomType type = PackedRoom_GetType(self->rooms[index]);
+        if ((type == ROOM_EMPTY || type == ROOM_ITEM || type == ROOM_TRAP) && !Dungeon_IsOnCorridor(self, position)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// Check whether 'position' lies on the path Dungeon_Repair() clears.
+static bool Dungeon_IsOnCorridor(const Dungeon *const self, const vec2 position) {
+    const vec2_scalar *const spawn = self->spawnPosition;
+    const vec2_scalar *const treasure = self->treasurePosition;
+    return (position[1] == spawn[1]
+            && position[0] >= Min(spawn[0], treasure[0])
+            && position[0] <= Max(spawn[0], treasure[0]))
+        || (position[0] == treasure[0]
+            && position[1] >= Min(spawn[1], treasure[1])
+            && position[1] <= Max(spawn[1], treasure[1]));
+}
+
+// Draw how many of 'successes' special items out of 'population' are among 'draws' taken without replacement,
+// i.e. how many rooms of a type land in one part of a shuffled dungeon.
+static int64_t Dungeon_SampleHypergeometric(
+    Rng *const rng,
+    const int64_t population,
+    const int64_t successes,
+    const int64_t draws
+) {
+    assert(successes >= 0 && successes <= population);
+    assert(draws >= 0 && draws <= population);
+
+    // The items that aren't special, and the items that aren't drawn, split the same way mirrored - so only ever work
+    // with at most half the population on either side, which keeps the exact paths below short:
+    if (successes * 2 > population) {
+        return draws - Dungeon_SampleHypergeometric(rng, population, population - successes, draws);
+    }
+    if (draws * 2 > population) {
+        return successes - Dungeon_SampleHypergeometric(rng, population, successes, population - draws);
+    }
+
+    // The result is symmetric in 'successes' and 'draws', so (exactly) place each of the smaller ones in turn:
+    const int64_t small = Min(successes, draws);
+    const int64_t large = Max(successes, draws);
+    if (small <= dungeonExactSplitLimit) {
+        int64_t count = 0;
+        for (int64_t i = 0; i < small; ++i) {
+            count += RandRangei64(rng, 0, population - i) < large - count;
+        }
+        return count;
+    }
+
+    const double fraction = (double)successes / (double)population;
+    const double mean = (double)draws * fraction;
+    const double variance = mean * (1.0 - fraction) * (double)(population - draws) / (double)(population - 1);
+    if (variance < dungeonExactSplitVariance) {
+        // Too few are expected for a normal approximation to be any good (e.g. a rare room type spread over many
+        // tiles), so invert the exact distribution instead, stepping up through the chance of each count from 0:
+        double chance = 1.0;
+        for (int64_t i = 0; i < small; ++i) {
+            chance *= (double)(population - large - i) / (double)(population - i);
+        }
+        double uniform = (double)(Rng_Next64(rng) >> 11) * (1.0 / 9007199254740992.0);
+        int64_t count = 0;
+        while (uniform >= chance && count < small) {
+            uniform -= chance;
+            chance *= (double)(small - count) * (double)(large - count)
+                / ((double)(count + 1) * (double)(population - small - large + count + 1));
+            ++count;
+        }
+        return count;
+    }
+
+    // Otherwise a normal approximation is close (using the Irwin-Hall sum of 12 uniforms). Only basic arithmetic and
+    // sqrt() are used, which IEEE-754 requires to be correctly rounded, so results are the same everywhere:
+    double normal = -6.0;
+    for (int32_t i = 0; i < 12; ++i) {
+        normal += (double)Rng_Next(rng) * (1.0 / 4294967296.0);
+    }
+    const int64_t count = (int64_t)(mean + sqrt(variance) * normal + 0.5);
+    return Clamp(count, 0, small);
+}
+
+static RoomTableEntry* RoomTable_Find(const RoomTable *const self, const uint64_t key) {
+    if (self->capacity == 0) {
+        return NULL;
+    }
+
+    const uint64_t mask = (uint64_t)self->capacity - 1;
+    for (uint64_t slot = Rng_Hash64(key) & mask;; slot = (slot + 1) & mask) {
+        RoomTableEntry *const entry = &self->entries[slot];
+        if (entry->key == key || entry->key == roomTableEmptyKey) {
+            return entry;
+        }
+    }
+}
+
+static void RoomTable_Copy(RoomTable *const self, const RoomTable *const source) {
+    *self = *source;
+    if (source->capacity > 0) {
+        self->entries = malloc(sizeof(self->entries[0]) * (size_t)source->capacity);
+        assert(self->entries != NULL);
+        memcpy(self->entries, source->entries, sizeof(self->entries[0]) * (size_t)source->capacity);
+    }
+}
+
+static void RoomTable_Grow(RoomTable *const self) {
+    const RoomTable previous = *self;
+
+    self->capacity = Max(previous.capacity * 2, 64);
+    self->count = 0;
+    self->entries = malloc(sizeof(self->entries[0]) * (size_t)self->capacity);
+    assert(self->entries != NULL);
+    for (int64_t i = 0; i < self->capacity; ++i) {
+        self->entries[i].key = roomTableEmptyKey;
+    }
+
+    for (int64_t i = 0; i < previous.capacity; ++i) {
+        const RoomTableEntry *const entry = &previous.entries[i];
+        if (entry->key != roomTableEmptyKey) {
+            *RoomTable_Find(self, entry->key) = *entry;
+            self->count += 1;
+        }
+    }
+    free(previous.entries);
+}
+
+void Room_Init(Room *const self, const RoomType type, const Sampler *const items, Rng *const rng) {
+    switch (type) {
+        case ROOM_EMPTY: {
+            Room_InitEmpty(self);
+        } break;
+        case ROOM_ITEM: {
+            Room_InitItem(self, items, rng);
+        } break;
+        case ROOM_PIT: {
+            Room_InitPit(self);
+        } break;
+        case ROOM_TRAP: {
+            Room_InitTrap(self, rng);
+        } break;
+        case ROOM_ENEMY: {
+            Room_InitEnemy(self, rng);
+        } break;
+        case ROOM_TREASURE: {
+            Room_InitTreasure(self);
+        } break;
+        case ROOM_SPAWN: {
+            Room_InitSpawn(self);
+        } break;
+        case _ROOM_TYPE_COUNT: {
+            assert(false);
+        } break;
+    }
 }
 
 void Room_InitEmpty(Room *const self) {
@@ -127,11 +1061,14 @@ void Room_InitEmpty(Room *const self) {
     };
 }
 
-void Room_InitItem(Room *const self) {
+void Room_InitItem(Room *const self, const Sampler *const items, Rng *const rng) {
     assert(self != NULL);
+    assert(items != NULL);
+    assert(items->count == _ITEM_TYPE_COUNT);
+    assert(rng != NULL);
     *self = (Room) {
         .type = ROOM_ITEM,
-        .item = (ItemType)RandRangei32(0, _ITEM_TYPE_COUNT),
+        .item = (ItemType)Sampler_Sample(items, rng),
     };
 }
 
@@ -143,23 +1080,25 @@ void Room_InitPit(Room *const self) {
     };
 }
 
-void Room_InitTrap(Room *const self) {
+void Room_InitTrap(Room *const self, Rng *const rng) {
     assert(self != NULL);
+    assert(rng != NULL);
     *self = (Room) {
         .type = ROOM_TRAP,
         .trap = {
-            .maxDamage = (int8_t)RandRangei32(2, 6),
+            .maxDamage = (int8_t)RandRangei32(rng, 2, 6),
         },
     };
 }
 
-void Room_InitEnemy(Room *const self) {
+void Room_InitEnemy(Room *const self, Rng *const rng) {
     assert(self != NULL);
+    assert(rng != NULL);
     *self = (Room) {
         .type = ROOM_ENEMY,
         .enemy = {
-            .health = (int8_t)RandRangei32(4, 8),
-            .maxDamage = (int8_t)RandRangei32(3, 6),
+            .health = (int8_t)RandRangei32(rng, 4, 8),
+            .maxDamage = (int8_t)RandRangei32(rng, 3, 6),
         },
     };
 }
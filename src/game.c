@@ -0,0 +1,466 @@
+#include "dungeon/game.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dungeon/action_table.h"
+#include "dungeon/item.h"
+#include "dungeon/profile.h"
+#include "dungeon/util.h"
+
+static Action Action_Lookup(const char* input);
+static void Game_PushEvent(StepResult* result, GameEventType type, int8_t amount, uint8_t detail);
+static void Game_EnterRoom(GameState* self, StepResult* result);
+static void Game_LeaveRoom(GameState* self);
+static void Game_FinishStep(GameState* self, StepResult* result);
+
+static bool Game_HandleCommonAction(GameState* self, Action action, StepResult* result);
+static bool Game_HandleMovementAction(GameState* self, Action action, StepResult* result);
+static bool Game_HandlePitAction(GameState* self, Action action, StepResult* result);
+static bool Game_HandleEnemyAction(GameState* self, Action action, StepResult* result);
+
+Action Action_Parse(const char *const input) {
+    assert(input != NULL);
+    PROFILE_BEGIN(PROFILE_ZONE_ACTION_PARSE);
+    const Action action = Action_Lookup(input);
+    PROFILE_END(PROFILE_ZONE_ACTION_PARSE);
+    return action;
+}
+
+static Action Action_Lookup(const char *const input) {
+    // Fold case up-front, rejecting anything longer than the longest command:
+    char command[ACTION_TABLE_MAX_LENGTH + 1] = { 0 };
+    int32_t length = 0;
+    for (; input[length] != '\0'; ++length) {
+        if (length == ACTION_TABLE_MAX_LENGTH) {
+            return ACTION_NONE;
+        }
+        command[length] = (char)tolower((unsigned char)input[length]);
+    }
+
+    // The table is a perfect hash, so the only word that could match is the one in this slot:
+    const uint32_t slot = Action_HashCommand(command, length, ACTION_TABLE_SEED) & (ACTION_TABLE_SIZE - 1);
+    const ActionTableEntry *const entry = &actionTable[slot];
+    if (length == 0 || memcmp(entry->word, command, (size_t)length + 1) != 0) {
+        return ACTION_NONE;
+    }
+    return (Action)entry->action;
+}
+
+bool Action_GetMovement(const Action self, vec2 outDirection) {
+    assert(outDirection != NULL);
+    switch (self) {
+        case ACTION_FORWARD: {
+            Vec2_Set(outDirection, (vec2) { 0, 1 });
+        } break;
+        case ACTION_BACK: {
+            Vec2_Set(outDirection, (vec2) { 0, -1 });
+        } break;
+        case ACTION_LEFT: {
+            Vec2_Set(outDirection, (vec2) { -1, 0 });
+        } break;
+        case ACTION_RIGHT: {
+            Vec2_Set(outDirection, (vec2) { 1, 0 });
+        } break;
+        default: {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t Game_Hash(const GameState *const self) {
+    assert(self != NULL);
+
+    const Player *const player = &self->player;
+    uint64_t hash = Dungeon_Hash(self->dungeon);
+    for (int32_t i = 0; i < 2; ++i) {
+        hash = Rng_HashCombine(hash, (uint32_t)player->position.current[i]);
+        hash = Rng_HashCombine(hash, (uint32_t)player->position.previous[i]);
+    }
+    hash = Rng_HashCombine(hash, ((uint64_t)(uint8_t)player->health.current << 8) | (uint8_t)player->health.max);
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        hash = Rng_HashCombine(hash, player->inventory[i]);
+    }
+    hash = Rng_HashCombine(hash, self->rng.state);
+    hash = Rng_HashCombine(hash, self->rng.increment);
+    hash = Rng_HashCombine(hash, ((uint64_t)self->encounter << 8) | (uint64_t)self->status);
+    return hash;
+}
+
+int32_t Game_GetJumpSuccessPercentage(const Player *const player) {
+    assert(player != NULL);
+    // The more gear you carry, the harder it is to clear a pit:
+    int32_t successPercentage = 85;
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        successPercentage -= player->inventory[i] * 3;
+    }
+    return successPercentage;
+}
+
+void Game_Init(GameState *const self, Dungeon *const dungeon, const Rng *const rng) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+    assert(rng != NULL);
+
+    *self = (GameState) {
+        .dungeon = dungeon,
+        .rng = *rng,
+        .encounter = ENCOUNTER_NONE,
+        .status = GAME_STATUS_PLAYING,
+        // Nothing has been drawn yet:
+        .dirtyRooms = {
+            .overflowed = true,
+        },
+    };
+    Game_InitPlayer(&self->player, dungeon->spawnPosition);
+}
+
+void Game_InitPlayer(Player *const player, const vec2 spawnPosition) {
+    assert(player != NULL);
+
+    *player = (Player) {
+        .position = {
+            .current = { spawnPosition[0], spawnPosition[1] },
+            // This is only used for direction, so spawn facing north:
+            .previous = { spawnPosition[0], spawnPosition[1] - 1 },
+        },
+        .health = {
+            .max = GAME_PLAYER_MAX_HEALTH,
+            .current = GAME_PLAYER_MAX_HEALTH,
+        },
+    };
+
+    player->inventory[ITEM_FOOD] = 5;
+    player->inventory[ITEM_ROPE] = 1;
+    player->inventory[ITEM_HOOK] = 1;
+}
+
+void Game_Fork(const GameState *const parent, GameState *const outChild) {
+    assert(parent != NULL);
+    assert(outChild != NULL);
+
+    *outChild = *parent;
+    outChild->dungeon = Dungeon_Fork(parent->dungeon);
+}
+
+StepResult Game_Start(GameState *const self) {
+    assert(self != NULL);
+    assert(self->status == GAME_STATUS_PLAYING);
+
+    StepResult result = { 0 };
+    Game_EnterRoom(self, &result);
+    Game_FinishStep(self, &result);
+    return result;
+}
+
+StepResult Game_Resume(GameState *const self) {
+    assert(self != NULL);
+    assert(self->status == GAME_STATUS_PLAYING);
+
+    // The room was already entered when the game was started or stepped, so only say where things stand.
+    // (Jumping a pit leaves the player in the pit's room, so describing the room could offer the wrong actions.)
+    StepResult result = { 0 };
+    Game_PushEvent(&result, GAME_EVENT_HEALTH, 0, 0);
+    Game_PushEvent(&result, GAME_EVENT_HELP, 0, (uint8_t)self->encounter);
+    Game_FinishStep(self, &result);
+    return result;
+}
+
+StepResult Game_Step(GameState *const self, const Action action) {
+    assert(self != NULL);
+    assert(self->status == GAME_STATUS_PLAYING);
+
+    PROFILE_BEGIN(PROFILE_ZONE_GAME_STEP);
+    PROFILE_COUNT(PROFILE_COUNTER_COMMANDS, 1);
+    StepResult result = { 0 };
+
+    bool handled = false;
+    switch (self->encounter) {
+        case ENCOUNTER_NONE: {
+            PROFILE_BEGIN(PROFILE_ZONE_HANDLE_MOVEMENT);
+            handled = Game_HandleMovementAction(self, action, &result);
+            PROFILE_END(PROFILE_ZONE_HANDLE_MOVEMENT);
+        } break;
+        case ENCOUNTER_PIT: {
+            PROFILE_BEGIN(PROFILE_ZONE_HANDLE_PIT);
+            handled = Game_HandlePitAction(self, action, &result);
+            PROFILE_END(PROFILE_ZONE_HANDLE_PIT);
+        } break;
+        case ENCOUNTER_ENEMY: {
+            PROFILE_BEGIN(PROFILE_ZONE_HANDLE_ENEMY);
+            handled = Game_HandleEnemyAction(self, action, &result);
+            PROFILE_END(PROFILE_ZONE_HANDLE_ENEMY);
+        } break;
+    }
+
+    if (!handled) {
+        PROFILE_BEGIN(PROFILE_ZONE_HANDLE_COMMON);
+        if (!Game_HandleCommonAction(self, action, &result)) {
+            Game_PushEvent(&result, GAME_EVENT_UNRECOGNISED, 0, (uint8_t)action);
+        }
+        PROFILE_END(PROFILE_ZONE_HANDLE_COMMON);
+    }
+
+    Game_FinishStep(self, &result);
+    PROFILE_END(PROFILE_ZONE_GAME_STEP);
+    return result;
+}
+
+static void Game_PushEvent(
+    StepResult *const result,
+    const GameEventType type,
+    const int8_t amount,
+    const uint8_t detail
+) {
+    assert(result != NULL);
+    assert(result->eventCount < GAME_MAX_EVENTS);
+    result->events[result->eventCount++] = (GameEvent) {
+        .type = type,
+        .amount = amount,
+        .detail = detail,
+    };
+}
+
+static void Game_EnterRoom(GameState *const self, StepResult *const result) {
+    Player *const player = &self->player;
+    Room room = Game_GetCurrentRoom(self);
+
+    self->encounter = ENCOUNTER_NONE;
+    Game_PushEvent(result, GAME_EVENT_ROOM_ENTERED, 0, (uint8_t)room.type);
+    // The player has moved out of the previous room and into (or turned around in) this one:
+    Game_MarkDirty(self, player->position.previous);
+    Game_MarkDirty(self, player->position.current);
+
+    switch (room.type) {
+        case ROOM_EMPTY:
+        case ROOM_SPAWN: {
+        } break;
+        case ROOM_ITEM: {
+            player->inventory[room.item] += 1;
+            Game_PushEvent(result, GAME_EVENT_ITEM_FOUND, 0, (uint8_t)room.item);
+            Room_Clear(&room);
+            Game_SetCurrentRoom(self, &room);
+        } break;
+        case ROOM_PIT: {
+            self->encounter = ENCOUNTER_PIT;
+        } break;
+        case ROOM_TRAP: {
+            const int8_t damage = (int8_t)RandRangei32(&self->rng, 1, room.trap.maxDamage + 1);
+            Player_AdjustHealth(player, -damage);
+            Game_PushEvent(result, GAME_EVENT_TRAP_TRIGGERED, damage, 0);
+
+            room.trap.maxDamage -= (int8_t)RandRangei32(&self->rng, 1, 3);
+            if (room.trap.maxDamage <= 0) {
+                Game_PushEvent(result, GAME_EVENT_TRAP_DESTROYED, 0, 0);
+                Room_Clear(&room);
+            }
+            Game_SetCurrentRoom(self, &room);
+        } break;
+        case ROOM_ENEMY: {
+            self->encounter = ENCOUNTER_ENEMY;
+        } break;
+        case ROOM_TREASURE: {
+            Game_PushEvent(result, GAME_EVENT_TREASURE_FOUND, 0, 0);
+            self->status = GAME_STATUS_WON;
+        } break;
+        case _ROOM_TYPE_COUNT: {
+            assert(false);
+        } break;
+    }
+}
+
+static void Game_LeaveRoom(GameState *const self) {
+    // The room itself was already marked as visited at the end of the previous step:
+    self->encounter = ENCOUNTER_NONE;
+}
+
+static void Game_FinishStep(GameState *const self, StepResult *const result) {
+    if (self->status == GAME_STATUS_PLAYING) {
+        // Need to mark this after handling the room incase the room is cleared:
+        if (!Dungeon_IsVisited(self->dungeon, self->player.position.current)) {
+            Dungeon_MarkVisited(self->dungeon, self->player.position.current);
+            Game_MarkDirty(self, self->player.position.current);
+        }
+
+        if (self->player.health.current <= 0) {
+            Game_PushEvent(result, GAME_EVENT_DIED, 0, 0);
+            self->status = GAME_STATUS_DIED;
+        }
+    }
+    result->status = self->status;
+}
+
+static bool Game_HandleCommonAction(GameState *const self, const Action action, StepResult *const result) {
+    Player *const player = &self->player;
+    switch (action) {
+        case ACTION_EXIT: {
+            player->health.current = 0;
+        } break;
+        case ACTION_HELP: {
+            Game_PushEvent(result, GAME_EVENT_HELP, 0, (uint8_t)self->encounter);
+        } break;
+        case ACTION_MAP: {
+            Game_PushEvent(result, GAME_EVENT_MAP, 0, 0);
+        } break;
+        case ACTION_HEALTH: {
+            Game_PushEvent(result, GAME_EVENT_HEALTH, 0, 0);
+        } break;
+        case ACTION_INVENTORY: {
+            Game_PushEvent(result, GAME_EVENT_INVENTORY, 0, 0);
+        } break;
+        case ACTION_FOOD: {
+            if (player->inventory[ITEM_FOOD] == 0) {
+                Game_PushEvent(result, GAME_EVENT_FOOD_EMPTY, 0, 0);
+            } else if (player->health.current >= player->health.max) {
+                Game_PushEvent(result, GAME_EVENT_FOOD_FULL, 0, 0);
+            } else {
+                const int8_t health = (int8_t)RandRangei32(&self->rng, 1, 6);
+                Player_AdjustHealth(player, health);
+                player->inventory[ITEM_FOOD] -= 1;
+                Game_PushEvent(result, GAME_EVENT_FOOD_EATEN, health, 0);
+            }
+        } break;
+        default: {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool Game_HandleMovementAction(GameState *const self, const Action action, StepResult *const result) {
+    Player *const player = &self->player;
+
+    vec2 direction;
+    if (!Action_GetMovement(action, direction)) {
+        return false;
+    }
+
+    vec2 currentPosition, previousPosition;
+    Vec2_Set(currentPosition, player->position.current);
+    Vec2_Set(previousPosition, player->position.previous);
+
+    Player_Move(player, direction);
+
+    if (!Dungeon_Contains(self->dungeon, player->position.current)) {
+        Vec2_Set(player->position.current, currentPosition);
+        Vec2_Set(player->position.previous, previousPosition);
+        Game_PushEvent(result, GAME_EVENT_WALL, 0, 0);
+        return true;
+    }
+
+    Game_LeaveRoom(self);
+    Game_PushEvent(result, GAME_EVENT_MOVED, 0, (uint8_t)action);
+    Game_EnterRoom(self, result);
+    return true;
+}
+
+static bool Game_HandlePitAction(GameState *const self, const Action action, StepResult *const result) {
+    Player *const player = &self->player;
+    Room room = Game_GetCurrentRoom(self);
+    assert(room.type == ROOM_PIT);
+
+    switch (action) {
+        case ACTION_JUMP: {
+            if (RandRangei32(&self->rng, 0, 100) < Game_GetJumpSuccessPercentage(player)) {
+                Game_PushEvent(result, GAME_EVENT_PIT_JUMPED, 0, 0);
+                self->encounter = ENCOUNTER_NONE;
+            } else {
+                Game_PushEvent(result, GAME_EVENT_PIT_FELL, 0, 0);
+                player->health.current = 0;
+            }
+        } break;
+        case ACTION_SWING: {
+            if (player->inventory[ITEM_HOOK] > 0 && player->inventory[ITEM_ROPE] > 0) {
+                player->inventory[ITEM_HOOK] -= 1;
+                player->inventory[ITEM_ROPE] -= 1;
+                Game_PushEvent(result, GAME_EVENT_PIT_SWUNG, 0, 0);
+                Room_Clear(&room);
+                Game_SetCurrentRoom(self, &room);
+                Game_LeaveRoom(self);
+                Game_EnterRoom(self, result);
+            } else {
+                Game_PushEvent(result, GAME_EVENT_PIT_SWING_FAILED, 0, 0);
+            }
+        } break;
+        case ACTION_RETURN: {
+            Game_PushEvent(result, GAME_EVENT_PIT_RETURNED, 0, 0);
+            Game_LeaveRoom(self);
+            Player_Move(player, (vec2) { 0, -1 });
+            Game_EnterRoom(self, result);
+        } break;
+        default: {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool Game_HandleEnemyAction(GameState *const self, const Action action, StepResult *const result) {
+    Player *const player = &self->player;
+    Room room = Game_GetCurrentRoom(self);
+    assert(room.type == ROOM_ENEMY);
+
+    switch (action) {
+        case ACTION_FIGHT: {
+            const bool hasSword = player->inventory[ITEM_SWORD] > 0;
+            const int8_t damage = hasSword
+                ? (int8_t)RandRangei32(&self->rng, 3, 6)
+                : (int8_t)RandRangei32(&self->rng, 0, 4);
+            room.enemy.health -= damage;
+            Game_PushEvent(result, GAME_EVENT_ENEMY_HIT, damage, hasSword);
+
+            if (room.enemy.health <= 0) {
+                Game_PushEvent(result, GAME_EVENT_ENEMY_DEFEATED, 0, 0);
+                Room_Clear(&room);
+                Game_SetCurrentRoom(self, &room);
+                self->encounter = ENCOUNTER_NONE;
+                break;
+            }
+            Game_SetCurrentRoom(self, &room);
+
+            if (player->inventory[ITEM_SHIELD] > 0) {
+                const int8_t shieldDamage = (int8_t)RandRangei32(&self->rng, 0, 3);
+                Player_AdjustHealth(player, -shieldDamage);
+                Game_PushEvent(result, GAME_EVENT_SHIELD_HIT, shieldDamage, 0);
+
+                if (Randf32(&self->rng) > 0.5f) {
+                    Game_PushEvent(result, GAME_EVENT_SHIELD_BROKEN, 0, 0);
+                    player->inventory[ITEM_SHIELD] -= 1;
+                }
+            } else {
+                const int8_t enemyDamage = (int8_t)RandRangei32(&self->rng, 1, room.enemy.maxDamage);
+                Player_AdjustHealth(player, -enemyDamage);
+                Game_PushEvent(result, GAME_EVENT_PLAYER_HIT, enemyDamage, 0);
+            }
+        } break;
+        case ACTION_FLEE: {
+            const float rng = Randf32(&self->rng);
+            if (rng > 0.5f) {
+                int8_t damage = 0;
+                if (rng <= 0.8f) {
+                    damage = (int8_t)RandRangei32(&self->rng, 1, room.enemy.maxDamage);
+                    Player_AdjustHealth(player, -damage);
+                }
+                Game_PushEvent(result, GAME_EVENT_FLED, damage, 0);
+
+                Game_LeaveRoom(self);
+                Player_Move(player, (vec2) { 0, -1 });
+                if (player->health.current > 0) {
+                    Game_EnterRoom(self, result);
+                }
+            } else {
+                const int8_t damage = (int8_t)RandRangei32(&self->rng, 1, room.enemy.maxDamage);
+                Player_AdjustHealth(player, -damage);
+                Game_PushEvent(result, GAME_EVENT_FLEE_FAILED, damage, 0);
+            }
+        } break;
+        default: {
+            return false;
+        }
+    }
+    return true;
+}
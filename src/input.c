@@ -0,0 +1,133 @@
+#include "dungeon/input.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#define read _read
+#define isatty _isatty
+#else
+#include <unistd.h>
+#endif
+
+#include "dungeon/util.h"
+
+static bool InputReader_Fill(InputReader* self);
+static inline bool Input_IsWhitespace(char c);
+
+void InputReader_Init(InputReader *const self, const int32_t fd) {
+    assert(self != NULL);
+    self->fd = fd;
+    self->closed = false;
+    self->start = 0;
+    self->end = 0;
+}
+
+bool InputReader_IsInteractive(const InputReader *const self) {
+    assert(self != NULL);
+    return isatty(self->fd) != 0;
+}
+
+bool InputReader_HasBufferedToken(const InputReader *const self) {
+    assert(self != NULL);
+    int32_t i = self->start;
+    while (i < self->end && Input_IsWhitespace(self->buffer[i])) {
+        ++i;
+    }
+    if (i == self->end) {
+        return false;
+    }
+    // A token is only complete once it's followed by whitespace (or the end of the input):
+    while (i < self->end && !Input_IsWhitespace(self->buffer[i])) {
+        ++i;
+    }
+    return i < self->end || self->closed;
+}
+
+InputStatus InputReader_Next(InputReader *const self, const char **const outToken) {
+    assert(self != NULL);
+    assert(outToken != NULL);
+
+    // Skip leading whitespace:
+    for (;;) {
+        while (self->start < self->end && Input_IsWhitespace(self->buffer[self->start])) {
+            ++self->start;
+        }
+        if (self->start < self->end) {
+            break;
+        }
+        if (!InputReader_Fill(self)) {
+            return INPUT_END;
+        }
+    }
+
+    // Find the end of the token, reading more if it runs off the end of the buffer:
+    int32_t length = 0;
+    for (;;) {
+        while (self->start + length < self->end && !Input_IsWhitespace(self->buffer[self->start + length])) {
+            ++length;
+            if (length > INPUT_MAX_TOKEN_LENGTH) {
+                break;
+            }
+        }
+        if (self->start + length < self->end || length > INPUT_MAX_TOKEN_LENGTH || !InputReader_Fill(self)) {
+            break;
+        }
+    }
+
+    if (length > INPUT_MAX_TOKEN_LENGTH) {
+        // Keep the start of the token to report back, then throw away the rest of it:
+        memcpy(self->truncated, &self->buffer[self->start], INPUT_MAX_TOKEN_LENGTH);
+        self->truncated[INPUT_MAX_TOKEN_LENGTH] = '\0';
+        *outToken = self->truncated;
+        for (;;) {
+            while (self->start < self->end && !Input_IsWhitespace(self->buffer[self->start])) {
+                ++self->start;
+            }
+            if (self->start < self->end || !InputReader_Fill(self)) {
+                return INPUT_TOO_LONG;
+            }
+        }
+    }
+
+    // Terminate in-place (overwriting the whitespace, or using the spare byte at the end of the buffer):
+    char *const token = &self->buffer[self->start];
+    token[length] = '\0';
+    *outToken = token;
+    self->start += Min(length + 1, self->end - self->start);
+    return INPUT_TOKEN;
+}
+
+// Read another chunk into the buffer (keeping any unread bytes), returning false if nothing more could be read.
+static bool InputReader_Fill(InputReader *const self) {
+    if (self->closed) {
+        return false;
+    }
+
+    // Shuffle whatever hasn't been consumed yet back to the start to make room:
+    const int32_t remaining = self->end - self->start;
+    if (self->start > 0) {
+        memmove(self->buffer, &self->buffer[self->start], (size_t)remaining);
+        self->start = 0;
+        self->end = remaining;
+    }
+    if (self->end == INPUT_BUFFER_SIZE) {
+        return false;
+    }
+
+    const int32_t capacity = INPUT_BUFFER_SIZE - self->end;
+    const int32_t length = (int32_t)read(self->fd, &self->buffer[self->end], (unsigned)capacity);
+    if (length <= 0) {
+        self->closed = true;
+        return false;
+    }
+    self->end += length;
+    return true;
+}
+
+static inline bool Input_IsWhitespace(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -6,555 +8,345 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/input.h"
 #include "dungeon/item.h"
+#include "dungeon/output.h"
 #include "dungeon/player.h"
+#include "dungeon/profile.h"
+#include "dungeon/render.h"
+#include "dungeon/replay.h"
+#include "dungeon/rng.h"
+#include "dungeon/snapshot.h"
+#include "dungeon/text.h"
 #include "dungeon/util.h"
 #include "dungeon/vec2.h"
 
 const vec2 defaultDungeonSize = { 10, 10 };
-
-const char commonActionsText[] =
-    "Common Actions:\n"
-    "| 'exit' - quit\n"
-    "| 'help' - show this menu\n"
-    "| 'map' - display your current position and orientation,\n"
-    "|         as well as a map of previously explored rooms\n"
-    "| 'health' - show the amount of HEALTH you have remaining\n"
-    "| 'inventory' - display the totals of each item in your INVENTORY\n"
-    "| 'food' - consume 1 FOOD to regain HEALTH";
-
-const char movementActionsText[] =
-    "Movement Actions:\n"
-    "| 'forward' - move into the room you are currently facing\n"
-    "| 'back' - turn around and move back into the previous room\n"
-    "| 'left' - turn anti-clockwise and move into the next room\n"
-    "| 'right' - turn clockwise and move into the next room";
-
-const char pitActionsText[] =
-    "Pit Actions:\n"
-    "| 'jump' - attempt to jump across the pit, keeping in mind\n"
-    "|          that your gear's weight will influence your chances\n"
-    "| 'swing' - use 1 ROPE and 1 HOOK to guarrantee safe passage\n"
-    "| 'return' - retreat back into the previous room";
-
-const char enemyActionsText[] =
-    "Combat Actions:\n"
-    "| 'fight' - attack the enemy (your chances will improve with a SWORD)\n"
-    "| 'flee' - attempt to escape to the previous room";
-
-#define CheckInput(action, input) (String_CompareLiteral_IgnoreCase(action, input) == 0)
-
-bool IsGameOver(const Dungeon* dungeon, const Player* player);
-
-void HandleRoom_GeneralInput(char input[32], Dungeon* dungeon, Player* player, Room* room);
-void HandleRoom_Item(char input[32], Dungeon* dungeon, Player* player, Room* room);
-void HandleRoom_Pit(char input[32], Dungeon* dungeon, Player* player, Room* room);
-void HandleRoom_Trap(char input[32], Dungeon* dungeon, Player* player, Room* room);
-void HandleRoom_Enemy(char input[32], Dungeon* dungeon, Player* player, Room* room);
-
-bool HandleInput_CommonActions(const char* input, Dungeon* dungeon, Player* player);
-bool HandleInput_MovementActions(const char* input, Dungeon* dungeon, Player* player);
-
-void PrintMap(const Dungeon* dungeon, const Player* player, bool onlyVisited);
+// Write out buffered output once it gets this big, even if there are more commands waiting:
+const size_t maxBufferedOutput = 65536;
+
+typedef struct MapDisplay {
+    // Only show this many rooms either side of the player (0 shows the whole dungeon):
+    int32_t viewportRadius;
+    // Keep the map pinned to the top of the terminal, and only repaint the rooms that change each step:
+    bool ansi;
+    // ANSI mode only - whether the map is on screen yet, and which part of the dungeon it shows:
+    bool drawn;
+    RenderWindow window;
+} MapDisplay;
+
+void AppendMap(void* context, RenderBuffer* output, const GameState* game, bool onlyVisited);
+void AppendMapRefresh(MapDisplay* display, RenderBuffer* output, GameState* game);
+void AppendPinnedMap(MapDisplay* display, RenderBuffer* output, const GameState* game, bool onlyVisited);
+RenderWindow GetMapWindow(const MapDisplay* display, const GameState* game);
+bool ParseOutputMode(const char* name, OutputMode* outMode);
+bool ParseDistribution(const char* value, int32_t outDistribution[_ROOM_TYPE_COUNT]);
+bool ParseViewportRadius(const char* value, int32_t* outRadius);
 
 int32_t main(const int32_t argc, const char *const argv[]) {
-    if (argc > 1) {
+    MapDisplay display = { 0 };
+    OutputMode outputMode = OUTPUT_TEXT;
+    const char* loadPath = NULL;
+    const char* savePath = NULL;
+    const char* recordPath = NULL;
+    const char* profilePath = NULL;
+    uint64_t seed = (uint64_t)time(NULL);
+    DungeonParams params = DungeonParams_Default(defaultDungeonSize);
+    for (int32_t i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--ansi") == 0) {
+            display.ansi = true;
+        } else if (strcmp(argv[i], "--viewport") == 0 && i + 1 < argc
+            && ParseViewportRadius(argv[i + 1], &display.viewportRadius)) {
+            ++i;
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc && ParseOutputMode(argv[i + 1], &outputMode)) {
+            ++i;
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc && String_ParseUint64(argv[i + 1], &seed)) {
+            ++i;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc && String_ParseSize(argv[i + 1], params.size)) {
+            ++i;
+        } else if (strcmp(argv[i], "--distribution") == 0 && i + 1 < argc
+            && ParseDistribution(argv[i + 1], params.roomDistribution)) {
+            ++i;
+        } else {
+            fprintf(
+                stderr,
+                "Usage: %s [--viewport RADIUS] [--ansi] [--output text|ndjson|binary|none]\n"
+                "       [--load PATH] [--save PATH] [--record PATH] [--profile PATH]\n"
+                "       [--seed N] [--size WxH] [--distribution L]\n"
+                "| --viewport RADIUS  only map this many rooms either side of the player (default: 0, the whole map)\n"
+                "| --ansi             keep the map on screen, redrawing only what changes (needs an ANSI terminal)\n"
+                "| --output MODE      report each step as text (default), JSON lines, binary records, or not at all\n"
+                "| --load PATH        resume the game saved at PATH instead of starting a new one\n"
+                "| --save PATH        save the game to PATH when input ends, if it hasn't been won or lost\n"
+                "| --record PATH      log the seed and every command to PATH, to be replayed with dungeon_replay\n"
+                "| --profile PATH     write a Chrome trace to PATH and a summary to stderr (DUNGEON_PROFILE builds)\n"
+                "| --seed N           start from seed N instead of the current time (see dungeon_seeds)\n"
+                "| --size WxH         size of the dungeon (default: 10x10)\n"
+                "| --distribution L   comma-separated room weights in RoomType order, as in dungeon_sim\n",
+                argv[0]
+            );
+            return 1;
+        }
+    }
+    if ((int64_t)params.size[0] * params.size[1] < _ROOM_TYPE_COUNT) {
+        fprintf(stderr, "The dungeon must have at least %d rooms.\n", _ROOM_TYPE_COUNT);
+        return 1;
+    }
+    if (loadPath != NULL && recordPath != NULL) {
+        // A saved game can't be recreated from a seed:
+        fprintf(stderr, "Loaded games can't be recorded.\n");
+        return 1;
+    }
+    if (profilePath != NULL && !Profile_IsEnabled()) {
+        fprintf(stderr, "This build has no profiling - configure with -DDUNGEON_PROFILE=ON.\n");
+        return 1;
+    }
+    // The map is only ever drawn as part of the text output:
+    display.ansi = display.ansi && outputMode == OUTPUT_TEXT;
+
+    if (argc > 1 && outputMode == OUTPUT_TEXT) {
         printf("Launching with %d arg(s):\n", argc);
         for (int32_t i = 0; i < argc; ++i) {
             printf("|  %s\n", argv[i]);
         }
         printf("\n");
     }
+#if defined(_WIN32)
+    if (outputMode == OUTPUT_BINARY) {
+        // Stop newline bytes in records being expanded:
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
 
-    srand((int32_t)time(NULL));
-
-    Dungeon* dungeon = Dungeon_Create(defaultDungeonSize);
-
-    Player player = {
-        .position = {
-            .current = { dungeon->spawnPosition[0], dungeon->spawnPosition[1] },
-            // This is only used for direction, so spawn facing north:
-            .previous = { dungeon->spawnPosition[0], dungeon->spawnPosition[1] - 1 },
-        },
-        .health = {
-            .max = 20,
-            .current = 20,
-        },
+    // Everything the game does follows from this, so it's all a recording needs to start from:
+    const ReplaySetup setup = {
+        .seed = seed,
+        .stream = 0,
+        .params = params,
     };
 
-    player.inventory[ITEM_FOOD] = 5;
-    player.inventory[ITEM_ROPE] = 1;
-    player.inventory[ITEM_HOOK] = 1;
-
-    printf(
-        "--------------------------\n"
-        "Welcome to this dungeon.\n"
-        "You are searching this area for a treasure of great importance.\n"
-        "In each new room various events will occur and further instructions will appear.\n"
-        "\n"
-        "%s\n"
-        "%s\n",
-        commonActionsText,
-        movementActionsText
-    );
+    Dungeon* dungeon = NULL;
+    GameState game;
+    if (loadPath != NULL) {
+        // Everything about the game is restored, including its Rng, so the seed doesn't matter here:
+        dungeon = Snapshot_Load(loadPath, &game);
+        if (dungeon == NULL) {
+            fprintf(stderr, "Couldn't load a saved game from '%s'.\n", loadPath);
+            return 1;
+        }
+    } else {
+        dungeon = ReplaySetup_CreateGame(&setup, &game);
+    }
 
-    char input[32];
-    while (!IsGameOver(dungeon, &player)) {
-        Room *const room = &dungeon->rooms[Dungeon_RoomIndex(dungeon, player.position.current)];
+    ReplayWriter recording;
+    if (recordPath != NULL) {
+        if (!ReplayWriter_Open(&recording, recordPath)) {
+            fprintf(stderr, "Couldn't record to '%s'.\n", recordPath);
+            Dungeon_Destroy(dungeon);
+            return 1;
+        }
+        ReplayWriter_BeginGame(&recording, &setup);
+    }
 
-        printf("--------------------------\n");
+    // Everything each step reports is collected here and written out in one go (reused, so it only grows once):
+    OutputSink sink;
+    OutputSink_Init(&sink, outputMode);
+    sink.appendMap = AppendMap;
+    sink.mapContext = &display;
+
+    // Commands are read in large chunks, so piped input doesn't cost a round trip per command:
+    InputReader reader;
+    InputReader_Init(&reader, 0);
+    const bool interactive = InputReader_IsInteractive(&reader);
+
+    const char* input = "";
+    // A loaded game has already entered the room it was saved in, so mustn't do so again:
+    StepResult result = (loadPath != NULL) ? Game_Resume(&game) : Game_Start(&game);
+    // In ANSI mode, put the map up first so that it doesn't clear the introduction:
+    AppendMapRefresh(&display, &sink.buffer, &game);
+    OutputSink_Welcome(&sink);
+    OutputSink_StepResult(&sink, &game, &result, input);
+
+    while (game.status == GAME_STATUS_PLAYING) {
+        // Only prompt someone who's actually there to read it:
+        OutputSink_Prompt(&sink, &game, interactive);
+        // Hold onto output until we'd otherwise have to wait for more input:
+        if (!InputReader_HasBufferedToken(&reader) || sink.buffer.length >= maxBufferedOutput) {
+            const bool _result = OutputSink_Flush(&sink, stdout);
+            (void)_result;
+            // Keep the recording up to date too, in case this is the last command before a crash:
+            if (recordPath != NULL) {
+                const bool _recorded = ReplayWriter_Flush(&recording);
+                (void)_recorded;
+            }
+        }
 
-        if (room->type == ROOM_TREASURE) {
-            PrintMap(dungeon, &player, false);
-            printf("Congratulations, you have found the treasure!\n");
+        const InputStatus status = InputReader_Next(&reader, &input);
+        if (status == INPUT_END) {
+            // Input was closed, so there's nothing more to do:
             break;
+        } else if (status == INPUT_TOO_LONG) {
+            OutputSink_InputTooLong(&sink, input, INPUT_MAX_TOKEN_LENGTH);
+            continue;
         }
 
-        switch (room->type) {
-            case ROOM_EMPTY: {
-                printf("You come across an empty room.\n");
-                HandleRoom_GeneralInput(input, dungeon, &player, room);
-            } break;
-            case ROOM_SPAWN: {
-                printf("You stand at the entrance to the dungeon.\n");
-                HandleRoom_GeneralInput(input, dungeon, &player, room);
-            } break;
-            case ROOM_ITEM: {
-                HandleRoom_Item(input, dungeon, &player, room);
-            } break;
-            case ROOM_PIT: {
-                HandleRoom_Pit(input, dungeon, &player, room);
-            } break;
-            case ROOM_TRAP: {
-                HandleRoom_Trap(input, dungeon, &player, room);
-            } break;
-            case ROOM_ENEMY: {
-                HandleRoom_Enemy(input, dungeon, &player, room);
-            } break;
-            case ROOM_TREASURE:
-            case _ROOM_TYPE_COUNT: {
-                assert(false);
-            } break;
+        const Action action = Action_Parse(input);
+        if (recordPath != NULL) {
+            ReplayWriter_Action(&recording, action);
         }
+        result = Game_Step(&game, action);
+        OutputSink_StepResult(&sink, &game, &result, input);
+        AppendMapRefresh(&display, &sink.buffer, &game);
+    }
 
-        // Need to mark this after handling the room incase the room is cleared:
-        room->visited = true;
-
-        if (player.health.current <= 0) {
-            PrintMap(dungeon, &player, false);
-            printf("YOU DIED!\n");
-            break;
+    if (display.ansi) {
+        // Give the whole terminal back:
+        RenderBuffer_Append(&sink.buffer, "\x1b[r", 3);
+    }
+    const bool _result = OutputSink_Flush(&sink, stdout);
+    (void)_result;
+    OutputSink_Destroy(&sink);
+    if (recordPath != NULL) {
+        ReplayWriter_EndGame(&recording, &game);
+        if (!ReplayWriter_Close(&recording)) {
+            fprintf(stderr, "Couldn't finish recording to '%s'.\n", recordPath);
+        }
+    }
+    if (profilePath != NULL) {
+        Profile_WriteSummary(stderr);
+        if (!Profile_WriteTrace(profilePath)) {
+            fprintf(stderr, "Couldn't write the profile to '%s'.\n", profilePath);
+        }
+    }
+    if (savePath != NULL) {
+        if (game.status != GAME_STATUS_PLAYING) {
+            // There's nothing left to carry on with, so leave any earlier save alone:
+            fprintf(stderr, "The game is over, so it wasn't saved to '%s'.\n", savePath);
+        } else if (!Snapshot_Save(savePath, &game)) {
+            fprintf(stderr, "Couldn't save the game to '%s'.\n", savePath);
         }
     }
-
     Dungeon_Destroy(dungeon);
 
     return 0;
 }
 
-bool IsGameOver(const Dungeon *const dungeon, const Player *const player) {
-    (void)dungeon;
-    assert(player != NULL);
-    return player->health.current == 0;
-}
-
-void HandleRoom_GeneralInput(char input[32], Dungeon *const dungeon, Player *const player, Room *const room) {
-    (void)room;
-    assert(dungeon != NULL);
-    assert(player != NULL);
-
-    while (!IsGameOver(dungeon, player)) {
-        printf(
-            "What do you do (type 'help' for a list of actions)?\n"
-            "> "
-        );
-
-        const int32_t _read = scanf("%31s", input);
-        (void)_read;
-
-        if (HandleInput_MovementActions(input, dungeon, player)) {
-            break;
-        } else if (!HandleInput_CommonActions(input, dungeon, player)) {
-            printf("Unrecognised command '%s'.\n", input);
-        }
+void AppendMap(void *const context, RenderBuffer *const output, const GameState *const game, const bool onlyVisited) {
+    MapDisplay *const display = context;
+    if (display->ansi) {
+        // The map is already on screen, so just make sure it's up to date:
+        AppendPinnedMap(display, output, game, onlyVisited);
+        Render_MapLegend(output);
+    } else {
+        const RenderWindow window = GetMapWindow(display, game);
+        Render_MapLegend(output);
+        Render_MapGrid(output, game->dungeon, &game->player, onlyVisited, &window);
+        Render_MapPosition(output, &game->player);
     }
 }
 
-void HandleRoom_Item(char input[32], Dungeon *const dungeon, Player *const player, Room *const room) {
-    assert(dungeon != NULL);
-    assert(player != NULL);
-    assert(room != NULL);
-
-    player->inventory[room->item] += 1;
-    printf(
-        "You found a %s! You now have %hhd.\n",
-        ItemType_ToString(room->item),
-        player->inventory[room->item]
-    );
-    Room_Clear(room);
-    HandleRoom_GeneralInput(input, dungeon, player, room);
-}
-
-void HandleRoom_Pit(char input[32], Dungeon *const dungeon, Player *const player, Room *const room) {
-    assert(dungeon != NULL);
-    assert(player != NULL);
-    assert(room != NULL);
-
-    printf(
-        "You come across a seemingly bottomless pit.\n"
-        "%s\n",
-        pitActionsText
-    );
-
-    while (!IsGameOver(dungeon, player)) {
-        printf(
-            "What do you do (type 'help' for a list of actions)?\n"
-            "> "
-        );
-
-        const int32_t _read = scanf("%31s", input);
-        (void)_read;
-
-        if (CheckInput("help", input)) {
-            printf(
-                "%s\n"
-                "%s\n",
-                commonActionsText,
-                pitActionsText
+void AppendMapRefresh(MapDisplay *const display, RenderBuffer *const output, GameState *const game) {
+    if (display->ansi && game->status == GAME_STATUS_PLAYING) {
+        const RenderWindow window = GetMapWindow(display, game);
+        const bool moved = !Vec2_Equal(window.min, display->window.min)
+            || !Vec2_Equal(window.max, display->window.max);
+        if (!display->drawn || moved || game->dirtyRooms.overflowed) {
+            AppendPinnedMap(display, output, game, true);
+        } else if (game->dirtyRooms.count > 0) {
+            // Only repaint the rooms that changed this step, plus the position line under the grid:
+            Render_MapCells(
+                output,
+                game->dungeon,
+                &game->player,
+                true,
+                &window,
+                1,
+                (const vec2*)game->dirtyRooms.positions,
+                game->dirtyRooms.count
             );
-        } else if (CheckInput("jump", input)) {
-            int32_t successPercentage = 85;
-            for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
-                successPercentage -= player->inventory[i] * 3;
-            }
-
-            if (RandRangei32(0, 100) < successPercentage) {
-                printf("You successfully jump the pit!\n");
-                HandleRoom_GeneralInput(input, dungeon, player, room);
-                break;
-            } else {
-                printf("You fall to your doom in your attempt to clear the pit.\n");
-                player->health.current = 0;
-                break;
-            }
-        } else if (CheckInput("swing", input)) {
-            if (player->inventory[ITEM_HOOK] > 0 && player->inventory[ITEM_ROPE]) {
-                printf("Using your HOOK and ROPE, you swing to safety on the other side of the pit.\n");
-                player->inventory[ITEM_HOOK] -= 1;
-                player->inventory[ITEM_ROPE] -= 1;
-                Room_Clear(room);
-                break;
-            } else {
-                printf("You must have at least 1 ROPE and 1 HOOK in order to swing across.\n");
-            }
-        } else if (CheckInput("return", input)) {
-            printf("You edge back into the room from whence you came.\n");
-            Player_Move(player, (vec2) { 0, -1 });
-            break;
-        } else if (!HandleInput_CommonActions(input, dungeon, player)) {
-            printf("Unrecognised command '%s'.\n", input);
+            RenderBuffer_AppendFormat(output, "\x1b" "7" "\x1b[%d;1H\x1b[K", RenderWindow_GetLineCount(&window) + 1);
+            Render_MapPosition(output, &game->player);
+            RenderBuffer_Append(output, "\x1b" "8", 2);
         }
     }
+    Game_ClearDirtyRooms(game);
 }
 
-void HandleRoom_Trap(char input[32], Dungeon *const dungeon, Player *const player, Room *const room) {
-    assert(dungeon != NULL);
-    assert(player != NULL);
-    assert(room != NULL);
-
-    const int8_t damage = (int8_t)RandRangei32(1, room->trap.maxDamage + 1);
-    Player_AdjustHealth(player, -damage);
-    printf(
-        "You step on a trap and lose %hhd HEALTH (%hhd/%hhd remaining).\n",
-        damage,
-        player->health.current,
-        player->health.max
-    );
-
-    room->trap.maxDamage -= (int8_t)RandRangei32(1, 3);
-    if (room->trap.maxDamage <= 0) {
-        printf("The trap is destroyed and will cause you no more harm.\n");
-        Room_Clear(room);
+void AppendPinnedMap(
+    MapDisplay *const display,
+    RenderBuffer *const output,
+    const GameState *const game,
+    const bool onlyVisited
+) {
+    display->window = GetMapWindow(display, game);
+    const int32_t lineCount = RenderWindow_GetLineCount(&display->window) + 1;
+
+    if (!display->drawn) {
+        // Clear the screen, then keep everything else scrolling underneath the map:
+        RenderBuffer_AppendFormat(output, "\x1b[2J\x1b[%d;r\x1b[%d;1H", lineCount + 2, lineCount + 2);
+        display->drawn = true;
     }
-
-    HandleRoom_GeneralInput(input, dungeon, player, room);
+    RenderBuffer_Append(output, "\x1b" "7" "\x1b[H", 5);
+    Render_MapGrid(output, game->dungeon, &game->player, onlyVisited, &display->window);
+    RenderBuffer_Append(output, "\x1b[K", 3);
+    Render_MapPosition(output, &game->player);
+    RenderBuffer_Append(output, "\x1b" "8", 2);
 }
 
-void HandleRoom_Enemy(char input[32], Dungeon *const dungeon, Player *const player, Room *const room) {
-    assert(dungeon != NULL);
-    assert(player != NULL);
-    assert(room != NULL);
-
-    printf(
-        "A vicious cave beast blocks your path.\n"
-        "%s\n",
-        enemyActionsText
-    );
-
-    while (!IsGameOver(dungeon, player)) {
-        printf(
-            "You (%hhd/%hhd) | VS | Beast (%hhd/\?\?\?)\n",
-            player->health.current,
-            player->health.max,
-            room->enemy.health
-        );
-
-        printf(
-            "What do you do (type 'help' for a list of actions)?\n"
-            "> "
-        );
-
-        const int32_t _read = scanf("%31s", input);
-        (void)_read;
-
-        if (CheckInput("help", input)) {
-            printf(
-                "%s\n"
-                "%s\n",
-                commonActionsText,
-                enemyActionsText
-            );
-        } else if (CheckInput("fight", input)) {
-            if (player->inventory[ITEM_SWORD] > 0) {
-                const int8_t damage = (int8_t)RandRangei32(3, 6);
-                room->enemy.health -= damage;
-                printf("You hit the beast with your SWORD and deal %hhd damage.\n", damage);
-            } else {
-                const int8_t damage = (int8_t)RandRangei32(0, 4);
-                room->enemy.health -= damage;
-                printf("You hit the beast with your fists and deal %hhd damage.\n", damage);
-            }
-
-            if (room->enemy.health <= 0) {
-                printf("The beast is defeated!\n");
-                Room_Clear(room);
-                HandleRoom_GeneralInput(input, dungeon, player, room);
-                break;
-            }
-
-            if (player->inventory[ITEM_SHIELD] > 0) {
-                const int8_t damage = (int8_t)RandRangei32(0, 3);
-                Player_AdjustHealth(player, -damage);
-                printf("The beast hits your SHIELD and you take %hhd damage.\n", damage);
-
-                if (Randf32() > 0.5f) {
-                    printf("Your SHIELD breaks!\n");
-                    player->inventory[ITEM_SHIELD] -= 1;
-                }
-            } else {
-                const int8_t damage = (int8_t)RandRangei32(1, room->enemy.maxDamage);
-                Player_AdjustHealth(player, -damage);
-                printf("The beast hits you and deals %hhd damage.\n", damage);
-            }
-        } else if (CheckInput("flee", input)) {
-            const float rng = Randf32();
-            if (rng > 0.5f) {
-                if (rng > 0.8f) {
-                    printf("You successfully evade the creature without harm.\n");
-                } else {
-                    const int8_t damage = (int8_t)RandRangei32(1, room->enemy.maxDamage);
-                    Player_AdjustHealth(player, -damage);
-                    printf(
-                        "You successfully evade the creature, "
-                        "but lose %hhd HEALTH in the process (%hhd/%hhd remaining).\n",
-                        damage,
-                        player->health.current,
-                        player->health.max
-                    );
-                }
+RenderWindow GetMapWindow(const MapDisplay *const display, const GameState *const game) {
+    if (display->viewportRadius > 0) {
+        return RenderWindow_AroundPlayer(game->dungeon, &game->player, display->viewportRadius);
+    }
+    return RenderWindow_Full(game->dungeon);
+}
 
-                Player_Move(player, (vec2) { 0, -1 });
-                break;
-            } else {
-                const int8_t damage = (int8_t)RandRangei32(1, room->enemy.maxDamage);
-                Player_AdjustHealth(player, -damage);
-                printf("You fail to evade the creature and lose %hhd HEALTH in the process.\n", damage);
-            }
-        } else if (!HandleInput_CommonActions(input, dungeon, player)) {
-            printf("Unrecognised command '%s'.\n", input);
+bool ParseOutputMode(const char *const name, OutputMode *const outMode) {
+    for (OutputMode mode = 0; mode < _OUTPUT_MODE_COUNT; ++mode) {
+        if (strcmp(name, OutputMode_ToString(mode)) == 0) {
+            *outMode = mode;
+            return true;
         }
     }
+    return false;
 }
 
-bool HandleInput_CommonActions(const char* input, Dungeon *const dungeon, Player *const player) {
-    if (CheckInput("exit", input)) {
-        player->health.current = 0;
-    } else if (CheckInput("help", input)) {
-        printf(
-            "%s\n"
-            "%s\n",
-            commonActionsText,
-            movementActionsText
-        );
-    } else if (CheckInput("map", input)) {
-        PrintMap(dungeon, player, true);
-    } else if (CheckInput("health", input)) {
-        printf("Current HEALTH: %hhd/%hhd\n", player->health.current, player->health.max);
-    } else if (CheckInput("inventory", input)) {
-        printf("INVENTORY: {\n");
-        for (ItemType item = 0; item < _ITEM_TYPE_COUNT; ++item) {
-            printf("  %s: %hhd,\n", ItemType_ToString(item), player->inventory[item]);
-        }
-        printf("}\n");
-    } else if (CheckInput("food", input)) {
-        if (player->inventory[ITEM_FOOD] == 0) {
-            printf("You have no FOOD.\n");
-        } else if (player->health.current >= player->health.max) {
-            printf(
-                "You already have max HEALTH (%hhd/%hhd).\n",
-                player->health.current,
-                player->health.max
-            );
-        } else {
-            const int8_t health = (int8_t)RandRangei32(1, 6);
-            Player_AdjustHealth(player, health);
-            player->inventory[ITEM_FOOD] -= 1;
-            printf(
-                "You consume 1 FOOD and regain %hhd HEALTH (%hhd/%hhd).\n",
-                health,
-                player->health.current,
-                player->health.max
-            );
-        }
-    } else {
+bool ParseDistribution(const char *const value, int32_t outDistribution[_ROOM_TYPE_COUNT]) {
+    int32_t distribution[_ROOM_TYPE_COUNT] = { 0 };
+    // ROOM_TREASURE and ROOM_SPAWN are placed exactly once, so may be left off (and must be 0):
+    const int32_t count = String_ParseWeights(value, _ROOM_TYPE_COUNT, distribution);
+    if (count < ROOM_TREASURE || distribution[ROOM_TREASURE] != 0 || distribution[ROOM_SPAWN] != 0) {
         return false;
     }
-
+    memcpy(outDistribution, distribution, sizeof(distribution));
     return true;
 }
 
-bool HandleInput_MovementActions(const char* input, Dungeon *const dungeon, Player *const player) {
-    vec2 currentPosition, previousPosition;
-    Vec2_Set(currentPosition, player->position.current);
-    Vec2_Set(previousPosition, player->position.previous);
-
-    const char* message;
-    if (CheckInput("forward", input)) {
-        message = "You move forward into the next room.";
-        Player_Move(player, (vec2) { 0, 1 });
-    } else if (CheckInput("back", input)) {
-        message = "You edge back into the room from whence you came.";
-        Player_Move(player, (vec2) { 0, -1 });
-    } else if (CheckInput("left", input)) {
-        message = "You turn left into the next room.";
-        Player_Move(player, (vec2) { -1, 0 });
-    } else if (CheckInput("right", input)) {
-        message = "You turn right into the next room.";
-        Player_Move(player, (vec2) { 1, 0 });
-    } else {
+bool ParseViewportRadius(const char *const value, int32_t *const outRadius) {
+    // strtol() would skip whitespace and accept a sign, and atoi() would take anything else as 0:
+    if (!isdigit((unsigned char)value[0])) {
         return false;
     }
-
-    if (
-        player->position.current[0] < 0 || player->position.current[0] >= dungeon->size[0]
-        || player->position.current[1] < 0 || player->position.current[1] >= dungeon->size[1]
-    ) {
-        printf("You come upon a solid wall - please choose a new direction.\n");
-        Vec2_Set(player->position.current, currentPosition);
-        Vec2_Set(player->position.previous, previousPosition);
+    char* end = NULL;
+    errno = 0;
+    const long radius = strtol(value, &end, 10);
+    if (*end != '\0' || errno == ERANGE || radius > INT32_MAX) {
         return false;
     }
-
-    printf("%s\n", message);
+    *outRadius = (int32_t)radius;
     return true;
 }
-
-void PrintMap(const Dungeon *const dungeon, const Player *const player, const bool onlyVisited) {
-    printf(
-        "Map Legend:\n"
-        "| ^ - player (follows orientation)\n"
-        "| H - dungeon entrance\n"
-        "| . - empty room\n"
-        "| + - item pickup\n"
-        "| X - trap\n"
-        "| O - pit\n"
-        "| E - enemy\n"
-        "| * - treasure\n"
-        "| ? - undiscovered room\n"
-    );
-
-    // Print y-axis in reverse:
-    for (int8_t y = dungeon->size[1]; y >= -2; --y) {
-        for (int8_t x = -2; x <= dungeon->size[0]; ++x) {
-            if (x > -2) {
-                // x-axis alignment:
-                printf(" ");
-            }
-
-            if (y < -1) {
-                // x-axis ruler:
-                if (x >= 0 && x < dungeon->size[0]) {
-                    printf("%hhd", x);
-                } else {
-                    printf(" ");
-                }
-            } else if (x < -1) {
-                // y-axis ruler:
-                if (y >= 0 && y < dungeon->size[1]) {
-                    printf("%hhd", y);
-                } else {
-                    printf(" ");
-                }
-            } else if (y < 0 || y >= dungeon->size[1]) {
-                // top+bottom border:
-                printf("-");
-            } else if (x < 0 || x >= dungeon->size[0]) {
-                // left+right border:
-                printf("|");
-            } else if (Vec2_Equal((vec2) { x, y }, player->position.current)) {
-                // player:
-                if (player->position.previous[1] < player->position.current[1]) {
-                    printf("^");
-                } else if (player->position.previous[0] < player->position.current[0]) {
-                    printf(">");
-                } else if (player->position.previous[1] > player->position.current[1]) {
-                    printf("v");
-                } else if (player->position.previous[0] > player->position.current[0]) {
-                    printf("<");
-                } else {
-                    assert(false);
-                }
-            } else {
-                // room:
-                const Room *const room = &dungeon->rooms[Dungeon_RoomIndex(dungeon, (vec2) { x, y })];
-                if (onlyVisited && !room->visited) {
-                    printf("?");
-                } else switch (room->type) {
-                    case ROOM_EMPTY: {
-                        printf(".");
-                    } break;
-                    case ROOM_ITEM: {
-                        printf("+");
-                    } break;
-                    case ROOM_PIT: {
-                        printf("O");
-                    } break;
-                    case ROOM_TRAP: {
-                        printf("X");
-                    } break;
-                    case ROOM_ENEMY: {
-                        printf("E");
-                    } break;
-                    case ROOM_TREASURE: {
-                        printf("*");
-                    } break;
-                    case ROOM_SPAWN: {
-                        printf("H");
-                    } break;
-                    case _ROOM_TYPE_COUNT: {
-                        assert(false);
-                    } break;
-                }
-            }
-        }
-        printf("\n");
-    }
-
-    printf(
-        "You are at [%hhd, %hhd] facing %s.\n",
-        player->position.current[0],
-        player->position.current[1],
-        Orientation_ToString(Player_GetOrientation(player))
-    );
-}
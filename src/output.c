@@ -0,0 +1,161 @@
+#include "dungeon/output.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+static void OutputSink_AppendInt32(OutputSink* self, int32_t value);
+
+void OutputSink_Init(OutputSink *const self, const OutputMode mode) {
+    assert(self != NULL);
+    assert(mode >= 0 && mode < _OUTPUT_MODE_COUNT);
+    *self = (OutputSink) {
+        .mode = mode,
+        .appendMap = NULL,
+        .mapContext = NULL,
+    };
+    RenderBuffer_Init(&self->buffer);
+}
+
+void OutputSink_Destroy(OutputSink *const self) {
+    assert(self != NULL);
+    RenderBuffer_Destroy(&self->buffer);
+}
+
+void OutputSink_Welcome(OutputSink *const self) {
+    assert(self != NULL);
+    switch (self->mode) {
+        case OUTPUT_TEXT: {
+            Text_AppendWelcome(&self->buffer);
+        } break;
+        case OUTPUT_BINARY: {
+            RenderBuffer_Append(&self->buffer, OUTPUT_BINARY_MAGIC, sizeof(OUTPUT_BINARY_MAGIC) - 1);
+            const char version = OUTPUT_BINARY_VERSION;
+            RenderBuffer_Append(&self->buffer, &version, 1);
+        } break;
+        case OUTPUT_NDJSON:
+        case OUTPUT_NONE: {
+        } break;
+        case _OUTPUT_MODE_COUNT: {
+            assert(false);
+        } break;
+    }
+}
+
+void OutputSink_StepResult(
+    OutputSink *const self,
+    const GameState *const game,
+    const StepResult *const result,
+    const char *const input
+) {
+    assert(self != NULL);
+    assert(game != NULL);
+    assert(result != NULL);
+
+    const Player *const player = &game->player;
+    switch (self->mode) {
+        case OUTPUT_TEXT: {
+            Text_AppendStepResult(&self->buffer, game, result, input, self->appendMap, self->mapContext);
+        } break;
+        case OUTPUT_NDJSON: {
+            RenderBuffer_AppendFormat(
+                &self->buffer,
+                "{\"status\":\"%s\",\"position\":[%d,%d],\"health\":%d,\"events\":[",
+                GameStatus_ToString(result->status),
+                (int32_t)player->position.current[0],
+                (int32_t)player->position.current[1],
+                (int32_t)player->health.current
+            );
+            for (int32_t i = 0; i < result->eventCount; ++i) {
+                const GameEvent *const event = &result->events[i];
+                RenderBuffer_AppendFormat(
+                    &self->buffer,
+                    "%s{\"type\":\"%s\",\"amount\":%d,\"detail\":%d}",
+                    (i > 0) ? "," : "",
+                    GameEventType_ToString(event->type),
+                    (int32_t)event->amount,
+                    (int32_t)event->detail
+                );
+            }
+            RenderBuffer_Append(&self->buffer, "]}\n", 3);
+        } break;
+        case OUTPUT_BINARY: {
+            const char header = (char)result->status;
+            RenderBuffer_Append(&self->buffer, &header, 1);
+            OutputSink_AppendInt32(self, player->position.current[0]);
+            OutputSink_AppendInt32(self, player->position.current[1]);
+            char *const record = RenderBuffer_Extend(&self->buffer, 2 + 3 * (size_t)result->eventCount);
+            record[0] = (char)player->health.current;
+            record[1] = (char)result->eventCount;
+            for (int32_t i = 0; i < result->eventCount; ++i) {
+                const GameEvent *const event = &result->events[i];
+                record[2 + 3 * i] = (char)event->type;
+                record[3 + 3 * i] = (char)event->amount;
+                record[4 + 3 * i] = (char)event->detail;
+            }
+        } break;
+        case OUTPUT_NONE: {
+        } break;
+        case _OUTPUT_MODE_COUNT: {
+            assert(false);
+        } break;
+    }
+}
+
+void OutputSink_Prompt(OutputSink *const self, const GameState *const game, const bool interactive) {
+    assert(self != NULL);
+    if (self->mode != OUTPUT_TEXT) {
+        return;
+    }
+    if (interactive) {
+        Text_AppendPrompt(&self->buffer, game);
+    } else {
+        Text_AppendStatus(&self->buffer, game);
+    }
+}
+
+void OutputSink_InputTooLong(OutputSink *const self, const char *const start, const int32_t maxLength) {
+    assert(self != NULL);
+    switch (self->mode) {
+        case OUTPUT_TEXT: {
+            RenderBuffer_AppendFormat(
+                &self->buffer,
+                "Command '%s...' is too long (at most %d characters) and was ignored.\n",
+                start,
+                maxLength
+            );
+        } break;
+        case OUTPUT_NDJSON: {
+            RenderBuffer_AppendFormat(&self->buffer, "{\"error\":\"command too long\",\"maxLength\":%d}\n", maxLength);
+        } break;
+        case OUTPUT_BINARY:
+        case OUTPUT_NONE: {
+        } break;
+        case _OUTPUT_MODE_COUNT: {
+            assert(false);
+        } break;
+    }
+}
+
+bool OutputSink_Flush(OutputSink *const self, FILE *const file) {
+    assert(self != NULL);
+    bool written = true;
+    if (self->buffer.length > 0) {
+        written = RenderBuffer_Write(&self->buffer, file) && fflush(file) == 0;
+        RenderBuffer_Clear(&self->buffer);
+    }
+    return written;
+}
+
+static void OutputSink_AppendInt32(OutputSink *const self, const int32_t value) {
+    // Always little-endian, regardless of the host:
+    const uint32_t bits = (uint32_t)value;
+    const char bytes[4] = {
+        (char)(bits & 0xFF),
+        (char)((bits >> 8) & 0xFF),
+        (char)((bits >> 16) & 0xFF),
+        (char)((bits >> 24) & 0xFF),
+    };
+    RenderBuffer_Append(&self->buffer, bytes, sizeof(bytes));
+}
@@ -0,0 +1,111 @@
+#include "dungeon/parallel.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "dungeon/util.h"
+
+typedef struct ParallelJob {
+    ParallelTask task;
+    void* context;
+    int32_t count;
+    mtx_t lock;
+    int32_t nextIndex;
+} ParallelJob;
+
+typedef struct ParallelWorker {
+    ParallelJob* job;
+    int32_t worker;
+} ParallelWorker;
+
+static int32_t Parallel_Work(void* arg);
+
+int32_t Parallel_GetProcessorCount(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return Max(1, (int32_t)info.dwNumberOfProcessors);
+#else
+    return Max(1, (int32_t)sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+int32_t Parallel_ResolveThreadCount(const int32_t threadCount) {
+    return threadCount > 0 ? threadCount : Parallel_GetProcessorCount();
+}
+
+void Parallel_For(const int32_t count, int32_t threadCount, const ParallelTask task, void *const context) {
+    assert(count >= 0);
+    assert(task != NULL);
+
+    threadCount = Min(Parallel_ResolveThreadCount(threadCount), Max(count, 1));
+    if (threadCount <= 1) {
+        // Not worth spinning up any threads:
+        for (int32_t i = 0; i < count; ++i) {
+            task(context, i, 0);
+        }
+        return;
+    }
+
+    ParallelJob job = {
+        .task = task,
+        .context = context,
+        .count = count,
+        .nextIndex = 0,
+    };
+    const int32_t _lockResult = mtx_init(&job.lock, mtx_plain);
+    assert(_lockResult == thrd_success);
+    (void)_lockResult;
+
+    thrd_t* threads = malloc(sizeof(threads[0]) * threadCount);
+    ParallelWorker* workers = malloc(sizeof(workers[0]) * threadCount);
+    assert(threads != NULL);
+    assert(workers != NULL);
+
+    // The calling thread acts as worker 0:
+    for (int32_t i = 0; i < threadCount; ++i) {
+        workers[i] = (ParallelWorker) {
+            .job = &job,
+            .worker = i,
+        };
+    }
+    for (int32_t i = 1; i < threadCount; ++i) {
+        const int32_t _createResult = thrd_create(&threads[i], Parallel_Work, &workers[i]);
+        assert(_createResult == thrd_success);
+        (void)_createResult;
+    }
+    Parallel_Work(&workers[0]);
+    for (int32_t i = 1; i < threadCount; ++i) {
+        thrd_join(threads[i], NULL);
+    }
+
+    mtx_destroy(&job.lock);
+    free(workers);
+    free(threads);
+}
+
+static int32_t Parallel_Work(void *const arg) {
+    const ParallelWorker *const worker = arg;
+    ParallelJob *const job = worker->job;
+
+    while (true) {
+        mtx_lock(&job->lock);
+        const int32_t index = job->nextIndex++;
+        mtx_unlock(&job->lock);
+
+        if (index >= job->count) {
+            break;
+        }
+        job->task(job->context, index, worker->worker);
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include "dungeon/path.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "dungeon/util.h"
+
+const int32_t distanceFieldDefaultCosts[_ROOM_TYPE_COUNT] = {
+    // ROOM_EMPTY:
+    1,
+    // ROOM_ITEM:
+    1,
+    // ROOM_PIT:
+    4,
+    // ROOM_TRAP:
+    2,
+    // ROOM_ENEMY:
+    6,
+    // ROOM_TREASURE:
+    1,
+    // ROOM_SPAWN:
+    1,
+};
+
+static void DistanceField_Invalidate(DistanceField* self, int64_t room, bool lostTarget, int32_t previousCost);
+static bool DistanceField_HasSupport(const DistanceField* self, int64_t room);
+static void DistanceField_Propagate(DistanceField* self);
+static int32_t DistanceField_GetNeighbours(const DistanceField* self, int64_t room, int64_t outNeighbours[4]);
+static void DistanceField_Push(DistanceField* self, int32_t distance, int64_t room);
+static void DistanceField_AddSeed(DistanceField* self, int64_t room, int32_t distance);
+static int32_t DistanceSeed_Compare(const void* a, const void* b);
+
+void DistanceField_GetDefaultCosts(int32_t outCosts[_ROOM_TYPE_COUNT]) {
+    assert(outCosts != NULL);
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        outCosts[i] = distanceFieldDefaultCosts[i];
+    }
+}
+
+void DistanceField_Init(
+    DistanceField *const self,
+    const Dungeon *const dungeon,
+    const RoomType target,
+    const int32_t costs[_ROOM_TYPE_COUNT]
+) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+    assert(target >= 0 && target < _ROOM_TYPE_COUNT);
+    assert(costs != NULL);
+
+    *self = (DistanceField) {
+        .target = target,
+        .seeds = NULL,
+        .seedCount = 0,
+        .seedCapacity = 0,
+    };
+    Vec2_Set(self->size, dungeon->size);
+    int32_t maxCost = 0;
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        assert(costs[i] >= 1 && costs[i] <= DISTANCE_FIELD_MAX_COST);
+        self->costs[i] = costs[i];
+        maxCost = Max(maxCost, costs[i]);
+    }
+    self->bucketCount = maxCost + 1;
+
+    // No path can cost more than entering every room once, which has to stay clear of DISTANCE_FIELD_UNREACHABLE:
+    const int64_t totalRooms = Dungeon_RoomCount(dungeon);
+    assert(totalRooms < (DISTANCE_FIELD_UNREACHABLE - DISTANCE_FIELD_MAX_COST) / maxCost);
+    self->distances = malloc(sizeof(self->distances[0]) * (size_t)totalRooms);
+    assert(self->distances != NULL);
+    self->types = malloc(sizeof(self->types[0]) * (size_t)totalRooms);
+    assert(self->types != NULL);
+
+    // Spread out from every target at once:
+    for (vec2 position = { 0, 0 }; position[1] < self->size[1]; ++position[1]) {
+        for (position[0] = 0; position[0] < self->size[0]; ++position[0]) {
+            const int64_t room = Dungeon_RoomIndex(dungeon, position);
+            const RoomType type = Dungeon_GetRoomType(dungeon, position);
+            self->types[room] = (uint8_t)type;
+            if (type == target) {
+                self->distances[room] = 0;
+                DistanceField_AddSeed(self, room, 0);
+            } else {
+                self->distances[room] = DISTANCE_FIELD_UNREACHABLE;
+            }
+        }
+    }
+    DistanceField_Propagate(self);
+}
+
+void DistanceField_Destroy(DistanceField *const self) {
+    assert(self != NULL);
+    free(self->distances);
+    free(self->types);
+    for (int32_t i = 0; i < self->bucketCount; ++i) {
+        free(self->buckets[i].rooms);
+    }
+    free(self->seeds);
+    *self = (DistanceField) { 0 };
+}
+
+void DistanceField_Update(DistanceField *const self, const Dungeon *const dungeon, const vec2 position) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+    assert(Vec2_Equal(self->size, dungeon->size));
+    assert(Dungeon_Contains(dungeon, position));
+
+    const int64_t room = Dungeon_RoomIndex(dungeon, position);
+    const RoomType type = Dungeon_GetRoomType(dungeon, position);
+    const RoomType previousType = (RoomType)self->types[room];
+    if (type == previousType) {
+        return;
+    }
+    self->types[room] = (uint8_t)type;
+
+    const int32_t cost = self->costs[type];
+    const int32_t previousCost = self->costs[previousType];
+    const bool lostTarget = previousType == self->target;
+    const bool gainedTarget = type == self->target;
+    // Distances can only have grown if a target has gone, or if the room costs more to enter:
+    if (lostTarget || cost > previousCost) {
+        DistanceField_Invalidate(self, room, lostTarget, previousCost);
+    }
+    // ...and can only have shrunk if a target has appeared, or if the room costs less to enter:
+    if (gainedTarget) {
+        self->distances[room] = 0;
+    }
+    if (gainedTarget || (cost < previousCost && self->distances[room] != DISTANCE_FIELD_UNREACHABLE)) {
+        self->seedCount = 0;
+        DistanceField_AddSeed(self, room, self->distances[room]);
+        DistanceField_Propagate(self);
+    }
+}
+
+bool DistanceField_GetNextStep(const DistanceField *const self, const vec2 position, vec2 outPosition) {
+    assert(self != NULL);
+    assert(position[0] >= 0 && position[0] < self->size[0] && position[1] >= 0 && position[1] < self->size[1]);
+    assert(outPosition != NULL);
+
+    const int32_t distance = DistanceField_Get(self, position);
+    if (distance == 0 || distance == DISTANCE_FIELD_UNREACHABLE) {
+        return false;
+    }
+    // Any neighbour that this room's distance was worked out through will do:
+    const int32_t directions[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+    for (int32_t i = 0; i < 4; ++i) {
+        const int32_t x = position[0] + directions[i][0];
+        const int32_t y = position[1] + directions[i][1];
+        if (x < 0 || x >= self->size[0] || y < 0 || y >= self->size[1]) {
+            continue;
+        }
+        const int64_t room = (int64_t)y * self->size[0] + x;
+        if (
+            self->distances[room] != DISTANCE_FIELD_UNREACHABLE
+            && self->distances[room] + self->costs[self->types[room]] == distance
+        ) {
+            outPosition[0] = (vec2_scalar)x;
+            outPosition[1] = (vec2_scalar)y;
+            return true;
+        }
+    }
+
+    assert(false);
+    return false;
+}
+
+// Find every room whose cheapest path led through 'room' before it changed (and has no other path that's just as
+// cheap), then work those rooms out again. 'lostTarget' is set if 'room' used to be a target, and 'previousCost'
+// is what it used to cost to enter.
+static void DistanceField_Invalidate(
+    DistanceField *const self,
+    const int64_t room,
+    const bool lostTarget,
+    const int32_t previousCost
+) {
+    int64_t neighbours[4];
+    int64_t queued = 0;
+    int32_t current = self->distances[room];
+    if (lostTarget) {
+        DistanceField_Push(self, current, room);
+        queued += 1;
+    } else if (current != DISTANCE_FIELD_UNREACHABLE) {
+        current += previousCost;
+        const int32_t neighbourCount = DistanceField_GetNeighbours(self, room, neighbours);
+        for (int32_t i = 0; i < neighbourCount; ++i) {
+            if (self->distances[neighbours[i]] == current) {
+                DistanceField_Push(self, current, neighbours[i]);
+                queued += 1;
+            }
+        }
+    }
+
+    // Check rooms in order of distance, so that everything a room could be reached through has already been
+    // checked (costs are never 0, so a room is only ever reached through rooms closer to a target):
+    self->seedCount = 0;
+    for (; queued > 0; ++current) {
+        DistanceBucket *const bucket = &self->buckets[current % self->bucketCount];
+        while (bucket->count > 0) {
+            const int64_t candidate = bucket->rooms[--bucket->count];
+            queued -= 1;
+            if (self->distances[candidate] != current || DistanceField_HasSupport(self, candidate)) {
+                continue;
+            }
+            // Nothing else leads here as cheaply, so any room that was reached through this one needs checking too:
+            const int32_t cost = (candidate == room) ? previousCost : self->costs[self->types[candidate]];
+            const int32_t through = current + cost;
+            self->distances[candidate] = DISTANCE_FIELD_UNREACHABLE;
+            DistanceField_AddSeed(self, candidate, DISTANCE_FIELD_UNREACHABLE);
+            const int32_t neighbourCount = DistanceField_GetNeighbours(self, candidate, neighbours);
+            for (int32_t i = 0; i < neighbourCount; ++i) {
+                if (self->distances[neighbours[i]] == through) {
+                    DistanceField_Push(self, through, neighbours[i]);
+                    queued += 1;
+                }
+            }
+        }
+    }
+
+    // Restart each of them from the cheapest of its neighbours that still has a path, and let those spread:
+    for (int64_t i = 0; i < self->seedCount; ++i) {
+        DistanceSeed *const seed = &self->seeds[i];
+        const int32_t neighbourCount = DistanceField_GetNeighbours(self, seed->room, neighbours);
+        for (int32_t j = 0; j < neighbourCount; ++j) {
+            const int32_t distance = self->distances[neighbours[j]];
+            if (distance != DISTANCE_FIELD_UNREACHABLE) {
+                seed->distance = Min(seed->distance, distance + self->costs[self->types[neighbours[j]]]);
+            }
+        }
+    }
+    int64_t seedCount = 0;
+    for (int64_t i = 0; i < self->seedCount; ++i) {
+        const DistanceSeed seed = self->seeds[i];
+        if (seed.distance != DISTANCE_FIELD_UNREACHABLE) {
+            self->distances[seed.room] = seed.distance;
+            self->seeds[seedCount++] = seed;
+        }
+    }
+    self->seedCount = seedCount;
+    qsort(self->seeds, (size_t)self->seedCount, sizeof(self->seeds[0]), DistanceSeed_Compare);
+    DistanceField_Propagate(self);
+}
+
+// Check whether 'room' is a target, or is still reached at its current distance through one of its neighbours.
+static bool DistanceField_HasSupport(const DistanceField *const self, const int64_t room) {
+    if (self->types[room] == self->target) {
+        return true;
+    }
+    int64_t neighbours[4];
+    const int32_t neighbourCount = DistanceField_GetNeighbours(self, room, neighbours);
+    for (int32_t i = 0; i < neighbourCount; ++i) {
+        const int32_t distance = self->distances[neighbours[i]];
+        if (
+            distance != DISTANCE_FIELD_UNREACHABLE
+            && distance + self->costs[self->types[neighbours[i]]] == self->distances[room]
+        ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run Dijkstra's algorithm out from the seeds (sorted by distance, which each room must already be set to), lowering
+// the distance of every room that can be reached more cheaply through them.
+static void DistanceField_Propagate(DistanceField *const self) {
+    int64_t neighbours[4];
+    int64_t queued = 0;
+    int64_t nextSeed = 0;
+    int32_t current = 0;
+    while (queued > 0 || nextSeed < self->seedCount) {
+        if (queued == 0) {
+            current = self->seeds[nextSeed].distance;
+        }
+        // Seeds only join the queue once it gets to their distance, which keeps everything queued within a bucket
+        // count of the distance being expanded:
+        for (; nextSeed < self->seedCount && self->seeds[nextSeed].distance == current; ++nextSeed) {
+            DistanceField_Push(self, current, self->seeds[nextSeed].room);
+            queued += 1;
+        }
+
+        DistanceBucket *const bucket = &self->buckets[current % self->bucketCount];
+        while (bucket->count > 0) {
+            const int64_t room = bucket->rooms[--bucket->count];
+            queued -= 1;
+            // Skip rooms that have since been reached more cheaply:
+            if (self->distances[room] != current) {
+                continue;
+            }
+            const int32_t distance = current + self->costs[self->types[room]];
+            const int32_t neighbourCount = DistanceField_GetNeighbours(self, room, neighbours);
+            for (int32_t i = 0; i < neighbourCount; ++i) {
+                if (distance < self->distances[neighbours[i]]) {
+                    self->distances[neighbours[i]] = distance;
+                    DistanceField_Push(self, distance, neighbours[i]);
+                    queued += 1;
+                }
+            }
+        }
+        current += 1;
+    }
+}
+
+// Get the rooms next to 'room', returning how many there are.
+static int32_t DistanceField_GetNeighbours(
+    const DistanceField *const self,
+    const int64_t room,
+    int64_t outNeighbours[4]
+) {
+    const int64_t width = self->size[0];
+    const int64_t x = room % width;
+    int32_t count = 0;
+    if (x > 0) {
+        outNeighbours[count++] = room - 1;
+    }
+    if (x + 1 < width) {
+        outNeighbours[count++] = room + 1;
+    }
+    if (room >= width) {
+        outNeighbours[count++] = room - width;
+    }
+    if (room + width < width * self->size[1]) {
+        outNeighbours[count++] = room + width;
+    }
+    return count;
+}
+
+static void DistanceField_Push(DistanceField *const self, const int32_t distance, const int64_t room) {
+    DistanceBucket *const bucket = &self->buckets[distance % self->bucketCount];
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = Max(bucket->capacity * 2, 64);
+        bucket->rooms = realloc(bucket->rooms, sizeof(bucket->rooms[0]) * (size_t)bucket->capacity);
+        assert(bucket->rooms != NULL);
+    }
+    bucket->rooms[bucket->count++] = room;
+}
+
+static void DistanceField_AddSeed(DistanceField *const self, const int64_t room, const int32_t distance) {
+    if (self->seedCount == self->seedCapacity) {
+        self->seedCapacity = Max(self->seedCapacity * 2, 64);
+        self->seeds = realloc(self->seeds, sizeof(self->seeds[0]) * (size_t)self->seedCapacity);
+        assert(self->seeds != NULL);
+    }
+    self->seeds[self->seedCount++] = (DistanceSeed) {
+        .room = room,
+        .distance = distance,
+    };
+}
+
+static int32_t DistanceSeed_Compare(const void *const a, const void *const b) {
+    const int32_t distanceA = ((const DistanceSeed*)a)->distance;
+    const int32_t distanceB = ((const DistanceSeed*)b)->distance;
+    return (distanceA > distanceB) - (distanceA < distanceB);
+}
@@ -41,7 +41,7 @@ Orientation Player_GetOrientation(const Player *const self) {
 void Player_Move(Player *const self, const vec2 direction) {
     assert(self != NULL);
 
-    int8_t currentDirection[2];
+    vec2 currentDirection;
     Player_GetDirection(self, currentDirection);
 
     Vec2_Set(self->position.previous, self->position.current);
@@ -0,0 +1,283 @@
+#include "dungeon/profile.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(DUNGEON_PROFILE)
+
+#include <threads.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "dungeon/util.h"
+
+typedef struct ProfileEvent {
+    uint64_t start;
+    uint64_t duration;
+    ProfileZone zone;
+} ProfileEvent;
+
+// Everything one thread has recorded. These are never freed, so they outlive their threads
+// (e.g. Parallel_For() workers) and can be read once the work is done. Once a thread exits its record is handed on
+// to the next new thread, so there are only ever as many as there have been threads running at once.
+typedef struct ProfileThread {
+    struct ProfileThread* next;
+    // Next record free to be taken by a new thread (only while on 'profileFreeThreads'):
+    struct ProfileThread* nextFree;
+    int32_t id;
+    int64_t zoneCalls[_PROFILE_ZONE_COUNT];
+    uint64_t zoneTime[_PROFILE_ZONE_COUNT];
+    uint64_t zoneMaxTime[_PROFILE_ZONE_COUNT];
+    int64_t counters[_PROFILE_COUNTER_COUNT];
+    ProfileEvent* events;
+    int64_t eventCount;
+    int64_t eventCapacity;
+    int64_t droppedEvents;
+} ProfileThread;
+
+static once_flag profileOnce = ONCE_FLAG_INIT;
+static mtx_t profileLock;
+// Every thread that has recorded anything, most recent first:
+static ProfileThread* profileThreads = NULL;
+static int32_t profileThreadCount = 0;
+// Records of threads that have exited, ready to be reused:
+static ProfileThread* profileFreeThreads = NULL;
+// Set to each thread's record, so that it's released when the thread exits:
+static tss_t profileThreadKey;
+// Profile_Now() when profiling started, which traces are relative to:
+static uint64_t profileStartTime = 0;
+static _Thread_local ProfileThread* profileCurrentThread = NULL;
+
+static void Profile_Init(void);
+static ProfileThread* Profile_GetThread(void);
+static void Profile_ReleaseThread(void* thread);
+
+uint64_t Profile_Now(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * (1e9 / (double)frequency.QuadPart));
+#else
+    struct timespec time;
+    const int32_t _result = clock_gettime(CLOCK_MONOTONIC, &time);
+    assert(_result == 0);
+    (void)_result;
+    return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+#endif
+}
+
+void Profile_Record(const ProfileZone zone, const uint64_t start) {
+    assert(zone >= 0 && zone < _PROFILE_ZONE_COUNT);
+    const uint64_t duration = Profile_Now() - start;
+    ProfileThread *const thread = Profile_GetThread();
+
+    thread->zoneCalls[zone] += 1;
+    thread->zoneTime[zone] += duration;
+    thread->zoneMaxTime[zone] = Max(thread->zoneMaxTime[zone], duration);
+
+    if (thread->eventCount == thread->eventCapacity) {
+        if (thread->eventCapacity == PROFILE_MAX_EVENTS) {
+            thread->droppedEvents += 1;
+            return;
+        }
+        thread->eventCapacity = (thread->eventCapacity == 0)
+            ? 4096
+            : Min(thread->eventCapacity * 2, PROFILE_MAX_EVENTS);
+        thread->events = realloc(thread->events, sizeof(thread->events[0]) * (size_t)thread->eventCapacity);
+        assert(thread->events != NULL);
+    }
+    thread->events[thread->eventCount++] = (ProfileEvent) {
+        .start = start,
+        .duration = duration,
+        .zone = zone,
+    };
+}
+
+void Profile_Count(const ProfileCounter counter, const int64_t amount) {
+    assert(counter >= 0 && counter < _PROFILE_COUNTER_COUNT);
+    Profile_GetThread()->counters[counter] += amount;
+}
+
+bool Profile_IsEnabled(void) {
+    return true;
+}
+
+void Profile_WriteSummary(FILE *const file) {
+    assert(file != NULL);
+    call_once(&profileOnce, Profile_Init);
+
+    int64_t calls[_PROFILE_ZONE_COUNT] = { 0 };
+    uint64_t time[_PROFILE_ZONE_COUNT] = { 0 };
+    uint64_t maxTime[_PROFILE_ZONE_COUNT] = { 0 };
+    int64_t counters[_PROFILE_COUNTER_COUNT] = { 0 };
+    mtx_lock(&profileLock);
+    for (const ProfileThread* thread = profileThreads; thread != NULL; thread = thread->next) {
+        for (int32_t i = 0; i < _PROFILE_ZONE_COUNT; ++i) {
+            calls[i] += thread->zoneCalls[i];
+            time[i] += thread->zoneTime[i];
+            maxTime[i] = Max(maxTime[i], thread->zoneMaxTime[i]);
+        }
+        for (int32_t i = 0; i < _PROFILE_COUNTER_COUNT; ++i) {
+            counters[i] += thread->counters[i];
+        }
+    }
+    const int32_t threadCount = profileThreadCount;
+    mtx_unlock(&profileLock);
+
+    fprintf(
+        file,
+        "Profile across up to %d thread(s) at once (zones include any zones nested inside them):\n",
+        threadCount
+    );
+    fprintf(file, "| %-18s %12s %12s %12s %12s\n", "zone", "calls", "total ms", "mean ns", "max ns");
+    for (int32_t i = 0; i < _PROFILE_ZONE_COUNT; ++i) {
+        fprintf(
+            file,
+            "| %-18s %12lld %12.3f %12.0f %12llu\n",
+            ProfileZone_ToString((ProfileZone)i),
+            (long long)calls[i],
+            (double)time[i] * 1e-6,
+            (calls[i] > 0) ? (double)time[i] / (double)calls[i] : 0.0,
+            (unsigned long long)maxTime[i]
+        );
+    }
+    fprintf(file, "| %-18s %12s\n", "counter", "total");
+    for (int32_t i = 0; i < _PROFILE_COUNTER_COUNT; ++i) {
+        fprintf(file, "| %-18s %12lld\n", ProfileCounter_ToString((ProfileCounter)i), (long long)counters[i]);
+    }
+}
+
+bool Profile_WriteTrace(const char *const path) {
+    assert(path != NULL);
+    call_once(&profileOnce, Profile_Init);
+
+    FILE *const file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    // Complete ("X") events in microseconds, one track per thread, then each thread's counter totals:
+    const uint64_t endTime = Profile_Now();
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    mtx_lock(&profileLock);
+    for (const ProfileThread* thread = profileThreads; thread != NULL; thread = thread->next) {
+        fprintf(
+            file,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+            first ? "" : ",",
+            thread->id,
+            thread->id
+        );
+        first = false;
+        for (int64_t i = 0; i < thread->eventCount; ++i) {
+            const ProfileEvent *const event = &thread->events[i];
+            fprintf(
+                file,
+                ",\n{\"name\":\"%s\",\"cat\":\"dungeon\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                ProfileZone_ToString(event->zone),
+                thread->id,
+                // Zones that started before profiling was initialised end up just before 0:
+                (double)(int64_t)(event->start - profileStartTime) * 1e-3,
+                (double)event->duration * 1e-3
+            );
+        }
+        fprintf(
+            file,
+            ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{",
+            thread->id,
+            (double)(endTime - profileStartTime) * 1e-3
+        );
+        for (int32_t i = 0; i < _PROFILE_COUNTER_COUNT; ++i) {
+            fprintf(
+                file,
+                "%s\"%s\":%lld",
+                (i == 0) ? "" : ",",
+                ProfileCounter_ToString((ProfileCounter)i),
+                (long long)thread->counters[i]
+            );
+        }
+        fprintf(file, ",\"dropped_events\":%lld}}", (long long)thread->droppedEvents);
+    }
+    mtx_unlock(&profileLock);
+    fprintf(file, "\n]}\n");
+
+    const bool written = ferror(file) == 0;
+    const bool closed = fclose(file) == 0;
+    return written && closed;
+}
+
+static void Profile_Init(void) {
+    const int32_t _result = mtx_init(&profileLock, mtx_plain);
+    assert(_result == thrd_success);
+    (void)_result;
+    const int32_t _keyResult = tss_create(&profileThreadKey, Profile_ReleaseThread);
+    assert(_keyResult == thrd_success);
+    (void)_keyResult;
+    profileStartTime = Profile_Now();
+}
+
+// Get the calling thread's records, taking over those of an exited thread (or registering new ones) the first time.
+static ProfileThread* Profile_GetThread(void) {
+    if (profileCurrentThread != NULL) {
+        return profileCurrentThread;
+    }
+    call_once(&profileOnce, Profile_Init);
+
+    mtx_lock(&profileLock);
+    ProfileThread* thread = profileFreeThreads;
+    if (thread != NULL) {
+        profileFreeThreads = thread->nextFree;
+        thread->nextFree = NULL;
+    } else {
+        thread = calloc(1, sizeof(*thread));
+        assert(thread != NULL);
+        thread->id = profileThreadCount++;
+        thread->next = profileThreads;
+        profileThreads = thread;
+    }
+    mtx_unlock(&profileLock);
+
+    const int32_t _result = tss_set(profileThreadKey, thread);
+    assert(_result == thrd_success);
+    (void)_result;
+    profileCurrentThread = thread;
+    return thread;
+}
+
+// Called as a thread exits, to hand its records on to the next new thread (see Profile_GetThread()).
+static void Profile_ReleaseThread(void *const arg) {
+    ProfileThread *const thread = arg;
+    mtx_lock(&profileLock);
+    thread->nextFree = profileFreeThreads;
+    profileFreeThreads = thread;
+    mtx_unlock(&profileLock);
+}
+
+#else
+
+bool Profile_IsEnabled(void) {
+    return false;
+}
+
+void Profile_WriteSummary(FILE *const file) {
+    (void)file;
+}
+
+bool Profile_WriteTrace(const char *const path) {
+    (void)path;
+    return false;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "dungeon/region.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "dungeon/util.h"
+
+// Set in RegionStats::rooms once a room has been visited:
+const uint8_t regionVisitedFlag = 0x80;
+
+static void RegionStats_AddChange(RegionStats* self, const vec2 position, int32_t layer, int8_t delta);
+static void RegionStats_Flush(RegionStats* self);
+static void RegionStats_BuildLayer(RegionStats* self, int32_t layer, int64_t firstRow);
+static int32_t RegionStats_Count(
+    const RegionStats* self,
+    int32_t layer,
+    int64_t minX,
+    int64_t minY,
+    int64_t maxX,
+    int64_t maxY
+);
+static int32_t RegionStats_CountNear(const RegionStats* self, int32_t layer, const vec2 center, int32_t radius);
+
+void RegionStats_Init(RegionStats *const self, const Dungeon *const dungeon) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+
+    *self = (RegionStats) {
+        .changeCount = 0,
+    };
+    Vec2_Set(self->size, dungeon->size);
+    const int64_t totalRooms = Dungeon_RoomCount(dungeon);
+    assert(totalRooms <= INT32_MAX);
+    const size_t tableSize = (size_t)(self->size[0] + 1) * (size_t)(self->size[1] + 1);
+    self->rooms = malloc(sizeof(self->rooms[0]) * (size_t)totalRooms);
+    assert(self->rooms != NULL);
+    for (vec2 position = { 0, 0 }; position[1] < self->size[1]; ++position[1]) {
+        for (position[0] = 0; position[0] < self->size[0]; ++position[0]) {
+            const uint8_t type = (uint8_t)Dungeon_GetRoomType(dungeon, position);
+            const uint8_t visited = Dungeon_IsVisited(dungeon, position) ? regionVisitedFlag : 0;
+            self->rooms[Dungeon_RoomIndex(dungeon, position)] = type | visited;
+        }
+    }
+    // The first row and column of every table stay 0:
+    for (int32_t layer = 0; layer < REGION_LAYER_COUNT; ++layer) {
+        self->tables[layer] = calloc(tableSize, sizeof(self->tables[layer][0]));
+        assert(self->tables[layer] != NULL);
+        RegionStats_BuildLayer(self, layer, 0);
+        self->firstChangedRows[layer] = self->size[1];
+    }
+}
+
+void RegionStats_Destroy(RegionStats *const self) {
+    assert(self != NULL);
+    for (int32_t layer = 0; layer < REGION_LAYER_COUNT; ++layer) {
+        free(self->tables[layer]);
+    }
+    free(self->rooms);
+    *self = (RegionStats) { 0 };
+}
+
+void RegionStats_Update(RegionStats *const self, const Dungeon *const dungeon, const vec2 position) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+    assert(Vec2_Equal(self->size, dungeon->size));
+    assert(Dungeon_Contains(dungeon, position));
+
+    const int64_t index = Dungeon_RoomIndex(dungeon, position);
+    const uint8_t previous = self->rooms[index];
+    const uint8_t visited = Dungeon_IsVisited(dungeon, position) ? regionVisitedFlag : 0;
+    const uint8_t current = (uint8_t)Dungeon_GetRoomType(dungeon, position) | visited;
+    if (current == previous) {
+        return;
+    }
+    self->rooms[index] = current;
+
+    const int32_t previousType = previous & ~regionVisitedFlag;
+    const int32_t type = current & ~regionVisitedFlag;
+    if (type != previousType) {
+        RegionStats_AddChange(self, position, previousType, -1);
+        RegionStats_AddChange(self, position, type, 1);
+    }
+    if ((current ^ previous) & regionVisitedFlag) {
+        RegionStats_AddChange(self, position, REGION_LAYER_VISITED, visited ? 1 : -1);
+    }
+    // Make sure there's always space for everything a single room can change:
+    if (self->changeCount > REGION_MAX_CHANGES - 3) {
+        RegionStats_Flush(self);
+    }
+}
+
+int32_t RegionStats_CountRooms(
+    const RegionStats *const self,
+    const RoomType type,
+    const vec2 min,
+    const vec2 max
+) {
+    assert(self != NULL);
+    assert(type >= 0 && type < _ROOM_TYPE_COUNT);
+    assert(min[0] >= 0 && min[0] <= max[0] && max[0] < self->size[0]);
+    assert(min[1] >= 0 && min[1] <= max[1] && max[1] < self->size[1]);
+    return RegionStats_Count(self, type, min[0], min[1], max[0], max[1]);
+}
+
+int32_t RegionStats_CountVisited(const RegionStats *const self, const vec2 min, const vec2 max) {
+    assert(self != NULL);
+    assert(min[0] >= 0 && min[0] <= max[0] && max[0] < self->size[0]);
+    assert(min[1] >= 0 && min[1] <= max[1] && max[1] < self->size[1]);
+    return RegionStats_Count(self, REGION_LAYER_VISITED, min[0], min[1], max[0], max[1]);
+}
+
+int32_t RegionStats_CountRoomsNear(
+    const RegionStats *const self,
+    const RoomType type,
+    const vec2 center,
+    const int32_t radius
+) {
+    assert(self != NULL);
+    assert(type >= 0 && type < _ROOM_TYPE_COUNT);
+    return RegionStats_CountNear(self, type, center, radius);
+}
+
+int32_t RegionStats_CountVisitedNear(const RegionStats *const self, const vec2 center, const int32_t radius) {
+    assert(self != NULL);
+    return RegionStats_CountNear(self, REGION_LAYER_VISITED, center, radius);
+}
+
+static void RegionStats_AddChange(
+    RegionStats *const self,
+    const vec2 position,
+    const int32_t layer,
+    const int8_t delta
+) {
+    assert(self->changeCount < REGION_MAX_CHANGES);
+    self->changes[self->changeCount++] = (RegionChange) {
+        .x = position[0],
+        .y = position[1],
+        .layer = (uint8_t)layer,
+        .delta = delta,
+    };
+    self->firstChangedRows[layer] = Min(self->firstChangedRows[layer], (int32_t)position[1]);
+}
+
+// Fold every pending change into the tables, only redoing the rows from the highest one each layer changed on.
+static void RegionStats_Flush(RegionStats *const self) {
+    for (int32_t layer = 0; layer < REGION_LAYER_COUNT; ++layer) {
+        if (self->firstChangedRows[layer] < self->size[1]) {
+            RegionStats_BuildLayer(self, layer, self->firstChangedRows[layer]);
+            self->firstChangedRows[layer] = self->size[1];
+        }
+    }
+    self->changeCount = 0;
+}
+
+// Work out the summed-area table of 'layer' again from 'firstRow' down, from RegionStats::rooms.
+static void RegionStats_BuildLayer(RegionStats *const self, const int32_t layer, const int64_t firstRow) {
+    const int64_t width = self->size[0];
+    const int64_t stride = width + 1;
+    int32_t *const table = self->tables[layer];
+    for (int64_t y = firstRow; y < self->size[1]; ++y) {
+        const uint8_t *const rooms = &self->rooms[y * width];
+        const int32_t *const above = &table[y * stride];
+        int32_t *const row = &table[(y + 1) * stride];
+        int32_t count = 0;
+        if (layer == REGION_LAYER_VISITED) {
+            for (int64_t x = 0; x < width; ++x) {
+                count += rooms[x] >> 7;
+                row[x + 1] = above[x + 1] + count;
+            }
+        } else {
+            for (int64_t x = 0; x < width; ++x) {
+                count += (rooms[x] & ~regionVisitedFlag) == layer;
+                row[x + 1] = above[x + 1] + count;
+            }
+        }
+    }
+}
+
+// Count 'layer' over the rooms from (minX, minY) to (maxX, maxY) inclusive, including any pending changes.
+static int32_t RegionStats_Count(
+    const RegionStats *const self,
+    const int32_t layer,
+    const int64_t minX,
+    const int64_t minY,
+    const int64_t maxX,
+    const int64_t maxY
+) {
+    const int64_t stride = self->size[0] + 1;
+    const int32_t *const table = self->tables[layer];
+    int32_t count = table[(maxY + 1) * stride + maxX + 1]
+        - table[minY * stride + maxX + 1]
+        - table[(maxY + 1) * stride + minX]
+        + table[minY * stride + minX];
+    for (int32_t i = 0; i < self->changeCount; ++i) {
+        const RegionChange *const change = &self->changes[i];
+        const bool inside = change->x >= minX && change->x <= maxX && change->y >= minY && change->y <= maxY;
+        count += (change->layer == layer && inside) ? change->delta : 0;
+    }
+    return count;
+}
+
+static int32_t RegionStats_CountNear(
+    const RegionStats *const self,
+    const int32_t layer,
+    const vec2 center,
+    const int32_t radius
+) {
+    assert(radius >= 0);
+    const int64_t minX = Max((int64_t)center[0] - radius, 0);
+    const int64_t minY = Max((int64_t)center[1] - radius, 0);
+    const int64_t maxX = Min((int64_t)center[0] + radius, (int64_t)self->size[0] - 1);
+    const int64_t maxY = Min((int64_t)center[1] + radius, (int64_t)self->size[1] - 1);
+    if (minX > maxX || minY > maxY) {
+        return 0;
+    }
+    return RegionStats_Count(self, layer, minX, minY, maxX, maxY);
+}
@@ -0,0 +1,303 @@
+#include "dungeon/render.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/profile.h"
+#include "dungeon/util.h"
+
+const char mapLegendText[] =
+    "Map Legend:\n"
+    "| ^ - player (follows orientation)\n"
+    "| H - dungeon entrance\n"
+    "| . - empty room\n"
+    "| + - item pickup\n"
+    "| X - trap\n"
+    "| O - pit\n"
+    "| E - enemy\n"
+    "| * - treasure\n"
+    "| ? - undiscovered room\n";
+
+const char roomGlyphs[_ROOM_TYPE_COUNT] = {
+    // ROOM_EMPTY:
+    '.',
+    // ROOM_ITEM:
+    '+',
+    // ROOM_PIT:
+    'O',
+    // ROOM_TRAP:
+    'X',
+    // ROOM_ENEMY:
+    'E',
+    // ROOM_TREASURE:
+    '*',
+    // ROOM_SPAWN:
+    'H',
+};
+
+const char playerGlyphs[_ORIENTATION_COUNT] = {
+    // ORIENTATION_NORTH:
+    '^',
+    // ORIENTATION_EAST:
+    '>',
+    // ORIENTATION_SOUTH:
+    'v',
+    // ORIENTATION_WEST:
+    '<',
+};
+
+const char unvisitedGlyph = '?';
+
+static void RenderBuffer_Reserve(RenderBuffer* self, size_t capacity);
+static char Render_GetRoomGlyph(const Dungeon* dungeon, const Player* player, bool onlyVisited, const vec2 position);
+
+void RenderBuffer_Init(RenderBuffer *const self) {
+    assert(self != NULL);
+    *self = (RenderBuffer) { 0 };
+}
+
+void RenderBuffer_Destroy(RenderBuffer *const self) {
+    assert(self != NULL);
+    free(self->data);
+    *self = (RenderBuffer) { 0 };
+}
+
+void RenderBuffer_Clear(RenderBuffer *const self) {
+    assert(self != NULL);
+    self->length = 0;
+}
+
+char* RenderBuffer_Extend(RenderBuffer *const self, const size_t size) {
+    assert(self != NULL);
+    assert(size <= SIZE_MAX - self->length);
+    if (self->length + size > self->capacity) {
+        RenderBuffer_Reserve(self, self->length + size);
+    }
+    char *const start = self->data + self->length;
+    self->length += size;
+    return start;
+}
+
+void RenderBuffer_Append(RenderBuffer *const self, const char *const data, const size_t size) {
+    assert(data != NULL || size == 0);
+    if (size > 0) {
+        memcpy(RenderBuffer_Extend(self, size), data, size);
+    }
+}
+
+void RenderBuffer_AppendFormat(RenderBuffer *const self, const char *const format, ...) {
+    assert(self != NULL);
+    assert(format != NULL);
+
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    const int32_t length = vsnprintf(NULL, 0, format, argsCopy);
+    va_end(argsCopy);
+    assert(length >= 0);
+
+    // vsnprintf() always writes a null terminator, so leave room for it and then drop it again:
+    char *const start = RenderBuffer_Extend(self, (size_t)length + 1);
+    const int32_t _result = vsnprintf(start, (size_t)length + 1, format, args);
+    (void)_result;
+    va_end(args);
+    self->length -= 1;
+}
+
+bool RenderBuffer_Write(const RenderBuffer *const self, FILE *const file) {
+    assert(self != NULL);
+    assert(file != NULL);
+    return fwrite(self->data, 1, self->length, file) == self->length;
+}
+
+bool RenderBuffer_WriteToFile(const RenderBuffer *const self, const char *const path) {
+    assert(self != NULL);
+    assert(path != NULL);
+
+    FILE *const file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    const bool written = RenderBuffer_Write(self, file);
+    return (fclose(file) == 0) && written;
+}
+
+RenderWindow RenderWindow_Full(const Dungeon *const dungeon) {
+    assert(dungeon != NULL);
+    return (RenderWindow) {
+        .min = { 0, 0 },
+        .max = { dungeon->size[0], dungeon->size[1] },
+    };
+}
+
+RenderWindow RenderWindow_AroundPlayer(const Dungeon *const dungeon, const Player *const player, const int32_t radius) {
+    assert(dungeon != NULL);
+    assert(player != NULL);
+    assert(radius >= 0);
+
+    RenderWindow window;
+    for (int32_t axis = 0; axis < 2; ++axis) {
+        // Slide the window back inside the dungeon rather than shrinking it near the edges:
+        const int64_t size = Min((int64_t)radius * 2 + 1, (int64_t)dungeon->size[axis]);
+        const int64_t min = Clamp((int64_t)player->position.current[axis] - radius, 0, dungeon->size[axis] - size);
+        window.min[axis] = (vec2_scalar)min;
+        window.max[axis] = (vec2_scalar)(min + size);
+    }
+    return window;
+}
+
+int32_t RenderWindow_GetLineCount(const RenderWindow *const self) {
+    assert(self != NULL);
+    // Rooms, plus the top+bottom border and x-axis ruler:
+    return (int32_t)((int64_t)self->max[1] - self->min[1] + 3);
+}
+
+void Render_Map(
+    RenderBuffer *const self,
+    const Dungeon *const dungeon,
+    const Player *const player,
+    const bool onlyVisited
+) {
+    const RenderWindow window = RenderWindow_Full(dungeon);
+    Render_MapLegend(self);
+    Render_MapGrid(self, dungeon, player, onlyVisited, &window);
+    Render_MapPosition(self, player);
+}
+
+void Render_MapLegend(RenderBuffer *const self) {
+    RenderBuffer_Append(self, mapLegendText, sizeof(mapLegendText) - 1);
+}
+
+void Render_MapGrid(
+    RenderBuffer *const self,
+    const Dungeon *const dungeon,
+    const Player *const player,
+    const bool onlyVisited,
+    const RenderWindow *const window
+) {
+    assert(self != NULL);
+    assert(dungeon != NULL);
+    assert(player != NULL);
+    assert(window != NULL);
+    PROFILE_BEGIN(PROFILE_ZONE_RENDER_MAP);
+
+    // Every row is the y-axis ruler, then a space-separated column for each of the left border,
+    // the rooms and the right border, so column 'x' (where the left border is -1) is at 2 * (x + 2):
+    const int64_t width = (int64_t)window->max[0] - window->min[0];
+    const int64_t lineCount = RenderWindow_GetLineCount(window);
+    const int64_t rowLength = 2 * (width + 2) + 2;
+    assert((uint64_t)rowLength <= SIZE_MAX / (uint64_t)lineCount);
+    char* row = RenderBuffer_Extend(self, (size_t)rowLength * (size_t)lineCount);
+
+    // Render y-axis in reverse (using wider counters than vec2 so that the borders can't overflow):
+    for (int64_t y = window->max[1]; y >= (int64_t)window->min[1] - 2; --y, row += rowLength) {
+        memset(row, ' ', (size_t)rowLength - 1);
+        row[rowLength - 1] = '\n';
+        char *const columns = row + 4;
+
+        if (y < (int64_t)window->min[1] - 1) {
+            // x-axis ruler (only the last digit fits in a column):
+            for (int64_t x = 0; x < width; ++x) {
+                columns[2 * x] = (char)('0' + (window->min[0] + x) % 10);
+            }
+        } else if (y < window->min[1] || y >= window->max[1]) {
+            // top+bottom border:
+            for (int64_t x = -1; x <= width; ++x) {
+                columns[2 * x] = '-';
+            }
+        } else {
+            // y-axis ruler, then left+right border:
+            row[0] = (char)('0' + y % 10);
+            columns[-2] = '|';
+            columns[2 * width] = '|';
+
+            // rooms:
+            vec2 position = { 0, (vec2_scalar)y };
+            for (int64_t x = 0; x < width; ++x) {
+                position[0] = (vec2_scalar)(window->min[0] + x);
+                columns[2 * x] = Render_GetRoomGlyph(dungeon, player, onlyVisited, position);
+            }
+        }
+    }
+    PROFILE_END(PROFILE_ZONE_RENDER_MAP);
+}
+
+void Render_MapPosition(RenderBuffer *const self, const Player *const player) {
+    assert(player != NULL);
+    RenderBuffer_AppendFormat(
+        self,
+        "You are at [%d, %d] facing %s.\n",
+        (int32_t)player->position.current[0],
+        (int32_t)player->position.current[1],
+        Orientation_ToString(Player_GetOrientation(player))
+    );
+}
+
+void Render_MapCells(
+    RenderBuffer *const self,
+    const Dungeon *const dungeon,
+    const Player *const player,
+    const bool onlyVisited,
+    const RenderWindow *const window,
+    const int32_t screenLine,
+    const vec2 positions[],
+    const int32_t count
+) {
+    assert(window != NULL);
+    assert(screenLine > 0);
+    assert(positions != NULL || count == 0);
+    PROFILE_BEGIN(PROFILE_ZONE_RENDER_MAP);
+
+    // Save the cursor:
+    RenderBuffer_Append(self, "\x1b" "7", 2);
+    for (int32_t i = 0; i < count; ++i) {
+        const vec2_scalar *const position = positions[i];
+        if (position[0] < window->min[0] || position[0] >= window->max[0]
+            || position[1] < window->min[1] || position[1] >= window->max[1]) {
+            continue;
+        }
+        // The grid starts with the top border, and columns are laid out as in Render_MapGrid() (1-based):
+        const int64_t line = screenLine + ((int64_t)window->max[1] - position[1]);
+        const int64_t column = 2 * ((int64_t)position[0] - window->min[0] + 2) + 1;
+        RenderBuffer_AppendFormat(
+            self,
+            "\x1b[%lld;%lldH%c",
+            (long long)line,
+            (long long)column,
+            Render_GetRoomGlyph(dungeon, player, onlyVisited, position)
+        );
+    }
+    // Restore the cursor:
+    RenderBuffer_Append(self, "\x1b" "8", 2);
+    PROFILE_END(PROFILE_ZONE_RENDER_MAP);
+}
+
+static char Render_GetRoomGlyph(
+    const Dungeon *const dungeon,
+    const Player *const player,
+    const bool onlyVisited,
+    const vec2 position
+) {
+    if (Vec2_Equal(position, player->position.current)) {
+        return playerGlyphs[Player_GetOrientation(player)];
+    } else if (onlyVisited && !Dungeon_IsVisited(dungeon, position)) {
+        return unvisitedGlyph;
+    }
+    return roomGlyphs[Dungeon_GetRoomType(dungeon, position)];
+}
+
+static void RenderBuffer_Reserve(RenderBuffer *const self, const size_t capacity) {
+    // Grow geometrically so that repeated appends stay amortised O(1):
+    size_t newCapacity = Max(self->capacity, (size_t)256);
+    while (newCapacity < capacity) {
+        newCapacity = (newCapacity <= SIZE_MAX / 2) ? newCapacity * 2 : capacity;
+    }
+    char *const data = realloc(self->data, newCapacity);
+    assert(data != NULL);
+    self->data = data;
+    self->capacity = newCapacity;
+}
@@ -0,0 +1,378 @@
+#include "dungeon/replay.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "dungeon/item.h"
+#include "dungeon/util.h"
+
+// Marks the end of a game's actions (actions are stored offset by 1 to leave room for it):
+const uint64_t replayEndToken = 0;
+// Marks the start of a game (distinct from the first byte of REPLAY_MAGIC, so headers can appear between games):
+const uint64_t replayGameToken = 1;
+
+static void ReplayWriter_AppendVarint(ReplayWriter* self, uint64_t value);
+static bool ReplayReader_Fill(ReplayReader* self);
+static ReplayStatus ReplayReader_ReadVarint(ReplayReader* self, uint64_t* outValue);
+static bool ReplayReader_SkipHeader(ReplayReader* self);
+static bool ReplaySetup_IsValid(const ReplaySetup* self);
+
+Dungeon* ReplaySetup_CreateGame(const ReplaySetup *const self, GameState *const outGame) {
+    assert(self != NULL);
+    assert(outGame != NULL);
+
+    Rng rng;
+    Rng_Seed(&rng, self->seed, self->stream);
+    Dungeon *const dungeon = Dungeon_CreateWithParams(&self->params, &rng);
+    Game_Init(outGame, dungeon, &rng);
+    return dungeon;
+}
+
+bool ReplayWriter_Open(ReplayWriter *const self, const char *const path) {
+    assert(self != NULL);
+    assert(path != NULL);
+
+    self->file = fopen(path, "wb");
+    if (self->file == NULL) {
+        return false;
+    }
+    RenderBuffer_Init(&self->buffer);
+    RenderBuffer_Append(&self->buffer, REPLAY_MAGIC, sizeof(REPLAY_MAGIC) - 1);
+    const char version = REPLAY_VERSION;
+    RenderBuffer_Append(&self->buffer, &version, 1);
+    return true;
+}
+
+void ReplayWriter_BeginGame(ReplayWriter *const self, const ReplaySetup *const setup) {
+    assert(self != NULL);
+    assert(setup != NULL);
+    assert(ReplaySetup_IsValid(setup));
+
+    ReplayWriter_AppendVarint(self, replayGameToken);
+    ReplayWriter_AppendVarint(self, setup->seed);
+    ReplayWriter_AppendVarint(self, setup->stream);
+    ReplayWriter_AppendVarint(self, (uint64_t)setup->params.size[0]);
+    ReplayWriter_AppendVarint(self, (uint64_t)setup->params.size[1]);
+    ReplayWriter_AppendVarint(self, (uint64_t)setup->params.generation);
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        ReplayWriter_AppendVarint(self, (uint64_t)setup->params.roomDistribution[i]);
+    }
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        ReplayWriter_AppendVarint(self, (uint64_t)setup->params.itemDistribution[i]);
+    }
+}
+
+void ReplayWriter_Action(ReplayWriter *const self, const Action action) {
+    assert(self != NULL);
+    assert(action >= 0 && action < _ACTION_COUNT);
+    ReplayWriter_AppendVarint(self, (uint64_t)action + 1);
+    // Don't let a long session hold everything in memory:
+    if (self->buffer.length >= REPLAY_BUFFER_SIZE) {
+        const bool _result = ReplayWriter_Flush(self);
+        (void)_result;
+    }
+}
+
+void ReplayWriter_EndGame(ReplayWriter *const self, const GameState *const game) {
+    assert(self != NULL);
+    assert(game != NULL);
+    ReplayWriter_AppendVarint(self, replayEndToken);
+    ReplayWriter_AppendVarint(self, Game_Hash(game));
+}
+
+bool ReplayWriter_Flush(ReplayWriter *const self) {
+    assert(self != NULL);
+    bool written = true;
+    if (self->buffer.length > 0) {
+        written = RenderBuffer_Write(&self->buffer, self->file) && fflush(self->file) == 0;
+        RenderBuffer_Clear(&self->buffer);
+    }
+    return written;
+}
+
+bool ReplayWriter_Close(ReplayWriter *const self) {
+    assert(self != NULL);
+    const bool written = ReplayWriter_Flush(self);
+    RenderBuffer_Destroy(&self->buffer);
+    const bool closed = fclose(self->file) == 0;
+    self->file = NULL;
+    return written && closed;
+}
+
+bool ReplayReader_Open(ReplayReader *const self, const char *const path) {
+    assert(self != NULL);
+    assert(path != NULL);
+
+    self->failed = false;
+    self->start = 0;
+    self->end = 0;
+    if (strcmp(path, "-") == 0) {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        self->file = stdin;
+    } else {
+        self->file = fopen(path, "rb");
+        if (self->file == NULL) {
+            return false;
+        }
+    }
+
+    if (!ReplayReader_SkipHeader(self)) {
+        ReplayReader_Close(self);
+        return false;
+    }
+    return true;
+}
+
+void ReplayReader_Close(ReplayReader *const self) {
+    assert(self != NULL);
+    if (self->file != NULL && self->file != stdin) {
+        fclose(self->file);
+    }
+    self->file = NULL;
+}
+
+ReplayStatus ReplayReader_NextGame(ReplayReader *const self, ReplaySetup *const outSetup) {
+    assert(self != NULL);
+    assert(outSetup != NULL);
+
+    // Running out of input is only expected between games:
+    if (self->start == self->end && !ReplayReader_Fill(self)) {
+        return self->failed ? REPLAY_CORRUPT : REPLAY_END;
+    }
+    // Concatenated logs repeat the header before their first game:
+    if (self->buffer[self->start] == (uint8_t)REPLAY_MAGIC[0] && !ReplayReader_SkipHeader(self)) {
+        return REPLAY_CORRUPT;
+    }
+    uint64_t token;
+    if (ReplayReader_ReadVarint(self, &token) != REPLAY_OK || token != replayGameToken) {
+        return REPLAY_CORRUPT;
+    }
+
+    uint64_t values[5 + _ROOM_TYPE_COUNT + _ITEM_TYPE_COUNT];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        if (ReplayReader_ReadVarint(self, &values[i]) != REPLAY_OK) {
+            return REPLAY_CORRUPT;
+        }
+    }
+    const uint64_t* value = values;
+    ReplaySetup setup = {
+        .seed = *value++,
+        .stream = *value++,
+    };
+    for (int32_t i = 0; i < 2; ++i) {
+        if (*value < 1 || *value > VEC2_SCALAR_MAX) {
+            return REPLAY_CORRUPT;
+        }
+        setup.params.size[i] = (vec2_scalar)*value++;
+    }
+    if (*value > DUNGEON_GENERATION_TILED) {
+        return REPLAY_CORRUPT;
+    }
+    setup.params.generation = (DungeonGeneration)*value++;
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        setup.params.roomDistribution[i] = (int32_t)Min(*value, (uint64_t)INT16_MAX + 1);
+        ++value;
+    }
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        setup.params.itemDistribution[i] = (int32_t)Min(*value, (uint64_t)INT16_MAX + 1);
+        ++value;
+    }
+    if (!ReplaySetup_IsValid(&setup)) {
+        return REPLAY_CORRUPT;
+    }
+    *outSetup = setup;
+    return REPLAY_OK;
+}
+
+ReplayStatus ReplayReader_NextAction(ReplayReader *const self, Action *const outAction, uint64_t *const outHash) {
+    assert(self != NULL);
+    assert(outAction != NULL);
+    assert(outHash != NULL);
+
+    uint64_t token;
+    if (ReplayReader_ReadVarint(self, &token) != REPLAY_OK) {
+        return REPLAY_CORRUPT;
+    }
+    if (token == replayEndToken) {
+        return (ReplayReader_ReadVarint(self, outHash) == REPLAY_OK) ? REPLAY_END : REPLAY_CORRUPT;
+    }
+    if (token > _ACTION_COUNT) {
+        return REPLAY_CORRUPT;
+    }
+    *outAction = (Action)(token - 1);
+    return REPLAY_OK;
+}
+
+ReplayStatus Replay_Run(ReplayReader *const reader, ReplayStats *const stats) {
+    assert(reader != NULL);
+    assert(stats != NULL);
+
+    for (;;) {
+        ReplaySetup setup;
+        const ReplayStatus setupStatus = ReplayReader_NextGame(reader, &setup);
+        if (setupStatus != REPLAY_OK) {
+            return setupStatus;
+        }
+
+        GameState game;
+        Dungeon *const dungeon = ReplaySetup_CreateGame(&setup, &game);
+        Game_Start(&game);
+
+        // A game that ends early has gone wrong, but the rest of its actions still need to be read past:
+        bool diverged = false;
+        Action action;
+        uint64_t hash = 0;
+        ReplayStatus status;
+        while ((status = ReplayReader_NextAction(reader, &action, &hash)) == REPLAY_OK) {
+            if (game.status == GAME_STATUS_PLAYING) {
+                Game_Step(&game, action);
+            } else {
+                diverged = true;
+            }
+            stats->actions += 1;
+        }
+        if (status == REPLAY_END) {
+            if (diverged || Game_Hash(&game) != hash) {
+                if (stats->mismatches == 0) {
+                    stats->firstMismatch = stats->games;
+                }
+                stats->mismatches += 1;
+            }
+            stats->games += 1;
+        }
+        Dungeon_Destroy(dungeon);
+
+        if (status != REPLAY_END) {
+            return REPLAY_CORRUPT;
+        }
+    }
+}
+
+static void ReplayWriter_AppendVarint(ReplayWriter *const self, uint64_t value) {
+    // Unsigned LEB128 - 7 bits per byte, low bits first, with the top bit set on every byte but the last:
+    char bytes[10];
+    int32_t length = 0;
+    do {
+        bytes[length] = (char)(value & 0x7F);
+        value >>= 7;
+        if (value != 0) {
+            bytes[length] = (char)(bytes[length] | 0x80);
+        }
+        ++length;
+    } while (value != 0);
+    RenderBuffer_Append(&self->buffer, bytes, (size_t)length);
+}
+
+// Read another chunk into the buffer (keeping any unread bytes), returning false if nothing more could be read.
+static bool ReplayReader_Fill(ReplayReader *const self) {
+    if (self->file == NULL) {
+        return false;
+    }
+
+    const int32_t remaining = self->end - self->start;
+    if (self->start > 0) {
+        memmove(self->buffer, &self->buffer[self->start], (size_t)remaining);
+        self->start = 0;
+        self->end = remaining;
+    }
+    const size_t length = fread(&self->buffer[self->end], 1, (size_t)(REPLAY_BUFFER_SIZE - self->end), self->file);
+    if (length == 0) {
+        self->failed = ferror(self->file) != 0;
+        return false;
+    }
+    self->end += (int32_t)length;
+    return true;
+}
+
+static ReplayStatus ReplayReader_ReadVarint(ReplayReader *const self, uint64_t *const outValue) {
+    uint64_t value = 0;
+    for (int32_t shift = 0; shift < 64; shift += 7) {
+        if (self->start == self->end && !ReplayReader_Fill(self)) {
+            return REPLAY_CORRUPT;
+        }
+        const uint8_t byte = self->buffer[self->start++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *outValue = value;
+            return REPLAY_OK;
+        }
+    }
+    // More than 64 bits:
+    return REPLAY_CORRUPT;
+}
+
+// Read past a log header, returning false if there isn't a compatible one next.
+static bool ReplayReader_SkipHeader(ReplayReader *const self) {
+    const int32_t headerLength = (int32_t)sizeof(REPLAY_MAGIC);
+    if (self->end - self->start < headerLength) {
+        // The rest of the header might just not have been read yet:
+        const bool _result = ReplayReader_Fill(self);
+        (void)_result;
+        if (self->end - self->start < headerLength) {
+            return false;
+        }
+    }
+    const uint8_t *const header = &self->buffer[self->start];
+    if (memcmp(header, REPLAY_MAGIC, sizeof(REPLAY_MAGIC) - 1) != 0 || header[headerLength - 1] != REPLAY_VERSION) {
+        return false;
+    }
+    self->start += headerLength;
+    return true;
+}
+
+// Check that 'self' describes a dungeon that can actually be generated.
+static bool ReplaySetup_IsValid(const ReplaySetup *const self) {
+    const DungeonParams *const params = &self->params;
+    if (params->size[0] < 1 || params->size[1] < 1) {
+        return false;
+    }
+    // Validation isn't recorded, so only dungeons used exactly as generated can be replayed:
+    if (params->validation != DUNGEON_VALIDATION_NONE) {
+        return false;
+    }
+    const int64_t totalRooms = (int64_t)params->size[0] * params->size[1];
+    switch (params->generation) {
+        case DUNGEON_GENERATION_DENSE:
+        case DUNGEON_GENERATION_TILED: {
+            if (totalRooms < _ROOM_TYPE_COUNT) {
+                return false;
+            }
+        } break;
+        case DUNGEON_GENERATION_HASHED: {
+            if (totalRooms < 2) {
+                return false;
+            }
+        } break;
+        default: {
+            return false;
+        }
+    }
+
+    int32_t totalRoomDistribution = 0;
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        if (params->roomDistribution[i] < 0 || params->roomDistribution[i] > INT16_MAX) {
+            return false;
+        }
+        totalRoomDistribution += params->roomDistribution[i];
+    }
+    int32_t totalItemDistribution = 0;
+    for (int32_t i = 0; i < _ITEM_TYPE_COUNT; ++i) {
+        if (params->itemDistribution[i] < 0 || params->itemDistribution[i] > INT16_MAX) {
+            return false;
+        }
+        totalItemDistribution += params->itemDistribution[i];
+    }
+    return totalRoomDistribution > 0
+        && totalItemDistribution > 0
+        && params->roomDistribution[ROOM_TREASURE] == 0
+        && params->roomDistribution[ROOM_SPAWN] == 0;
+}
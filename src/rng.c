@@ -0,0 +1,25 @@
+#include "dungeon/rng.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+void Rng_Seed(Rng *const self, const uint64_t seed, const uint64_t stream) {
+    assert(self != NULL);
+    self->state = 0;
+    self->increment = (stream << 1) | 1;
+    Rng_Next(self);
+    self->state += seed;
+    Rng_Next(self);
+}
+
+void Rng_Fill(Rng *const self, uint32_t values[], const int32_t count) {
+    assert(self != NULL);
+    assert(values != NULL || count == 0);
+
+    // Work on a local copy so the compiler can keep the state in registers:
+    Rng rng = *self;
+    for (int32_t i = 0; i < count; ++i) {
+        values[i] = Rng_Next(&rng);
+    }
+    *self = rng;
+}
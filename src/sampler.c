@@ -0,0 +1,64 @@
+#include "dungeon/sampler.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+void Sampler_Init(Sampler *const self, const int32_t count, const int32_t weights[]) {
+    assert(self != NULL);
+    assert(weights != NULL);
+    assert(count > 0 && count <= SAMPLER_MAX_COUNT);
+
+    int64_t totalWeight = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        assert(weights[i] >= 0);
+        totalWeight += weights[i];
+    }
+    assert(totalWeight > 0);
+    // Keeps the fixed-point maths below within 64 bits:
+    assert(totalWeight <= INT32_MAX);
+
+    *self = (Sampler) {
+        .count = count,
+    };
+
+    // Work in integers scaled by 'count', so that the average column is exactly 'totalWeight':
+    int64_t scaled[SAMPLER_MAX_COUNT];
+    int32_t small[SAMPLER_MAX_COUNT], large[SAMPLER_MAX_COUNT];
+    int32_t smallCount = 0, largeCount = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        scaled[i] = (int64_t)weights[i] * count;
+        if (scaled[i] < totalWeight) {
+            small[smallCount++] = i;
+        } else {
+            large[largeCount++] = i;
+        }
+    }
+
+    // Top up each under-full column with the remainder of an over-full one:
+    while (smallCount > 0 && largeCount > 0) {
+        const int32_t less = small[--smallCount];
+        const int32_t more = large[--largeCount];
+
+        self->threshold[less] = (uint32_t)((scaled[less] << 32) / totalWeight);
+        self->alias[less] = (uint8_t)more;
+
+        scaled[more] -= totalWeight - scaled[less];
+        if (scaled[more] < totalWeight) {
+            small[smallCount++] = more;
+        } else {
+            large[largeCount++] = more;
+        }
+    }
+
+    // Whatever is left is full (give or take rounding), so always keep it:
+    while (largeCount > 0) {
+        const int32_t full = large[--largeCount];
+        self->threshold[full] = UINT32_MAX;
+        self->alias[full] = (uint8_t)full;
+    }
+    while (smallCount > 0) {
+        const int32_t full = small[--smallCount];
+        self->threshold[full] = UINT32_MAX;
+        self->alias[full] = (uint8_t)full;
+    }
+}
@@ -0,0 +1,354 @@
+#include "dungeon/snapshot.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Start of the Dungeon in the file - enough for anything in it, and keeps the rooms cache-line aligned:
+const uint64_t snapshotDungeonAlignment = 64;
+// Written as-is, so it reads back differently on a host of the other endianness:
+const uint32_t snapshotByteOrder = 0x01020304;
+
+static void* Snapshot_Map(const char* path, size_t* outSize);
+static bool Snapshot_WritePadding(FILE* file, uint64_t position, uint64_t alignment);
+static bool Snapshot_IsValid(const SnapshotHeader* header, const uint8_t* mapping, size_t size);
+static bool Snapshot_IsValidSampler(const Sampler* sampler, int32_t count, uint32_t excludedMask);
+static bool Snapshot_IsValidRoom(PackedRoom room);
+static bool Snapshot_IsValidGame(const SnapshotHeader* header, const GameState* game);
+static inline uint64_t Snapshot_Align(uint64_t value, uint64_t alignment);
+
+bool Snapshot_Save(const char *const path, const GameState *const game) {
+    assert(path != NULL);
+    assert(game != NULL);
+    assert(game->status == GAME_STATUS_PLAYING && "finished games can't be continued, so there's nothing to save");
+    const Dungeon *const dungeon = game->dungeon;
+    assert(dungeon->base == NULL && "forks only hold their changes, so save the dungeon they were forked from");
+
+    // Everything densely stored is packed straight after the Dungeon, so it can be written in one go:
+    uint64_t dungeonLength = sizeof(*dungeon);
+    uint64_t roomsOffset = 0;
+    uint64_t visitedOffset = 0;
+    if (dungeon->rooms != NULL) {
+        roomsOffset = (uint64_t)((uintptr_t)dungeon->rooms - (uintptr_t)dungeon);
+        visitedOffset = (uint64_t)((uintptr_t)dungeon->visited - (uintptr_t)dungeon);
+        const uint64_t visitedWords = ((uint64_t)Dungeon_RoomCount(dungeon) + 63) / 64;
+        dungeonLength = visitedOffset + sizeof(dungeon->visited[0]) * visitedWords;
+    }
+
+    SnapshotHeader header = {
+        .version = SNAPSHOT_VERSION,
+        .headerSize = sizeof(SnapshotHeader),
+        .dungeonSize = sizeof(Dungeon),
+        .playerSize = sizeof(Player),
+        .scalarSize = sizeof(vec2_scalar),
+        .byteOrder = snapshotByteOrder,
+        .player = game->player,
+        .rng = game->rng,
+        .encounter = (uint32_t)game->encounter,
+        .status = (uint32_t)game->status,
+        .dungeonOffset = Snapshot_Align(sizeof(SnapshotHeader), snapshotDungeonAlignment),
+        .dungeonLength = dungeonLength,
+        .roomsOffset = roomsOffset,
+        .visitedOffset = visitedOffset,
+    };
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    if (dungeon->changedRooms.capacity > 0) {
+        header.changedRoomsOffset = Snapshot_Align(
+            header.dungeonOffset + header.dungeonLength,
+            sizeof(dungeon->changedRooms.entries[0])
+        );
+    }
+
+    // Pointers only mean anything in this process, so they're cleared and rebuilt from offsets on load:
+    Dungeon image = *dungeon;
+    image.rooms = NULL;
+    image.visited = NULL;
+    image.changedRooms.entries = NULL;
+    image.mapping = NULL;
+    image.mappingSize = 0;
+
+    FILE *const file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && Snapshot_WritePadding(file, sizeof(header), snapshotDungeonAlignment)
+        && fwrite(&image, sizeof(image), 1, file) == 1;
+    if (written && dungeonLength > sizeof(*dungeon)) {
+        const size_t packedLength = (size_t)(dungeonLength - sizeof(*dungeon));
+        written = fwrite((const uint8_t*)dungeon + sizeof(*dungeon), packedLength, 1, file) == 1;
+    }
+    if (written && header.changedRoomsOffset != 0) {
+        written = Snapshot_WritePadding(
+                file,
+                header.dungeonOffset + header.dungeonLength,
+                sizeof(dungeon->changedRooms.entries[0])
+            )
+            && fwrite(
+                dungeon->changedRooms.entries,
+                sizeof(dungeon->changedRooms.entries[0]),
+                (size_t)dungeon->changedRooms.capacity,
+                file
+            ) == (size_t)dungeon->changedRooms.capacity;
+    }
+    return (fclose(file) == 0) && written;
+}
+
+Dungeon* Snapshot_Load(const char *const path, GameState *const outGame) {
+    assert(path != NULL);
+    assert(outGame != NULL);
+
+    size_t size = 0;
+    uint8_t *const mapping = Snapshot_Map(path, &size);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    const SnapshotHeader *const header = (const SnapshotHeader*)mapping;
+    if (!Snapshot_IsValid(header, mapping, size)) {
+        Snapshot_Unmap(mapping, size);
+        return NULL;
+    }
+
+    Dungeon *const self = (Dungeon*)(mapping + header->dungeonOffset);
+    self->mapping = mapping;
+    self->mappingSize = size;
+    if (header->roomsOffset != 0) {
+        self->rooms = (PackedRoom*)((uint8_t*)self + header->roomsOffset);
+        self->visited = (uint64_t*)((uint8_t*)self + header->visitedOffset);
+    }
+    if (header->changedRoomsOffset != 0) {
+        // The table is reallocated as it grows, so it needs its own copy rather than pointing into the mapping:
+        const size_t entriesSize = sizeof(self->changedRooms.entries[0]) * (size_t)self->changedRooms.capacity;
+        self->changedRooms.entries = malloc(entriesSize);
+        assert(self->changedRooms.entries != NULL);
+        memcpy(self->changedRooms.entries, mapping + header->changedRoomsOffset, entriesSize);
+    }
+
+    // Only games still being played are saved (see Snapshot_Save()), so the status is already known to be PLAYING:
+    Game_Init(outGame, self, &header->rng);
+    outGame->player = header->player;
+    outGame->encounter = (Encounter)header->encounter;
+    if (!Snapshot_IsValidGame(header, outGame)) {
+        Dungeon_Destroy(self);
+        return NULL;
+    }
+    return self;
+}
+
+void Snapshot_Unmap(void *const mapping, const size_t size) {
+    assert(mapping != NULL);
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+// Map the whole file at 'path' copy-on-write, returning NULL on failure.
+static void* Snapshot_Map(const char *const path, size_t *const outSize) {
+#if defined(_WIN32)
+    const HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    void* mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && (uint64_t)size.QuadPart <= SIZE_MAX) {
+        const HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (fileMapping != NULL) {
+            // The view keeps the file open, so neither handle is needed past here:
+            mapping = MapViewOfFile(fileMapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(fileMapping);
+        }
+        *outSize = (size_t)size.QuadPart;
+    }
+    CloseHandle(file);
+    return mapping;
+#else
+    const int32_t fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    void* mapping = NULL;
+    if (fstat(fd, &info) == 0 && info.st_size > 0 && (uint64_t)info.st_size <= SIZE_MAX) {
+        // The mapping keeps the file open, so the descriptor isn't needed past here:
+        mapping = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+        *outSize = (size_t)info.st_size;
+    }
+    close(fd);
+    return mapping;
+#endif
+}
+
+// Write zeroes from 'position' up to the next multiple of 'alignment'.
+static bool Snapshot_WritePadding(FILE *const file, const uint64_t position, const uint64_t alignment) {
+    static const uint8_t zeroes[64] = { 0 };
+    const uint64_t padding = Snapshot_Align(position, alignment) - position;
+    assert(padding <= sizeof(zeroes));
+    return padding == 0 || fwrite(zeroes, (size_t)padding, 1, file) == 1;
+}
+
+// Check that everything the header describes is compatible and fits within the file, and that nothing stored
+// (samplers and rooms) can lead to reading or writing out of bounds once the game carries on.
+static bool Snapshot_IsValid(const SnapshotHeader *const header, const uint8_t *const mapping, const size_t size) {
+    if (size < sizeof(*header)
+        || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != SNAPSHOT_VERSION
+        || header->headerSize != sizeof(SnapshotHeader)
+        || header->dungeonSize != sizeof(Dungeon)
+        || header->playerSize != sizeof(Player)
+        || header->scalarSize != sizeof(vec2_scalar)
+        || header->byteOrder != snapshotByteOrder) {
+        return false;
+    }
+    if (header->dungeonOffset % snapshotDungeonAlignment != 0
+        || header->dungeonLength < sizeof(Dungeon)
+        || header->dungeonOffset > size
+        || header->dungeonLength > size - header->dungeonOffset) {
+        return false;
+    }
+
+    const Dungeon *const dungeon = (const Dungeon*)(mapping + header->dungeonOffset);
+    if (dungeon->base != NULL
+        || dungeon->size[0] <= 0 || dungeon->size[1] <= 0
+        || !Dungeon_Contains(dungeon, dungeon->spawnPosition)
+        || !Dungeon_Contains(dungeon, dungeon->treasurePosition)
+        || !Dungeon_Contains(dungeon, header->player.position.current)
+        || !Snapshot_IsValidSampler(&dungeon->items, _ITEM_TYPE_COUNT, 0)) {
+        return false;
+    }
+    switch (dungeon->generation) {
+        case DUNGEON_GENERATION_DENSE: {
+            const uint64_t roomCount = (uint64_t)Dungeon_RoomCount(dungeon);
+            const uint64_t visitedWords = (roomCount + 63) / 64;
+            if (header->roomsOffset != sizeof(Dungeon)
+                || header->visitedOffset % sizeof(uint64_t) != 0
+                || header->visitedOffset < header->roomsOffset + sizeof(PackedRoom) * roomCount
+                || header->visitedOffset + sizeof(uint64_t) * visitedWords != header->dungeonLength
+                || header->changedRoomsOffset != 0) {
+                return false;
+            }
+            const PackedRoom *const rooms = (const PackedRoom*)((const uint8_t*)dungeon + header->roomsOffset);
+            for (uint64_t i = 0; i < roomCount; ++i) {
+                if (!Snapshot_IsValidRoom(rooms[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case DUNGEON_GENERATION_HASHED: {
+            const RoomTable *const table = &dungeon->changedRooms;
+            // Every other room is drawn from this, which must never produce the rooms that only appear once:
+            const uint32_t uniqueRooms = (1u << ROOM_TREASURE) | (1u << ROOM_SPAWN);
+            if (header->roomsOffset != 0
+                || header->visitedOffset != 0
+                || !Snapshot_IsValidSampler(&dungeon->roomTypes, _ROOM_TYPE_COUNT, uniqueRooms)) {
+                return false;
+            }
+            if (table->capacity == 0) {
+                return table->count == 0 && header->changedRoomsOffset == 0;
+            }
+            const uint64_t entriesSize = sizeof(table->entries[0]) * (uint64_t)table->capacity;
+            if ((table->capacity & (table->capacity - 1)) != 0
+                || table->count < 0 || table->count >= table->capacity
+                || (uint64_t)table->capacity > size / sizeof(table->entries[0])
+                || header->changedRoomsOffset % sizeof(table->entries[0]) != 0
+                || header->changedRoomsOffset < header->dungeonOffset + header->dungeonLength
+                || header->changedRoomsOffset > size
+                || entriesSize > size - header->changedRoomsOffset) {
+                return false;
+            }
+            const RoomTableEntry *const entries = (const RoomTableEntry*)(mapping + header->changedRoomsOffset);
+            int64_t occupied = 0;
+            for (int64_t i = 0; i < table->capacity; ++i) {
+                // Empty slots (keyed UINT64_MAX) are never read as rooms, so whatever they hold doesn't matter:
+                if (entries[i].key == UINT64_MAX) {
+                    continue;
+                }
+                if (!Snapshot_IsValidRoom(entries[i].room)) {
+                    return false;
+                }
+                occupied += 1;
+            }
+            // Lookups probe until they find an empty slot, so there must really be one (count < capacity):
+            return occupied == table->count;
+        }
+        case DUNGEON_GENERATION_TILED: {
+            // Tiled dungeons are stored as dense ones:
+            return false;
+        }
+    }
+    return false;
+}
+
+// Check that 'sampler' draws from exactly 'count' entries, and can never produce any of those in 'excludedMask'.
+static bool Snapshot_IsValidSampler(const Sampler *const sampler, const int32_t count, const uint32_t excludedMask) {
+    if (sampler->count != count) {
+        return false;
+    }
+    for (int32_t column = 0; column < count; ++column) {
+        // A column with a threshold of 0 always takes its alias, so never produces itself:
+        const bool keepsColumn = sampler->threshold[column] > 0;
+        if (sampler->alias[column] >= count
+            || (keepsColumn && (excludedMask & (1u << column)) != 0)
+            || (excludedMask & (1u << sampler->alias[column])) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check that 'room' could have been generated (or left behind by play), as the game assumes of every room.
+static bool Snapshot_IsValidRoom(const PackedRoom room) {
+    const RoomType type = PackedRoom_GetType(room);
+    switch (type) {
+        case ROOM_ITEM: return PackedRoom_GetFieldA(room) < _ITEM_TYPE_COUNT;
+        // Traps and enemies are cleared as soon as they're used up:
+        case ROOM_TRAP: return PackedRoom_GetFieldA(room) >= 1;
+        case ROOM_ENEMY: return PackedRoom_GetFieldA(room) >= 1 && PackedRoom_GetFieldB(room) >= 2;
+        default: return type < _ROOM_TYPE_COUNT;
+    }
+}
+
+// Check that the rest of the saved game is one that could actually be played on from 'game->dungeon'.
+static bool Snapshot_IsValidGame(const SnapshotHeader *const header, const GameState *const game) {
+    const Player *const player = &game->player;
+    const int32_t dx = player->position.current[0] - player->position.previous[0];
+    const int32_t dy = player->position.current[1] - player->position.previous[1];
+    if (header->status != GAME_STATUS_PLAYING
+        // The player always faces along one axis:
+        || abs(dx) + abs(dy) != 1
+        || player->health.max <= 0 || player->health.max > GAME_PLAYER_MAX_HEALTH
+        || player->health.current <= 0 || player->health.current > player->health.max) {
+        return false;
+    }
+    // Pit and combat actions assume there's still a pit or enemy in the room:
+    const RoomType type = Dungeon_GetRoomType(game->dungeon, player->position.current);
+    switch (header->encounter) {
+        case ENCOUNTER_NONE: return type != ROOM_TREASURE;
+        case ENCOUNTER_PIT: return type == ROOM_PIT;
+        case ENCOUNTER_ENEMY: return type == ROOM_ENEMY;
+    }
+    return false;
+}
+
+static inline uint64_t Snapshot_Align(const uint64_t value, const uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
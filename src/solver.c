@@ -0,0 +1,433 @@
+#include "dungeon/solver.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "dungeon/item.h"
+#include "dungeon/parallel.h"
+#include "dungeon/util.h"
+
+// Randf32() returns k/2^24, so these are the exact chances of the comparisons in Game_HandleEnemyAction():
+// Randf32() > 0.5f
+const double solverAboveHalfChance = 8388607.0 / 16777216.0;
+// 0.5f < Randf32() <= 0.8f
+const double solverFleeHitChance = 5033165.0 / 16777216.0;
+// Randf32() > 0.8f
+const double solverFleeCleanChance = 3355442.0 / 16777216.0;
+// Enemies can't do any damage below this (see RandRangei32(1, maxDamage) in Game_HandleEnemyAction()):
+const int32_t solverMinEnemyDamage = 2;
+// Only spend food when it improves the odds by more than this:
+const double solverFoodTolerance = 1e-6;
+
+typedef struct SolverOutcome {
+    double win;
+    double retreat;
+} SolverOutcome;
+
+static void Solver_SolveTable(void* context, int32_t index, int32_t worker);
+static SolverOutcome Solver_Fight(
+    const Solver* self,
+    bool hasSword,
+    int32_t maxDamage,
+    int32_t food,
+    int32_t shields,
+    int32_t enemyHealth,
+    int32_t health
+);
+static SolverOutcome Solver_Flee(
+    const Solver* self,
+    bool hasSword,
+    int32_t maxDamage,
+    int32_t food,
+    int32_t shields,
+    int32_t enemyHealth,
+    int32_t health
+);
+static SolverOutcome Solver_EatInFight(
+    const Solver* self,
+    bool hasSword,
+    int32_t maxDamage,
+    int32_t food,
+    int32_t shields,
+    int32_t enemyHealth,
+    int32_t health
+);
+static SolverOutcome Solver_Jump(int32_t food, int32_t otherItems);
+static SolverOutcome Solver_EatAtPit(const Solver* self, int32_t food, int32_t otherItems, int32_t health);
+static void Solver_Choose(const Solver* self, SolverEntry* best, Action action, SolverOutcome outcome);
+static inline void SolverOutcome_Add(SolverOutcome* self, double chance, const SolverEntry* next);
+static inline int64_t Solver_EnemyIndex(
+    const Solver* self,
+    bool hasSword,
+    int32_t maxDamage,
+    int32_t food,
+    int32_t shields,
+    int32_t enemyHealth,
+    int32_t health
+);
+static inline int64_t Solver_PitIndex(const Solver* self, int32_t food, int32_t otherItems, int32_t health);
+
+// Every (sword, enemy damage) pairing is solved independently, with one more task for the pit:
+static inline int32_t Solver_EnemyTableCount(void) {
+    return 2 * (SOLVER_MAX_ENEMY_DAMAGE - solverMinEnemyDamage + 1);
+}
+
+void Solver_Init(Solver *const self, const int8_t maxHealth, const float retreatValue, const int32_t threadCount) {
+    assert(self != NULL);
+    assert(maxHealth > 0 && maxHealth <= SOLVER_MAX_HEALTH);
+    assert(retreatValue >= 0.0f && retreatValue <= 1.0f);
+
+    self->maxHealth = maxHealth;
+    self->retreatValue = retreatValue;
+    // Index 0 is the same for every table, so the end of the last index covers the whole table:
+    const int64_t enemyCount = Solver_EnemyIndex(
+        self,
+        true,
+        SOLVER_MAX_ENEMY_DAMAGE,
+        SOLVER_MAX_FOOD,
+        SOLVER_MAX_SHIELDS,
+        SOLVER_MAX_ENEMY_HEALTH,
+        maxHealth
+    ) + 1;
+    const int64_t pitCount = Solver_PitIndex(self, SOLVER_MAX_FOOD, SOLVER_MAX_ITEMS, maxHealth) + 1;
+    // Dead (or defeated) states are never looked up, but are left zeroed so they read as lost:
+    self->enemy = calloc((size_t)enemyCount, sizeof(self->enemy[0]));
+    assert(self->enemy != NULL);
+    self->pit = calloc((size_t)pitCount, sizeof(self->pit[0]));
+    assert(self->pit != NULL);
+
+    Parallel_For(Solver_EnemyTableCount() + 1, threadCount, Solver_SolveTable, self);
+}
+
+void Solver_Destroy(Solver *const self) {
+    assert(self != NULL);
+    free(self->enemy);
+    free(self->pit);
+    self->enemy = NULL;
+    self->pit = NULL;
+}
+
+SolverEntry Solver_SolveEnemy(const Solver *const self, const Player *const player, const Room *const room) {
+    assert(self != NULL);
+    assert(player != NULL);
+    assert(room != NULL);
+    assert(room->type == ROOM_ENEMY);
+    assert(player->health.max == self->maxHealth);
+    assert(player->health.current > 0);
+    assert(room->enemy.health > 0 && room->enemy.health <= SOLVER_MAX_ENEMY_HEALTH);
+    assert(room->enemy.maxDamage >= solverMinEnemyDamage && room->enemy.maxDamage <= SOLVER_MAX_ENEMY_DAMAGE);
+
+    return self->enemy[Solver_EnemyIndex(
+        self,
+        player->inventory[ITEM_SWORD] > 0,
+        room->enemy.maxDamage,
+        Min(player->inventory[ITEM_FOOD], SOLVER_MAX_FOOD),
+        Min(player->inventory[ITEM_SHIELD], SOLVER_MAX_SHIELDS),
+        room->enemy.health,
+        player->health.current
+    )];
+}
+
+SolverEntry Solver_SolvePit(const Solver *const self, const Player *const player) {
+    assert(self != NULL);
+    assert(player != NULL);
+    assert(player->health.max == self->maxHealth);
+    assert(player->health.current > 0);
+
+    if (player->inventory[ITEM_HOOK] > 0 && player->inventory[ITEM_ROPE] > 0) {
+        // Swinging across always works:
+        return (SolverEntry) {
+            .win = 1.0f,
+            .retreat = 0.0f,
+            .action = ACTION_SWING,
+        };
+    }
+
+    int32_t otherItems = 0;
+    for (ItemType item = 0; item < _ITEM_TYPE_COUNT; ++item) {
+        otherItems += (item != ITEM_FOOD) ? player->inventory[item] : 0;
+    }
+    return self->pit[Solver_PitIndex(
+        self,
+        Min(player->inventory[ITEM_FOOD], SOLVER_MAX_FOOD),
+        Min(otherItems, SOLVER_MAX_ITEMS),
+        player->health.current
+    )];
+}
+
+Action Solver_ChooseAction(const Solver *const self, const GameState *const game) {
+    assert(self != NULL);
+    assert(game != NULL);
+
+    switch (game->encounter) {
+        case ENCOUNTER_NONE: {
+            return ACTION_NONE;
+        }
+        case ENCOUNTER_PIT: {
+            return (Action)Solver_SolvePit(self, &game->player).action;
+        }
+        case ENCOUNTER_ENEMY: {
+            const Room room = Game_GetCurrentRoom(game);
+            return (Action)Solver_SolveEnemy(self, &game->player, &room).action;
+        }
+    }
+
+    assert(false);
+    return ACTION_NONE;
+}
+
+static void Solver_SolveTable(void *const context, const int32_t index, const int32_t worker) {
+    (void)worker;
+    Solver *const self = context;
+
+    if (index == Solver_EnemyTableCount()) {
+        // Eating is the only way to change state without leaving, and it always uses up food,
+        // so solving in order of food means every state it leads to is already solved:
+        for (int32_t food = 0; food <= SOLVER_MAX_FOOD; ++food) {
+            for (int32_t otherItems = 0; otherItems <= SOLVER_MAX_ITEMS; ++otherItems) {
+                for (int32_t health = 1; health <= self->maxHealth; ++health) {
+                    SolverEntry *const entry = &self->pit[Solver_PitIndex(self, food, otherItems, health)];
+                    *entry = (SolverEntry) { .action = ACTION_NONE };
+                    Solver_Choose(self, entry, ACTION_JUMP, Solver_Jump(food, otherItems));
+                    Solver_Choose(self, entry, ACTION_RETURN, (SolverOutcome) { .win = 0.0, .retreat = 1.0 });
+                    if (food > 0 && health < self->maxHealth) {
+                        Solver_Choose(self, entry, ACTION_FOOD, Solver_EatAtPit(self, food, otherItems, health));
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    const bool hasSword = (index % 2) != 0;
+    const int32_t maxDamage = solverMinEnemyDamage + index / 2;
+    // Every action either uses up food, breaks a shield, wounds the enemy, wounds the player, or changes nothing
+    // at all, so solving in that order means every other state an action leads to is already solved:
+    for (int32_t food = 0; food <= SOLVER_MAX_FOOD; ++food) {
+        for (int32_t shields = 0; shields <= SOLVER_MAX_SHIELDS; ++shields) {
+            for (int32_t enemyHealth = 1; enemyHealth <= SOLVER_MAX_ENEMY_HEALTH; ++enemyHealth) {
+                for (int32_t health = 1; health <= self->maxHealth; ++health) {
+                    SolverEntry *const entry = &self->enemy[
+                        Solver_EnemyIndex(self, hasSword, maxDamage, food, shields, enemyHealth, health)
+                    ];
+                    *entry = (SolverEntry) { .action = ACTION_NONE };
+                    Solver_Choose(
+                        self,
+                        entry,
+                        ACTION_FIGHT,
+                        Solver_Fight(self, hasSword, maxDamage, food, shields, enemyHealth, health)
+                    );
+                    Solver_Choose(
+                        self,
+                        entry,
+                        ACTION_FLEE,
+                        Solver_Flee(self, hasSword, maxDamage, food, shields, enemyHealth, health)
+                    );
+                    if (food > 0 && health < self->maxHealth) {
+                        Solver_Choose(
+                            self,
+                            entry,
+                            ACTION_FOOD,
+                            Solver_EatInFight(self, hasSword, maxDamage, food, shields, enemyHealth, health)
+                        );
+                    }
+                }
+            }
+        }
+    }
+}
+
+static SolverOutcome Solver_Fight(
+    const Solver *const self,
+    const bool hasSword,
+    const int32_t maxDamage,
+    const int32_t food,
+    const int32_t shields,
+    const int32_t enemyHealth,
+    const int32_t health
+) {
+    SolverOutcome outcome = { 0 };
+    // Chance of ending up exactly where we started, which is the same as never having fought:
+    double unchangedChance = 0.0;
+
+    const int32_t minHit = hasSword ? 3 : 0;
+    const int32_t maxHit = hasSword ? 5 : 3;
+    const double hitChance = 1.0 / (maxHit - minHit + 1);
+    for (int32_t hit = minHit; hit <= maxHit; ++hit) {
+        const int32_t remaining = enemyHealth - hit;
+        if (remaining <= 0) {
+            outcome.win += hitChance;
+            continue;
+        }
+
+        if (shields > 0) {
+            for (int32_t blocked = 0; blocked <= 2; ++blocked) {
+                const double chance = hitChance / 3.0;
+                const int32_t wounded = health - blocked;
+                if (wounded <= 0) {
+                    continue;
+                }
+                SolverOutcome_Add(
+                    &outcome,
+                    chance * solverAboveHalfChance,
+                    &self->enemy[Solver_EnemyIndex(self, hasSword, maxDamage, food, shields - 1, remaining, wounded)]
+                );
+                if (remaining == enemyHealth && wounded == health) {
+                    unchangedChance += chance * (1.0 - solverAboveHalfChance);
+                } else {
+                    SolverOutcome_Add(
+                        &outcome,
+                        chance * (1.0 - solverAboveHalfChance),
+                        &self->enemy[Solver_EnemyIndex(self, hasSword, maxDamage, food, shields, remaining, wounded)]
+                    );
+                }
+            }
+        } else {
+            for (int32_t damage = 1; damage < maxDamage; ++damage) {
+                const int32_t wounded = health - damage;
+                if (wounded > 0) {
+                    SolverOutcome_Add(
+                        &outcome,
+                        hitChance / (maxDamage - 1),
+                        &self->enemy[Solver_EnemyIndex(self, hasSword, maxDamage, food, 0, remaining, wounded)]
+                    );
+                }
+            }
+        }
+    }
+
+    // Keep fighting until something changes:
+    outcome.win /= 1.0 - unchangedChance;
+    outcome.retreat /= 1.0 - unchangedChance;
+    return outcome;
+}
+
+static SolverOutcome Solver_Flee(
+    const Solver *const self,
+    const bool hasSword,
+    const int32_t maxDamage,
+    const int32_t food,
+    const int32_t shields,
+    const int32_t enemyHealth,
+    const int32_t health
+) {
+    SolverOutcome outcome = {
+        .win = 0.0,
+        .retreat = solverFleeCleanChance,
+    };
+    const double damageChance = 1.0 / (maxDamage - 1);
+    for (int32_t damage = 1; damage < maxDamage; ++damage) {
+        const int32_t wounded = health - damage;
+        if (wounded <= 0) {
+            continue;
+        }
+        // Hit on the way out:
+        outcome.retreat += solverFleeHitChance * damageChance;
+        // Caught, and still in the fight:
+        SolverOutcome_Add(
+            &outcome,
+            (1.0 - solverAboveHalfChance) * damageChance,
+            &self->enemy[Solver_EnemyIndex(self, hasSword, maxDamage, food, shields, enemyHealth, wounded)]
+        );
+    }
+    return outcome;
+}
+
+static SolverOutcome Solver_EatInFight(
+    const Solver *const self,
+    const bool hasSword,
+    const int32_t maxDamage,
+    const int32_t food,
+    const int32_t shields,
+    const int32_t enemyHealth,
+    const int32_t health
+) {
+    SolverOutcome outcome = { 0 };
+    for (int32_t gain = 1; gain <= 5; ++gain) {
+        const int32_t healed = Min(health + gain, self->maxHealth);
+        SolverOutcome_Add(
+            &outcome,
+            1.0 / 5.0,
+            &self->enemy[Solver_EnemyIndex(self, hasSword, maxDamage, food - 1, shields, enemyHealth, healed)]
+        );
+    }
+    return outcome;
+}
+
+static SolverOutcome Solver_Jump(const int32_t food, const int32_t otherItems) {
+    // Carry the same number of items as the state, and let the game decide the odds:
+    Player player = { 0 };
+    player.inventory[ITEM_FOOD] = (uint8_t)food;
+    player.inventory[ITEM_ROCK] = (uint8_t)otherItems;
+    const int32_t percentage = Clamp(Game_GetJumpSuccessPercentage(&player), 0, 100);
+    return (SolverOutcome) {
+        .win = percentage / 100.0,
+        .retreat = 0.0,
+    };
+}
+
+static SolverOutcome Solver_EatAtPit(
+    const Solver *const self,
+    const int32_t food,
+    const int32_t otherItems,
+    const int32_t health
+) {
+    SolverOutcome outcome = { 0 };
+    for (int32_t gain = 1; gain <= 5; ++gain) {
+        const int32_t healed = Min(health + gain, self->maxHealth);
+        SolverOutcome_Add(&outcome, 1.0 / 5.0, &self->pit[Solver_PitIndex(self, food - 1, otherItems, healed)]);
+    }
+    return outcome;
+}
+
+// Replace 'best' with 'action' if its outcome is worth more.
+static void Solver_Choose(
+    const Solver *const self,
+    SolverEntry *const best,
+    const Action action,
+    const SolverOutcome outcome
+) {
+    const double value = outcome.win + self->retreatValue * outcome.retreat;
+    const double bestValue = best->win + self->retreatValue * best->retreat;
+    // Food is worth keeping for later, so only eat when it makes a real difference:
+    const double tolerance = (action == ACTION_FOOD) ? solverFoodTolerance : 0.0;
+    if (best->action == ACTION_NONE || value > bestValue + tolerance) {
+        *best = (SolverEntry) {
+            .win = (float)outcome.win,
+            .retreat = (float)outcome.retreat,
+            .action = (uint8_t)action,
+        };
+    }
+}
+
+static inline void SolverOutcome_Add(SolverOutcome *const self, const double chance, const SolverEntry *const next) {
+    self->win += chance * next->win;
+    self->retreat += chance * next->retreat;
+}
+
+static inline int64_t Solver_EnemyIndex(
+    const Solver *const self,
+    const bool hasSword,
+    const int32_t maxDamage,
+    const int32_t food,
+    const int32_t shields,
+    const int32_t enemyHealth,
+    const int32_t health
+) {
+    int64_t index = hasSword ? 1 : 0;
+    index = index * (SOLVER_MAX_ENEMY_DAMAGE - solverMinEnemyDamage + 1) + (maxDamage - solverMinEnemyDamage);
+    index = index * (SOLVER_MAX_FOOD + 1) + food;
+    index = index * (SOLVER_MAX_SHIELDS + 1) + shields;
+    index = index * (SOLVER_MAX_ENEMY_HEALTH + 1) + enemyHealth;
+    return index * (self->maxHealth + 1) + health;
+}
+
+static inline int64_t Solver_PitIndex(
+    const Solver *const self,
+    const int32_t food,
+    const int32_t otherItems,
+    const int32_t health
+) {
+    return ((int64_t)food * (SOLVER_MAX_ITEMS + 1) + otherItems) * (self->maxHealth + 1) + health;
+}
@@ -0,0 +1,319 @@
+#include "dungeon/text.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dungeon/item.h"
+#include "dungeon/player.h"
+
+const char commonActionsText[] =
+    "Common Actions:\n"
+    "| 'exit' - quit\n"
+    "| 'help' - show this menu\n"
+    "| 'map' - display your current position and orientation,\n"
+    "|         as well as a map of previously explored rooms\n"
+    "| 'health' - show the amount of HEALTH you have remaining\n"
+    "| 'inventory' - display the totals of each item in your INVENTORY\n"
+    "| 'food' - consume 1 FOOD to regain HEALTH";
+
+const char movementActionsText[] =
+    "Movement Actions:\n"
+    "| 'forward' - move into the room you are currently facing\n"
+    "| 'back' - turn around and move back into the previous room\n"
+    "| 'left' - turn anti-clockwise and move into the next room\n"
+    "| 'right' - turn clockwise and move into the next room";
+
+const char pitActionsText[] =
+    "Pit Actions:\n"
+    "| 'jump' - attempt to jump across the pit, keeping in mind\n"
+    "|          that your gear's weight will influence your chances\n"
+    "| 'swing' - use 1 ROPE and 1 HOOK to guarrantee safe passage\n"
+    "| 'return' - retreat back into the previous room";
+
+const char enemyActionsText[] =
+    "Combat Actions:\n"
+    "| 'fight' - attack the enemy (your chances will improve with a SWORD)\n"
+    "| 'flee' - attempt to escape to the previous room";
+
+static void Text_AppendMap(
+    RenderBuffer* self,
+    const GameState* game,
+    bool onlyVisited,
+    TextMapCallback appendMap,
+    void* context
+);
+
+void Text_AppendWelcome(RenderBuffer *const self) {
+    RenderBuffer_AppendFormat(
+        self,
+        "--------------------------\n"
+        "Welcome to this dungeon.\n"
+        "You are searching this area for a treasure of great importance.\n"
+        "In each new room various events will occur and further instructions will appear.\n"
+        "\n"
+        "%s\n"
+        "%s\n",
+        commonActionsText,
+        movementActionsText
+    );
+}
+
+void Text_AppendStepResult(
+    RenderBuffer *const self,
+    const GameState *const game,
+    const StepResult *const result,
+    const char *const input,
+    const TextMapCallback appendMap,
+    void *const context
+) {
+    assert(self != NULL);
+    assert(game != NULL);
+    assert(result != NULL);
+    assert(input != NULL);
+
+    const Player *const player = &game->player;
+    for (int32_t i = 0; i < result->eventCount; ++i) {
+        const GameEvent *const event = &result->events[i];
+        switch (event->type) {
+            case GAME_EVENT_UNRECOGNISED: {
+                RenderBuffer_AppendFormat(self, "Unrecognised command '%s'.\n", input);
+            } break;
+            case GAME_EVENT_HELP: {
+                const char* actionsText = movementActionsText;
+                if (event->detail == ENCOUNTER_PIT) {
+                    actionsText = pitActionsText;
+                } else if (event->detail == ENCOUNTER_ENEMY) {
+                    actionsText = enemyActionsText;
+                }
+                RenderBuffer_AppendFormat(
+                    self,
+                    "%s\n"
+                    "%s\n",
+                    commonActionsText,
+                    actionsText
+                );
+            } break;
+            case GAME_EVENT_MAP: {
+                Text_AppendMap(self, game, true, appendMap, context);
+            } break;
+            case GAME_EVENT_HEALTH: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "Current HEALTH: %hhd/%hhd\n",
+                    player->health.current,
+                    player->health.max
+                );
+            } break;
+            case GAME_EVENT_INVENTORY: {
+                RenderBuffer_AppendFormat(self, "INVENTORY: {\n");
+                for (ItemType item = 0; item < _ITEM_TYPE_COUNT; ++item) {
+                    RenderBuffer_AppendFormat(self, "  %s: %hhd,\n", ItemType_ToString(item), player->inventory[item]);
+                }
+                RenderBuffer_AppendFormat(self, "}\n");
+            } break;
+            case GAME_EVENT_FOOD_EMPTY: {
+                RenderBuffer_AppendFormat(self, "You have no FOOD.\n");
+            } break;
+            case GAME_EVENT_FOOD_FULL: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You already have max HEALTH (%hhd/%hhd).\n",
+                    player->health.current,
+                    player->health.max
+                );
+            } break;
+            case GAME_EVENT_FOOD_EATEN: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You consume 1 FOOD and regain %hhd HEALTH (%hhd/%hhd).\n",
+                    event->amount,
+                    player->health.current,
+                    player->health.max
+                );
+            } break;
+            case GAME_EVENT_WALL: {
+                RenderBuffer_AppendFormat(self, "You come upon a solid wall - please choose a new direction.\n");
+            } break;
+            case GAME_EVENT_MOVED: {
+                switch ((Action)event->detail) {
+                    case ACTION_FORWARD: {
+                        RenderBuffer_AppendFormat(self, "You move forward into the next room.\n");
+                    } break;
+                    case ACTION_BACK: {
+                        RenderBuffer_AppendFormat(self, "You edge back into the room from whence you came.\n");
+                    } break;
+                    case ACTION_LEFT: {
+                        RenderBuffer_AppendFormat(self, "You turn left into the next room.\n");
+                    } break;
+                    case ACTION_RIGHT: {
+                        RenderBuffer_AppendFormat(self, "You turn right into the next room.\n");
+                    } break;
+                    default: {
+                        assert(false);
+                    } break;
+                }
+            } break;
+            case GAME_EVENT_ROOM_ENTERED: {
+                RenderBuffer_AppendFormat(self, "--------------------------\n");
+                switch ((RoomType)event->detail) {
+                    case ROOM_EMPTY: {
+                        RenderBuffer_AppendFormat(self, "You come across an empty room.\n");
+                    } break;
+                    case ROOM_SPAWN: {
+                        RenderBuffer_AppendFormat(self, "You stand at the entrance to the dungeon.\n");
+                    } break;
+                    case ROOM_PIT: {
+                        RenderBuffer_AppendFormat(
+                            self,
+                            "You come across a seemingly bottomless pit.\n"
+                            "%s\n",
+                            pitActionsText
+                        );
+                    } break;
+                    case ROOM_ENEMY: {
+                        RenderBuffer_AppendFormat(
+                            self,
+                            "A vicious cave beast blocks your path.\n"
+                            "%s\n",
+                            enemyActionsText
+                        );
+                    } break;
+                    default: {
+                        // These rooms are described by their own events:
+                    } break;
+                }
+            } break;
+            case GAME_EVENT_ITEM_FOUND: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You found a %s! You now have %hhd.\n",
+                    ItemType_ToString((ItemType)event->detail),
+                    player->inventory[event->detail]
+                );
+            } break;
+            case GAME_EVENT_TRAP_TRIGGERED: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You step on a trap and lose %hhd HEALTH (%hhd/%hhd remaining).\n",
+                    event->amount,
+                    player->health.current,
+                    player->health.max
+                );
+            } break;
+            case GAME_EVENT_TRAP_DESTROYED: {
+                RenderBuffer_AppendFormat(self, "The trap is destroyed and will cause you no more harm.\n");
+            } break;
+            case GAME_EVENT_PIT_JUMPED: {
+                RenderBuffer_AppendFormat(self, "You successfully jump the pit!\n");
+            } break;
+            case GAME_EVENT_PIT_FELL: {
+                RenderBuffer_AppendFormat(self, "You fall to your doom in your attempt to clear the pit.\n");
+            } break;
+            case GAME_EVENT_PIT_SWUNG: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "Using your HOOK and ROPE, you swing to safety on the other side of the pit.\n"
+                );
+            } break;
+            case GAME_EVENT_PIT_SWING_FAILED: {
+                RenderBuffer_AppendFormat(self, "You must have at least 1 ROPE and 1 HOOK in order to swing across.\n");
+            } break;
+            case GAME_EVENT_PIT_RETURNED: {
+                RenderBuffer_AppendFormat(self, "You edge back into the room from whence you came.\n");
+            } break;
+            case GAME_EVENT_ENEMY_HIT: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You hit the beast with your %s and deal %hhd damage.\n",
+                    event->detail ? "SWORD" : "fists",
+                    event->amount
+                );
+            } break;
+            case GAME_EVENT_ENEMY_DEFEATED: {
+                RenderBuffer_AppendFormat(self, "The beast is defeated!\n");
+            } break;
+            case GAME_EVENT_SHIELD_HIT: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "The beast hits your SHIELD and you take %hhd damage.\n",
+                    event->amount
+                );
+            } break;
+            case GAME_EVENT_SHIELD_BROKEN: {
+                RenderBuffer_AppendFormat(self, "Your SHIELD breaks!\n");
+            } break;
+            case GAME_EVENT_PLAYER_HIT: {
+                RenderBuffer_AppendFormat(self, "The beast hits you and deals %hhd damage.\n", event->amount);
+            } break;
+            case GAME_EVENT_FLED: {
+                if (event->amount == 0) {
+                    RenderBuffer_AppendFormat(self, "You successfully evade the creature without harm.\n");
+                } else {
+                    RenderBuffer_AppendFormat(
+                        self,
+                        "You successfully evade the creature, "
+                        "but lose %hhd HEALTH in the process (%hhd/%hhd remaining).\n",
+                        event->amount,
+                        player->health.current,
+                        player->health.max
+                    );
+                }
+            } break;
+            case GAME_EVENT_FLEE_FAILED: {
+                RenderBuffer_AppendFormat(
+                    self,
+                    "You fail to evade the creature and lose %hhd HEALTH in the process.\n",
+                    event->amount
+                );
+            } break;
+            case GAME_EVENT_TREASURE_FOUND: {
+                Text_AppendMap(self, game, false, appendMap, context);
+                RenderBuffer_AppendFormat(self, "Congratulations, you have found the treasure!\n");
+            } break;
+            case GAME_EVENT_DIED: {
+                Text_AppendMap(self, game, false, appendMap, context);
+                RenderBuffer_AppendFormat(self, "YOU DIED!\n");
+            } break;
+            case _GAME_EVENT_TYPE_COUNT: {
+                assert(false);
+            } break;
+        }
+    }
+}
+
+void Text_AppendStatus(RenderBuffer *const self, const GameState *const game) {
+    assert(game != NULL);
+    if (game->encounter == ENCOUNTER_ENEMY) {
+        RenderBuffer_AppendFormat(
+            self,
+            "You (%hhd/%hhd) | VS | Beast (%hhd/\?\?\?)\n",
+            game->player.health.current,
+            game->player.health.max,
+            Game_GetCurrentRoom(game).enemy.health
+        );
+    }
+}
+
+void Text_AppendPrompt(RenderBuffer *const self, const GameState *const game) {
+    Text_AppendStatus(self, game);
+    RenderBuffer_AppendFormat(
+        self,
+        "What do you do (type 'help' for a list of actions)?\n"
+        "> "
+    );
+}
+
+static void Text_AppendMap(
+    RenderBuffer *const self,
+    const GameState *const game,
+    const bool onlyVisited,
+    const TextMapCallback appendMap,
+    void *const context
+) {
+    if (appendMap != NULL) {
+        appendMap(context, self, game, onlyVisited);
+    } else {
+        Render_Map(self, game->dungeon, &game->player, onlyVisited);
+    }
+}
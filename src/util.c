@@ -3,23 +3,51 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <errno.h>
+#include <time.h>
 
-float Randf32(void) {
-    const float rng = (float)rand() / (float)RAND_MAX;
-    return Clamp(rng, 0.0f, 1.0f);
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+float Randf32(Rng *const rng) {
+    assert(rng != NULL);
+    // Use the top 24 bits, as that's all a float can represent exactly:
+    return (float)(Rng_Next(rng) >> 8) * (1.0f / 16777216.0f);
 }
 
-float RandRangef32(const float min, const float max) {
-    const float rng = (Randf32() * (max - min)) + min;
-    return Clamp(rng, min, max);
+float RandRangef32(Rng *const rng, const float min, const float max) {
+    const float value = (Randf32(rng) * (max - min)) + min;
+    return Clamp(value, min, max);
 }
 
-int32_t RandRangei32(const int32_t minInclusive, const int32_t maxExclusive) {
-    const int32_t rng = (int32_t)(Randf32() * (maxExclusive - minInclusive)) + minInclusive;
-    return Clamp(rng, minInclusive, maxExclusive - 1);
+int32_t RandRangei32(Rng *const rng, const int32_t minInclusive, const int32_t maxExclusive) {
+    assert(rng != NULL);
+    assert(maxExclusive > minInclusive);
+    // Scale into range with a multiply+shift rather than a division:
+    const uint32_t range = (uint32_t)maxExclusive - (uint32_t)minInclusive;
+    const uint32_t offset = (uint32_t)(((uint64_t)Rng_Next(rng) * range) >> 32);
+    return (int32_t)((uint32_t)minInclusive + offset);
+}
+
+int64_t RandRangei64(Rng *const rng, const int64_t minInclusive, const int64_t maxExclusive) {
+    assert(rng != NULL);
+    assert(maxExclusive > minInclusive);
+    const uint64_t range = (uint64_t)maxExclusive - (uint64_t)minInclusive;
+    uint64_t offset;
+    if (range <= UINT32_MAX) {
+        // Same as RandRangei32(), which covers every dungeon that fits in memory without wide coordinates:
+        offset = ((uint64_t)Rng_Next(rng) * range) >> 32;
+    } else {
+        // Modulo bias is negligible for ranges this far below 2^64:
+        offset = Rng_Next64(rng) % range;
+    }
+    return (int64_t)((uint64_t)minInclusive + offset);
 }
 
 int32_t RandIndex(
+    Rng *const rng,
     const int32_t weightCount,
     const int32_t weights[],
     int32_t totalWeight
@@ -31,14 +59,45 @@ int32_t RandIndex(
         }
     }
 
-    int32_t rng = RandRangei32(0, totalWeight);
+    int32_t value = RandRangei32(rng, 0, totalWeight);
     int32_t index;
-    for (index = 0; rng >= 0 && index < weightCount; ++index) {
-        rng -= weights[index];
+    for (index = 0; value >= 0 && index < weightCount; ++index) {
+        value -= weights[index];
     }
     return index - 1;
 }
 
+double Time_GetSeconds(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec time;
+    const int32_t _result = clock_gettime(CLOCK_MONOTONIC, &time);
+    assert(_result == 0);
+    (void)_result;
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#elif defined(TIME_MONOTONIC)
+    struct timespec time;
+    const int32_t _result = timespec_get(&time, TIME_MONOTONIC);
+    assert(_result == TIME_MONOTONIC);
+    (void)_result;
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#else
+    // Wall-clock time is all standard C11 has, which can jump if the system clock is changed:
+    struct timespec time;
+    const int32_t _result = timespec_get(&time, TIME_UTC);
+    assert(_result == TIME_UTC);
+    (void)_result;
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
 int32_t String_Compare_IgnoreCase(const int32_t maxSize, const char a[], const char b[]) {
     assert(a != NULL);
     assert(b != NULL);
@@ -48,3 +107,58 @@ int32_t String_Compare_IgnoreCase(const int32_t maxSize, const char a[], const c
     }
     return diff;
 }
+
+bool String_ParseUint64(const char *const value, uint64_t *const outValue) {
+    assert(value != NULL);
+    assert(outValue != NULL);
+    // strtoull() would skip whitespace and accept (and wrap) a sign:
+    if (!isdigit((unsigned char)value[0])) {
+        return false;
+    }
+    char* end = NULL;
+    errno = 0;
+    const unsigned long long parsed = strtoull(value, &end, 10);
+    if (*end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    *outValue = (uint64_t)parsed;
+    return true;
+}
+
+bool String_ParseSize(const char *const value, vec2 outSize) {
+    assert(value != NULL);
+    char* end = NULL;
+    const long width = strtol(value, &end, 10);
+    const long height = (*end == 'x') ? strtol(end + 1, &end, 10) : 0;
+    if (*end != '\0' || width <= 0 || height <= 0 || width > VEC2_SCALAR_MAX || height > VEC2_SCALAR_MAX) {
+        return false;
+    }
+    outSize[0] = (vec2_scalar)width;
+    outSize[1] = (vec2_scalar)height;
+    return true;
+}
+
+int32_t String_ParseWeights(const char *const value, const int32_t maxCount, int32_t weights[]) {
+    assert(value != NULL);
+    int32_t count = 0, total = 0;
+    const char* cursor = value;
+    while (count < maxCount) {
+        char* end = NULL;
+        const long weight = strtol(cursor, &end, 10);
+        if (end == cursor || weight < 0 || weight > INT16_MAX) {
+            return 0;
+        }
+        weights[count++] = (int32_t)weight;
+        total += (int32_t)weight;
+
+        cursor = end;
+        if (*cursor == '\0') {
+            break;
+        } else if (*cursor != ',') {
+            return 0;
+        }
+        ++cursor;
+    }
+    // Reject trailing values and all-zero weights:
+    return (*cursor == '\0' && total > 0) ? count : 0;
+}
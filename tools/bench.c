@@ -0,0 +1,1041 @@
+// Micro and macro benchmarks - times dungeon generation, layouts and validation, distance fields, region counts,
+// the random helpers, map rendering, movement, stepping games one at a time and in batches, and whole scripted
+// games, and reports per-operation percentiles as text, JSON or CSV.
+// With --check, instead checks that the fast paths being timed give the same results as the simple ones.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/batch.h"
+#include "dungeon/bot.h"
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/path.h"
+#include "dungeon/player.h"
+#include "dungeon/region.h"
+#include "dungeon/render.h"
+#include "dungeon/rng.h"
+#include "dungeon/snapshot.h"
+#include "dungeon/util.h"
+#include "dungeon/vec2.h"
+
+// Scripted games are cut off after this many turns, as in dungeon_sim:
+const int32_t benchMaxTurns = 10000;
+// Percentiles reported for every benchmark:
+const double benchPercentiles[] = { 0.5, 0.9, 0.99 };
+#define BENCH_PERCENTILE_COUNT (sizeof(benchPercentiles) / sizeof(benchPercentiles[0]))
+// Games stepped together by the batch benchmark:
+#define BENCH_BATCH_GAMES 256
+// Steps of the whole batch compared against games stepped one at a time by --check:
+const int32_t benchCheckBatchSteps = 2000;
+// Rooms changed (and distance fields updated) by --check, comparing against a rebuilt field after each one:
+const int32_t benchCheckFieldChanges = 1000;
+// Rooms changed (and region counts updated) by --check, and rectangles counted over after each change:
+const int32_t benchCheckRegionChanges = 1000;
+const int32_t benchCheckRegionQueries = 16;
+// Where --check saves the snapshots it loads back (removed afterwards):
+const char *const benchCheckSnapshotPath = "dungeon_bench_check.snap";
+// Most steps --check plays before saving a game:
+const int32_t benchCheckSnapshotSteps = 50;
+
+typedef enum BenchFormat {
+    BENCH_FORMAT_TEXT,
+    BENCH_FORMAT_JSON,
+    BENCH_FORMAT_CSV,
+} BenchFormat;
+
+typedef struct BenchConfig {
+    // Only run benchmarks whose name contains this (or all of them if NULL):
+    const char* filter;
+    int32_t warmups;
+    int32_t repetitions;
+    // Each repetition runs enough iterations to take at least this long:
+    double minSampleTime;
+    BenchFormat format;
+    // Run the checks rather than the benchmarks:
+    bool check;
+} BenchConfig;
+
+// Everything a benchmark works on, set up before it is timed.
+typedef struct BenchState {
+    Rng rng;
+    vec2 size;
+    Dungeon* dungeon;
+    Player player;
+    RenderBuffer buffer;
+    // Created by the step benchmarks the first time they run:
+    GameState game;
+    GameBatch batch;
+    int64_t gameIndex;
+    // Distances to the treasure of 'dungeon', created by the distance field benchmarks the first time they run:
+    DistanceField field;
+    // Room counts of 'dungeon', created by the region benchmarks the first time they run:
+    RegionStats regions;
+    // Folded into by every benchmark so the work can't be optimised away:
+    uint64_t sink;
+} BenchState;
+
+typedef void (*BenchFunction)(BenchState* state, int64_t iterations);
+
+typedef struct Bench {
+    const char* name;
+    // What one iteration is:
+    const char* unit;
+    // Dungeon the benchmark works on (0 by 0 if it doesn't need one):
+    vec2 size;
+    BenchFunction run;
+} Bench;
+
+// Compares a fast path against a simple reference on a dungeon of 'size', returning false (after saying why on
+// stderr) on any difference.
+typedef bool (*BenchCheckFunction)(const vec2 size);
+
+typedef struct BenchCheck {
+    const char* name;
+    vec2 size;
+    BenchCheckFunction run;
+} BenchCheck;
+
+typedef struct BenchResult {
+    int64_t iterations;
+    int32_t samples;
+    // Nanoseconds per iteration:
+    double min;
+    double mean;
+    double percentiles[BENCH_PERCENTILE_COUNT];
+    double max;
+} BenchResult;
+
+static void Bench_CreateDungeon(BenchState* state, int64_t iterations);
+static void Bench_CreateTiledDungeon(BenchState* state, int64_t iterations);
+static void Bench_GenerateLayout(BenchState* state, int64_t iterations);
+static void Bench_CheckSolvable(BenchState* state, int64_t iterations);
+static void Bench_InitDistanceField(BenchState* state, int64_t iterations);
+static void Bench_ClearDistanceField(BenchState* state, int64_t iterations);
+static RegionStats* Bench_GetRegionStats(BenchState* state);
+static void Bench_CountRoomsNear(BenchState* state, int64_t iterations);
+static void Bench_ClearRegionStats(BenchState* state, int64_t iterations);
+static void Bench_RandIndex(BenchState* state, int64_t iterations);
+static void Bench_RandRangei32(BenchState* state, int64_t iterations);
+static void Bench_RenderMap(BenchState* state, int64_t iterations);
+static void Bench_PlayerMove(BenchState* state, int64_t iterations);
+static void Bench_GameStep(BenchState* state, int64_t iterations);
+static void Bench_BatchStep(BenchState* state, int64_t iterations);
+static Action Bench_RandomAction(Rng* rng);
+static void Bench_ScriptedGame(BenchState* state, int64_t iterations);
+static bool Bench_CheckBatchStep(const vec2 size);
+static void Bench_StartBatchGame(const GameBatch* batch, int32_t index, int64_t episode, GameState* outGame);
+static bool Bench_CheckDistanceField(const vec2 size);
+static bool Bench_CheckRegionStats(const vec2 size);
+static bool Bench_CheckRegionQuery(const RegionStats* regions, const Dungeon* dungeon, int32_t layer, Rng* rng);
+static bool Bench_CheckSnapshot(const vec2 size);
+static bool Bench_CheckSnapshotGeneration(const vec2 size, DungeonGeneration generation);
+static bool Bench_WriteFile(const char* path, const uint8_t* data, size_t size);
+
+const Bench benches[] = {
+    { "dungeon_create/10x10", "dungeon", { 10, 10 }, Bench_CreateDungeon },
+    { "dungeon_create/32x32", "dungeon", { 32, 32 }, Bench_CreateDungeon },
+    { "dungeon_create/100x100", "dungeon", { 100, 100 }, Bench_CreateDungeon },
+#if defined(DUNGEON_WIDE_COORDS)
+    { "dungeon_create/1000x1000", "dungeon", { 1000, 1000 }, Bench_CreateDungeon },
+#endif
+    { "dungeon_create_tiled/100x100", "dungeon", { 100, 100 }, Bench_CreateTiledDungeon },
+#if defined(DUNGEON_WIDE_COORDS)
+    { "dungeon_create_tiled/1000x1000", "dungeon", { 1000, 1000 }, Bench_CreateTiledDungeon },
+#endif
+    { "dungeon_layout/10x10", "dungeon", { 10, 10 }, Bench_GenerateLayout },
+    { "dungeon_layout/100x100", "dungeon", { 100, 100 }, Bench_GenerateLayout },
+    { "dungeon_solvable/10x10", "dungeon", { 10, 10 }, Bench_CheckSolvable },
+    { "dungeon_solvable/100x100", "dungeon", { 100, 100 }, Bench_CheckSolvable },
+#if defined(DUNGEON_WIDE_COORDS)
+    { "dungeon_solvable/1000x1000", "dungeon", { 1000, 1000 }, Bench_CheckSolvable },
+#endif
+    { "distance_field_init/100x100", "field", { 100, 100 }, Bench_InitDistanceField },
+#if defined(DUNGEON_WIDE_COORDS)
+    { "distance_field_init/1000x1000", "field", { 1000, 1000 }, Bench_InitDistanceField },
+#endif
+    { "distance_field_clear/100x100", "room", { 100, 100 }, Bench_ClearDistanceField },
+    { "region_count_near/100x100", "query", { 100, 100 }, Bench_CountRoomsNear },
+    { "region_clear/100x100", "room", { 100, 100 }, Bench_ClearRegionStats },
+    { "rand_index", "call", { 0, 0 }, Bench_RandIndex },
+    { "rand_range_i32", "call", { 0, 0 }, Bench_RandRangei32 },
+    { "render_map/10x10", "map", { 10, 10 }, Bench_RenderMap },
+    { "render_map/100x100", "map", { 100, 100 }, Bench_RenderMap },
+    { "player_move", "call", { 10, 10 }, Bench_PlayerMove },
+    { "game_step/10x10", "step", { 10, 10 }, Bench_GameStep },
+    { "batch_step/10x10", "step", { 10, 10 }, Bench_BatchStep },
+    { "scripted_game/10x10", "game", { 10, 10 }, Bench_ScriptedGame },
+};
+
+const BenchCheck checks[] = {
+    { "batch_step/10x10", { 10, 10 }, Bench_CheckBatchStep },
+    { "distance_field_update/100x100", { 100, 100 }, Bench_CheckDistanceField },
+    { "region_count/100x100", { 100, 100 }, Bench_CheckRegionStats },
+    { "snapshot_load/32x32", { 32, 32 }, Bench_CheckSnapshot },
+};
+
+static void Bench_PrintUsage(const char* program);
+static bool Bench_ParseArgs(int32_t argc, const char *const argv[], BenchConfig* config);
+static BenchResult Bench_Run(const BenchConfig* config, const Bench* bench);
+static double Bench_TimeSample(const Bench* bench, BenchState* state, int64_t iterations);
+static int32_t Bench_CompareSamples(const void* a, const void* b);
+static void Bench_PrintHeader(const BenchConfig* config);
+static void Bench_PrintResult(const BenchConfig* config, const Bench* bench, const BenchResult* result, bool first);
+static void Bench_PrintFooter(const BenchConfig* config);
+static bool Bench_RunChecks(const BenchConfig* config);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    BenchConfig config = {
+        .filter = NULL,
+        .warmups = 3,
+        .repetitions = 25,
+        .minSampleTime = 0.01,
+        .format = BENCH_FORMAT_TEXT,
+        .check = false,
+    };
+    if (!Bench_ParseArgs(argc, argv, &config)) {
+        Bench_PrintUsage(argv[0]);
+        return 1;
+    }
+    if (config.check) {
+        return Bench_RunChecks(&config) ? 0 : 1;
+    }
+
+    Bench_PrintHeader(&config);
+    bool first = true;
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i) {
+        const Bench *const bench = &benches[i];
+        if (config.filter != NULL && strstr(bench->name, config.filter) == NULL) {
+            continue;
+        }
+        const BenchResult result = Bench_Run(&config, bench);
+        Bench_PrintResult(&config, bench, &result, first);
+        first = false;
+    }
+    Bench_PrintFooter(&config);
+    return 0;
+}
+
+static void Bench_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "| --filter TEXT      only run benchmarks whose name contains TEXT\n"
+        "| --warmup N         untimed repetitions before measuring (default: 3)\n"
+        "| --repetitions N    timed repetitions, which percentiles are taken over (default: 25)\n"
+        "| --min-time MS      run each repetition for at least this many milliseconds (default: 10)\n"
+        "| --format FORMAT    text, json or csv (default: text)\n"
+        "| --check            check the fast paths against simple references instead of timing anything\n"
+        "|                    (--filter still applies), failing if any of them differ\n",
+        program
+    );
+}
+
+static bool Bench_ParseArgs(const int32_t argc, const char *const argv[], BenchConfig *const config) {
+    for (int32_t i = 1; i < argc; ++i) {
+        const char *const arg = argv[i];
+        const char *const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (strcmp(arg, "--check") == 0) {
+            config->check = true;
+            continue;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for '%s'.\n", arg);
+            return false;
+        }
+        ++i;
+
+        char* end = NULL;
+        if (strcmp(arg, "--filter") == 0) {
+            config->filter = value;
+        } else if (strcmp(arg, "--warmup") == 0) {
+            config->warmups = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->warmups < 0) {
+                fprintf(stderr, "Invalid warm-up count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--repetitions") == 0) {
+            config->repetitions = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->repetitions <= 0) {
+                fprintf(stderr, "Invalid repetition count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--min-time") == 0) {
+            config->minSampleTime = strtod(value, &end) / 1000.0;
+            if (*end != '\0' || !(config->minSampleTime > 0.0)) {
+                fprintf(stderr, "Invalid minimum time '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--format") == 0) {
+            if (strcmp(value, "text") == 0) {
+                config->format = BENCH_FORMAT_TEXT;
+            } else if (strcmp(value, "json") == 0) {
+                config->format = BENCH_FORMAT_JSON;
+            } else if (strcmp(value, "csv") == 0) {
+                config->format = BENCH_FORMAT_CSV;
+            } else {
+                fprintf(stderr, "Unknown format '%s'.\n", value);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+static BenchResult Bench_Run(const BenchConfig *const config, const Bench *const bench) {
+    BenchState state = {
+        .size = { bench->size[0], bench->size[1] },
+        .dungeon = NULL,
+        .gameIndex = 0,
+        .sink = 0,
+    };
+    Rng_Seed(&state.rng, 1, 0);
+    RenderBuffer_Init(&state.buffer);
+    if (bench->size[0] > 0) {
+        state.dungeon = Dungeon_Create(bench->size, &state.rng);
+        GameState game;
+        Game_Init(&game, state.dungeon, &state.rng);
+        state.player = game.player;
+    }
+
+    // Double the batch size until a batch takes long enough to time reliably (which also warms everything up):
+    int64_t iterations = 1;
+    while (Bench_TimeSample(bench, &state, iterations) < config->minSampleTime && iterations < INT64_MAX / 2) {
+        iterations *= 2;
+    }
+    for (int32_t i = 0; i < config->warmups; ++i) {
+        Bench_TimeSample(bench, &state, iterations);
+    }
+
+    double* samples = malloc((size_t)config->repetitions * sizeof(double));
+    assert(samples != NULL);
+    double total = 0.0;
+    for (int32_t i = 0; i < config->repetitions; ++i) {
+        samples[i] = Bench_TimeSample(bench, &state, iterations) * 1e9 / (double)iterations;
+        total += samples[i];
+    }
+    qsort(samples, (size_t)config->repetitions, sizeof(double), Bench_CompareSamples);
+
+    BenchResult result = {
+        .iterations = iterations,
+        .samples = config->repetitions,
+        .min = samples[0],
+        .mean = total / config->repetitions,
+        .max = samples[config->repetitions - 1],
+    };
+    for (size_t i = 0; i < BENCH_PERCENTILE_COUNT; ++i) {
+        // Nearest rank:
+        int32_t rank = (int32_t)(benchPercentiles[i] * config->repetitions + 0.999999);
+        rank = (rank < 1) ? 1 : rank;
+        result.percentiles[i] = samples[rank - 1];
+    }
+
+    free(samples);
+    if (state.dungeon != NULL) {
+        Dungeon_Destroy(state.dungeon);
+    }
+    if (state.game.dungeon != NULL) {
+        Dungeon_Destroy(state.game.dungeon);
+    }
+    if (state.batch.count > 0) {
+        GameBatch_Destroy(&state.batch);
+    }
+    if (state.field.distances != NULL) {
+        DistanceField_Destroy(&state.field);
+    }
+    if (state.regions.rooms != NULL) {
+        RegionStats_Destroy(&state.regions);
+    }
+    RenderBuffer_Destroy(&state.buffer);
+    // Keep the sink observable, so none of the work can be optimised away:
+    if (state.sink == 0x5EED) {
+        fprintf(stderr, "\n");
+    }
+    return result;
+}
+
+// Run 'iterations' of 'bench', returning how many seconds it took.
+static double Bench_TimeSample(const Bench *const bench, BenchState *const state, const int64_t iterations) {
+    const double startTime = Time_GetSeconds();
+    bench->run(state, iterations);
+    return Time_GetSeconds() - startTime;
+}
+
+static int32_t Bench_CompareSamples(const void *const a, const void *const b) {
+    const double sampleA = *(const double*)a;
+    const double sampleB = *(const double*)b;
+    return (sampleA > sampleB) - (sampleA < sampleB);
+}
+
+static void Bench_CreateDungeon(BenchState *const state, const int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+        Dungeon *const dungeon = Dungeon_Create(state->size, &state->rng);
+        state->sink += (uint64_t)dungeon->treasurePosition[0];
+        Dungeon_Destroy(dungeon);
+    }
+}
+
+static void Bench_CreateTiledDungeon(BenchState *const state, const int64_t iterations) {
+    DungeonParams params = DungeonParams_Default(state->size);
+    params.generation = DUNGEON_GENERATION_TILED;
+    for (int64_t i = 0; i < iterations; ++i) {
+        Dungeon *const dungeon = Dungeon_CreateWithParams(&params, &state->rng);
+        state->sink += (uint64_t)dungeon->treasurePosition[0];
+        Dungeon_Destroy(dungeon);
+    }
+}
+
+// Draw just the room types, as dungeon_seeds does for every seed it checks.
+static void Bench_GenerateLayout(BenchState *const state, const int64_t iterations) {
+    const DungeonParams params = DungeonParams_Default(state->size);
+    uint8_t *const types = malloc(sizeof(types[0]) * (size_t)((int64_t)state->size[0] * state->size[1]));
+    assert(types != NULL);
+    for (int64_t i = 0; i < iterations; ++i) {
+        vec2 spawnPosition, treasurePosition;
+        Dungeon_GenerateLayout(&params, &state->rng, types, spawnPosition, treasurePosition);
+        state->sink += (uint64_t)treasurePosition[0];
+    }
+    free(types);
+}
+
+static void Bench_CheckSolvable(BenchState *const state, const int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+        state->sink += Dungeon_IsSolvable(state->dungeon, 1);
+    }
+}
+
+static void Bench_InitDistanceField(BenchState *const state, const int64_t iterations) {
+    int32_t costs[_ROOM_TYPE_COUNT];
+    DistanceField_GetDefaultCosts(costs);
+    for (int64_t i = 0; i < iterations; ++i) {
+        DistanceField field;
+        DistanceField_Init(&field, state->dungeon, ROOM_TREASURE, costs);
+        state->sink += (uint64_t)DistanceField_Get(&field, state->dungeon->spawnPosition);
+        DistanceField_Destroy(&field);
+    }
+}
+
+// Clear a random room and put it back again, updating the distances to the treasure each time.
+static void Bench_ClearDistanceField(BenchState *const state, const int64_t iterations) {
+    Dungeon *const dungeon = state->dungeon;
+    DistanceField *const field = &state->field;
+    if (field->distances == NULL) {
+        int32_t costs[_ROOM_TYPE_COUNT];
+        DistanceField_GetDefaultCosts(costs);
+        DistanceField_Init(field, dungeon, ROOM_TREASURE, costs);
+    }
+    for (int64_t i = 0; i < iterations; ++i) {
+        const vec2 position = {
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[0]),
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[1]),
+        };
+        const Room room = Dungeon_GetRoom(dungeon, position);
+        Room cleared = room;
+        Room_Clear(&cleared);
+        Dungeon_SetRoom(dungeon, position, &cleared);
+        DistanceField_Update(field, dungeon, position);
+        Dungeon_SetRoom(dungeon, position, &room);
+        DistanceField_Update(field, dungeon, position);
+    }
+    state->sink += (uint64_t)DistanceField_Get(field, dungeon->spawnPosition);
+}
+
+static RegionStats* Bench_GetRegionStats(BenchState *const state) {
+    if (state->regions.rooms == NULL) {
+        RegionStats_Init(&state->regions, state->dungeon);
+    }
+    return &state->regions;
+}
+
+// Count the enemies within 8 rooms of a random room.
+static void Bench_CountRoomsNear(BenchState *const state, const int64_t iterations) {
+    const Dungeon *const dungeon = state->dungeon;
+    const RegionStats *const regions = Bench_GetRegionStats(state);
+    for (int64_t i = 0; i < iterations; ++i) {
+        const vec2 center = {
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[0]),
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[1]),
+        };
+        state->sink += (uint64_t)RegionStats_CountRoomsNear(regions, ROOM_ENEMY, center, 8);
+    }
+}
+
+// Clear a random room and put it back again, updating the room counts each time.
+static void Bench_ClearRegionStats(BenchState *const state, const int64_t iterations) {
+    Dungeon *const dungeon = state->dungeon;
+    RegionStats *const regions = Bench_GetRegionStats(state);
+    for (int64_t i = 0; i < iterations; ++i) {
+        const vec2 position = {
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[0]),
+            (vec2_scalar)RandRangei32(&state->rng, 0, dungeon->size[1]),
+        };
+        const Room room = Dungeon_GetRoom(dungeon, position);
+        Room cleared = room;
+        Room_Clear(&cleared);
+        Dungeon_SetRoom(dungeon, position, &cleared);
+        RegionStats_Update(regions, dungeon, position);
+        Dungeon_SetRoom(dungeon, position, &room);
+        RegionStats_Update(regions, dungeon, position);
+    }
+    state->sink += (uint64_t)RegionStats_CountRooms(regions, ROOM_ENEMY, (vec2) { 0, 0 }, (vec2) { 0, 0 });
+}
+
+static void Bench_RandIndex(BenchState *const state, const int64_t iterations) {
+    // Drawing room types from the default distribution, as dense generation does:
+    const DungeonParams params = DungeonParams_Default((vec2) { 10, 10 });
+    int32_t totalWeight = 0;
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        totalWeight += params.roomDistribution[i];
+    }
+    for (int64_t i = 0; i < iterations; ++i) {
+        state->sink += (uint64_t)RandIndex(&state->rng, _ROOM_TYPE_COUNT, params.roomDistribution, totalWeight);
+    }
+}
+
+static void Bench_RandRangei32(BenchState *const state, const int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+        state->sink += (uint64_t)RandRangei32(&state->rng, -1000, 1000);
+    }
+}
+
+static void Bench_RenderMap(BenchState *const state, const int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+        RenderBuffer_Clear(&state->buffer);
+        Render_Map(&state->buffer, state->dungeon, &state->player, false);
+        state->sink += (uint64_t)state->buffer.length;
+    }
+}
+
+static void Bench_PlayerMove(BenchState *const state, const int64_t iterations) {
+    // Forwards, then turn (which changes orientation), keeping the walk near where it started:
+    const vec2 directions[] = { { 0, 1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+    const Player start = state->player;
+    for (int64_t i = 0; i < iterations; ++i) {
+        if ((i & 15) == 0) {
+            state->player = start;
+        }
+        Player_Move(&state->player, directions[i & 3]);
+        state->sink += (uint64_t)state->player.position.current[0];
+    }
+    state->player = start;
+}
+
+static void Bench_GameStep(BenchState *const state, const int64_t iterations) {
+    GameState *const game = &state->game;
+    for (int64_t i = 0; i < iterations; ++i) {
+        // Start a new game whenever the last one ends, as the batch does:
+        if (game->dungeon == NULL || game->status != GAME_STATUS_PLAYING) {
+            if (game->dungeon != NULL) {
+                Dungeon_Destroy(game->dungeon);
+            }
+            Rng rng;
+            Rng_Seed(&rng, 1, (uint64_t)state->gameIndex);
+            state->gameIndex += 1;
+            Dungeon *const dungeon = Dungeon_Create(state->size, &rng);
+            Game_Init(game, dungeon, &rng);
+            Game_Start(game);
+        }
+        Game_Step(game, Bench_RandomAction(&state->rng));
+    }
+    state->sink += (uint64_t)game->player.position.current[0];
+}
+
+static void Bench_BatchStep(BenchState *const state, const int64_t iterations) {
+    GameBatch *const batch = &state->batch;
+    if (batch->count == 0) {
+        const DungeonParams params = DungeonParams_Default(state->size);
+        GameBatch_Init(batch, BENCH_BATCH_GAMES, &params, 1);
+    }
+
+    // Each iteration is one step of one game, so every call of GameBatch_Step() covers the whole batch:
+    Action actions[BENCH_BATCH_GAMES];
+    for (int64_t i = 0; i < iterations; i += batch->count) {
+        for (int32_t j = 0; j < batch->count; ++j) {
+            actions[j] = Bench_RandomAction(&state->rng);
+        }
+        GameBatch_Step(batch, actions);
+        GameBatch_Reset(batch);
+    }
+    state->sink += (uint64_t)batch->positionX[0];
+}
+
+// Any movement or encounter action, as a policy that is still exploring might choose.
+static Action Bench_RandomAction(Rng *const rng) {
+    return (Action)RandRangei32(rng, ACTION_FORWARD, ACTION_FLEE + 1);
+}
+
+static void Bench_ScriptedGame(BenchState *const state, const int64_t iterations) {
+    for (int64_t i = 0; i < iterations; ++i) {
+        // The same games every run, so results are comparable between builds:
+        Rng rng;
+        Rng_Seed(&rng, 1, (uint64_t)state->gameIndex);
+        state->gameIndex += 1;
+
+        GameState game;
+        Dungeon *const dungeon = Dungeon_Create(state->size, &rng);
+        Game_Init(&game, dungeon, &rng);
+        Game_Start(&game);
+        for (int32_t turn = 0; turn < benchMaxTurns && game.status == GAME_STATUS_PLAYING; ++turn) {
+            Game_Step(&game, Bot_ChooseAction(&game, &rng));
+        }
+        state->sink += (uint64_t)game.status;
+        Dungeon_Destroy(dungeon);
+    }
+}
+
+// Step a whole batch and the same games one at a time with the same actions, checking that every game stays the same.
+static bool Bench_CheckBatchStep(const vec2 size) {
+    const DungeonParams params = DungeonParams_Default(size);
+    GameBatch batch;
+    GameBatch_Init(&batch, BENCH_BATCH_GAMES, &params, 1);
+    GameState games[BENCH_BATCH_GAMES];
+    int64_t episodes[BENCH_BATCH_GAMES];
+    for (int32_t i = 0; i < batch.count; ++i) {
+        episodes[i] = 0;
+        Bench_StartBatchGame(&batch, i, episodes[i], &games[i]);
+    }
+
+    Rng rng;
+    Rng_Seed(&rng, 1, 0);
+    Action actions[BENCH_BATCH_GAMES];
+    bool matched = true;
+    for (int32_t step = 0; step < benchCheckBatchSteps && matched; ++step) {
+        for (int32_t i = 0; i < batch.count; ++i) {
+            // Everything but ACTION_EXIT, so that the common actions (and unrecognised ones) are covered too:
+            actions[i] = (Action)RandRangei32(&rng, ACTION_NONE, _ACTION_COUNT - 1);
+            actions[i] = (actions[i] == ACTION_EXIT) ? ACTION_FLEE : actions[i];
+            if (games[i].status == GAME_STATUS_PLAYING) {
+                Game_Step(&games[i], actions[i]);
+            }
+        }
+        GameBatch_Step(&batch, actions);
+
+        for (int32_t i = 0; i < batch.count && matched; ++i) {
+            GameState batchGame;
+            GameBatch_GetGame(&batch, i, &batchGame);
+            if (Game_Hash(&batchGame) != Game_Hash(&games[i])) {
+                fprintf(
+                    stderr,
+                    "Game %d (episode %lld) differs from Game_Step() after step %d (%s).\n",
+                    i,
+                    (long long)episodes[i],
+                    step,
+                    Action_ToString(actions[i])
+                );
+                matched = false;
+            }
+        }
+
+        // Finished games are replaced by the batch, so start the same ones here:
+        GameBatch_Reset(&batch);
+        for (int32_t i = 0; i < batch.count; ++i) {
+            if (games[i].status != GAME_STATUS_PLAYING) {
+                Dungeon_Destroy(games[i].dungeon);
+                episodes[i] += 1;
+                Bench_StartBatchGame(&batch, i, episodes[i], &games[i]);
+            }
+        }
+    }
+
+    for (int32_t i = 0; i < batch.count; ++i) {
+        Dungeon_Destroy(games[i].dungeon);
+    }
+    GameBatch_Destroy(&batch);
+    return matched;
+}
+
+// Start the game GameBatch_Reset() starts in slot 'index' of 'batch' for its 'episode'th game, in its own dungeon.
+static void Bench_StartBatchGame(
+    const GameBatch *const batch,
+    const int32_t index,
+    const int64_t episode,
+    GameState *const outGame
+) {
+    Rng rng;
+    Rng_Seed(&rng, Rng_HashCombine(batch->seed, (uint64_t)episode), (uint64_t)index);
+    Dungeon *const dungeon = Dungeon_CreateWithParams(&batch->params, &rng);
+    Game_Init(outGame, dungeon, &rng);
+    Game_Start(outGame);
+}
+
+// Change random rooms of a dungeon one at a time, checking that updating distance fields after each change gives the
+// same distances as building them again from scratch.
+static bool Bench_CheckDistanceField(const vec2 size) {
+    Rng rng;
+    Rng_Seed(&rng, 1, 0);
+    Dungeon *const dungeon = Dungeon_Create(size, &rng);
+
+    // The treasure at the default costs (as the bot uses), and items (which come and go) at arbitrary costs:
+    const RoomType targets[2] = { ROOM_TREASURE, ROOM_ITEM };
+    int32_t costs[2][_ROOM_TYPE_COUNT];
+    DistanceField_GetDefaultCosts(costs[0]);
+    for (int32_t i = 0; i < _ROOM_TYPE_COUNT; ++i) {
+        costs[1][i] = RandRangei32(&rng, 1, DISTANCE_FIELD_MAX_COST + 1);
+    }
+    DistanceField fields[2];
+    for (int32_t i = 0; i < 2; ++i) {
+        DistanceField_Init(&fields[i], dungeon, targets[i], costs[i]);
+    }
+
+    bool matched = true;
+    for (int32_t change = 0; change < benchCheckFieldChanges && matched; ++change) {
+        const vec2 position = {
+            (vec2_scalar)RandRangei32(&rng, 0, dungeon->size[0]),
+            (vec2_scalar)RandRangei32(&rng, 0, dungeon->size[1]),
+        };
+        if (Vec2_Equal(position, dungeon->spawnPosition) || Vec2_Equal(position, dungeon->treasurePosition)) {
+            continue;
+        }
+        Room room;
+        Room_Init(&room, (RoomType)RandRangei32(&rng, ROOM_EMPTY, ROOM_ENEMY + 1), &dungeon->items, &rng);
+        Dungeon_SetRoom(dungeon, position, &room);
+
+        for (int32_t i = 0; i < 2 && matched; ++i) {
+            DistanceField_Update(&fields[i], dungeon, position);
+            DistanceField rebuilt;
+            DistanceField_Init(&rebuilt, dungeon, targets[i], costs[i]);
+            const size_t distancesSize = sizeof(rebuilt.distances[0]) * (size_t)Dungeon_RoomCount(dungeon);
+            if (memcmp(fields[i].distances, rebuilt.distances, distancesSize) != 0) {
+                fprintf(
+                    stderr,
+                    "Distances to %s differ from a rebuilt field after change %d ([%d, %d] became %s).\n",
+                    RoomType_ToString(targets[i]),
+                    change,
+                    position[0],
+                    position[1],
+                    RoomType_ToString(room.type)
+                );
+                matched = false;
+            }
+            DistanceField_Destroy(&rebuilt);
+        }
+    }
+
+    for (int32_t i = 0; i < 2; ++i) {
+        DistanceField_Destroy(&fields[i]);
+    }
+    Dungeon_Destroy(dungeon);
+    return matched;
+}
+
+// Change random rooms (and mark them visited) one at a time, checking that rooms counted over random rectangles match
+// counting them one by one - both while changes are pending and once they've been folded into the tables.
+static bool Bench_CheckRegionStats(const vec2 size) {
+    Rng rng;
+    Rng_Seed(&rng, 1, 0);
+    Dungeon *const dungeon = Dungeon_Create(size, &rng);
+    RegionStats regions;
+    RegionStats_Init(&regions, dungeon);
+
+    bool matched = true;
+    int32_t flushes = 0;
+    for (int32_t change = 0; change < benchCheckRegionChanges && matched; ++change) {
+        const vec2 position = {
+            (vec2_scalar)RandRangei32(&rng, 0, dungeon->size[0]),
+            (vec2_scalar)RandRangei32(&rng, 0, dungeon->size[1]),
+        };
+        if (RandRangei32(&rng, 0, 4) == 0) {
+            Dungeon_MarkVisited(dungeon, position);
+        } else if (!Vec2_Equal(position, dungeon->spawnPosition) && !Vec2_Equal(position, dungeon->treasurePosition)) {
+            Room room;
+            Room_Init(&room, (RoomType)RandRangei32(&rng, ROOM_EMPTY, ROOM_ENEMY + 1), &dungeon->items, &rng);
+            Dungeon_SetRoom(dungeon, position, &room);
+        }
+        const int32_t pending = regions.changeCount;
+        RegionStats_Update(&regions, dungeon, position);
+        flushes += regions.changeCount < pending;
+
+        for (int32_t query = 0; query < benchCheckRegionQueries && matched; ++query) {
+            const int32_t layer = RandRangei32(&rng, 0, REGION_LAYER_COUNT);
+            if (!Bench_CheckRegionQuery(&regions, dungeon, layer, &rng)) {
+                fprintf(stderr, "Room counts differ after change %d (%d pending).\n", change, regions.changeCount);
+                matched = false;
+            }
+        }
+    }
+    if (matched && flushes == 0) {
+        fprintf(stderr, "No changes were ever folded into the tables.\n");
+        matched = false;
+    }
+
+    RegionStats_Destroy(&regions);
+    Dungeon_Destroy(dungeon);
+    return matched;
+}
+
+// Count 'layer' over a random rectangle, and around a random room, both with 'regions' and room by room.
+static bool Bench_CheckRegionQuery(
+    const RegionStats *const regions,
+    const Dungeon *const dungeon,
+    const int32_t layer,
+    Rng *const rng
+) {
+    vec2 min, max, center;
+    for (int32_t i = 0; i < 2; ++i) {
+        const vec2_scalar a = (vec2_scalar)RandRangei32(rng, 0, dungeon->size[i]);
+        const vec2_scalar b = (vec2_scalar)RandRangei32(rng, 0, dungeon->size[i]);
+        min[i] = (a < b) ? a : b;
+        max[i] = (a < b) ? b : a;
+        center[i] = (vec2_scalar)RandRangei32(rng, 0, dungeon->size[i]);
+    }
+    const int32_t radius = RandRangei32(rng, 0, 16);
+
+    int32_t expected = 0, expectedNear = 0;
+    for (vec2 position = { 0, 0 }; position[1] < dungeon->size[1]; ++position[1]) {
+        for (position[0] = 0; position[0] < dungeon->size[0]; ++position[0]) {
+            const bool counted = (layer == REGION_LAYER_VISITED)
+                ? Dungeon_IsVisited(dungeon, position)
+                : Dungeon_GetRoomType(dungeon, position) == (RoomType)layer;
+            const bool inside = position[0] >= min[0] && position[0] <= max[0]
+                && position[1] >= min[1] && position[1] <= max[1];
+            const bool near = abs(position[0] - center[0]) <= radius && abs(position[1] - center[1]) <= radius;
+            expected += counted && inside;
+            expectedNear += counted && near;
+        }
+    }
+
+    if (layer == REGION_LAYER_VISITED) {
+        return RegionStats_CountVisited(regions, min, max) == expected
+            && RegionStats_CountVisitedNear(regions, center, radius) == expectedNear;
+    }
+    return RegionStats_CountRooms(regions, (RoomType)layer, min, max) == expected
+        && RegionStats_CountRoomsNear(regions, (RoomType)layer, center, radius) == expectedNear;
+}
+
+// Save games part way through and load them back, checking that they carry on exactly as before, and that
+// snapshots doctored to break what the game relies on are all turned away.
+static bool Bench_CheckSnapshot(const vec2 size) {
+    const bool matched = Bench_CheckSnapshotGeneration(size, DUNGEON_GENERATION_DENSE)
+        && Bench_CheckSnapshotGeneration(size, DUNGEON_GENERATION_HASHED);
+    remove(benchCheckSnapshotPath);
+    return matched;
+}
+
+static bool Bench_CheckSnapshotGeneration(const vec2 size, const DungeonGeneration generation) {
+    DungeonParams params = DungeonParams_Default(size);
+    params.generation = generation;
+    const char *const generationName = (generation == DUNGEON_GENERATION_HASHED) ? "hashed" : "dense";
+
+    // Play games until one is still going having changed some rooms, so there's something to restore:
+    GameState game = { 0 };
+    Rng botRng;
+    Rng_Seed(&botRng, 1, 1);
+    for (uint64_t seed = 1; game.dungeon == NULL; ++seed) {
+        Rng rng;
+        Rng_Seed(&rng, seed, 0);
+        Game_Init(&game, Dungeon_CreateWithParams(&params, &rng), &rng);
+        Game_Start(&game);
+        for (int32_t step = 0; step < benchCheckSnapshotSteps && game.status == GAME_STATUS_PLAYING; ++step) {
+            Game_Step(&game, Bot_ChooseAction(&game, &botRng));
+        }
+        const bool changed = generation != DUNGEON_GENERATION_HASHED || game.dungeon->changedRooms.count > 0;
+        if (game.status != GAME_STATUS_PLAYING || !changed) {
+            Dungeon_Destroy(game.dungeon);
+            game.dungeon = NULL;
+        }
+    }
+    if (!Snapshot_Save(benchCheckSnapshotPath, &game)) {
+        fprintf(stderr, "Couldn't save a snapshot to '%s'.\n", benchCheckSnapshotPath);
+        Dungeon_Destroy(game.dungeon);
+        return false;
+    }
+
+    // The loaded game should be the same, and play on the same given the same actions:
+    GameState loaded;
+    Dungeon *const loadedDungeon = Snapshot_Load(benchCheckSnapshotPath, &loaded);
+    bool matched = loadedDungeon != NULL;
+    for (int32_t step = 0; matched && step < benchCheckSnapshotSteps; ++step) {
+        if (Game_Hash(&loaded) != Game_Hash(&game)) {
+            fprintf(stderr, "%s game differs from the one saved after step %d.\n", generationName, step);
+            matched = false;
+        } else if (game.status == GAME_STATUS_PLAYING) {
+            const Action action = Bot_ChooseAction(&game, &botRng);
+            Game_Step(&game, action);
+            Game_Step(&loaded, action);
+        }
+    }
+    if (loadedDungeon == NULL) {
+        fprintf(stderr, "Couldn't load a %s snapshot back.\n", generationName);
+    } else {
+        Dungeon_Destroy(loadedDungeon);
+    }
+    Dungeon_Destroy(game.dungeon);
+
+    // Then break the saved file in each way the game can't cope with, none of which should load:
+    FILE *const file = fopen(benchCheckSnapshotPath, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    const size_t fileSize = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *const original = malloc(fileSize);
+    uint8_t *const doctored = malloc(fileSize);
+    assert(original != NULL && doctored != NULL);
+    const bool read = fread(original, fileSize, 1, file) == 1;
+    fclose(file);
+
+    const char *const hostileNames[] = { "status", "item sampler", "room" };
+    for (int32_t hostile = 0; read && matched && hostile < 3; ++hostile) {
+        memcpy(doctored, original, fileSize);
+        SnapshotHeader *const header = (SnapshotHeader*)doctored;
+        Dungeon *const image = (Dungeon*)(doctored + header->dungeonOffset);
+        switch (hostile) {
+            case 0: {
+                header->status = GAME_STATUS_WON;
+            } break;
+            case 1: {
+                image->items.alias[0] = _ITEM_TYPE_COUNT;
+            } break;
+            case 2: {
+                if (generation == DUNGEON_GENERATION_HASHED) {
+                    // Every slot taken, so that looking up an unchanged room would never find an empty one:
+                    RoomTableEntry *const entries = (RoomTableEntry*)(doctored + header->changedRoomsOffset);
+                    for (int64_t i = 0; i < image->changedRooms.capacity; ++i) {
+                        if (entries[i].key == UINT64_MAX) {
+                            entries[i].key = (uint64_t)i;
+                            entries[i].room = PackedRoom_Make(ROOM_EMPTY, 0, 0);
+                        }
+                    }
+                } else {
+                    // An item that doesn't exist, so picking it up would write past the inventory:
+                    PackedRoom *const rooms = (PackedRoom*)((uint8_t*)image + header->roomsOffset);
+                    rooms[0] = PackedRoom_Make(ROOM_ITEM, PACKED_ROOM_FIELD_MAX, 0);
+                }
+            } break;
+        }
+
+        GameState rejected;
+        Dungeon* dungeon = NULL;
+        if (Bench_WriteFile(benchCheckSnapshotPath, doctored, fileSize)) {
+            dungeon = Snapshot_Load(benchCheckSnapshotPath, &rejected);
+        }
+        if (dungeon != NULL) {
+            fprintf(stderr, "A %s snapshot with a bad %s loaded.\n", generationName, hostileNames[hostile]);
+            Dungeon_Destroy(dungeon);
+            matched = false;
+        }
+    }
+    free(original);
+    free(doctored);
+    return matched && read;
+}
+
+// Replace the file at 'path' with 'size' bytes of 'data', returning false on failure.
+static bool Bench_WriteFile(const char *const path, const uint8_t *const data, const size_t size) {
+    FILE *const file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    const bool written = fwrite(data, size, 1, file) == 1;
+    return (fclose(file) == 0) && written;
+}
+
+// Run every check that matches the filter, reporting each one, and return whether they all passed.
+static bool Bench_RunChecks(const BenchConfig *const config) {
+    bool passed = true;
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); ++i) {
+        const BenchCheck *const check = &checks[i];
+        if (config->filter != NULL && strstr(check->name, config->filter) == NULL) {
+            continue;
+        }
+        const bool matched = check->run(check->size);
+        printf("%-32s %s\n", check->name, matched ? "ok" : "FAILED");
+        passed = passed && matched;
+    }
+    return passed;
+}
+
+static void Bench_PrintHeader(const BenchConfig *const config) {
+    switch (config->format) {
+        case BENCH_FORMAT_TEXT: {
+            printf(
+                "%-30s %-8s %10s %10s %10s %10s %10s %10s\n",
+                "benchmark (ns per unit)",
+                "unit",
+                "iters",
+                "min",
+                "p50",
+                "p90",
+                "p99",
+                "max"
+            );
+        } break;
+        case BENCH_FORMAT_JSON: {
+            printf("{\"benchmarks\":[");
+        } break;
+        case BENCH_FORMAT_CSV: {
+            printf("name,unit,iterations,samples,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+        } break;
+    }
+}
+
+static void Bench_PrintResult(
+    const BenchConfig *const config,
+    const Bench *const bench,
+    const BenchResult *const result,
+    const bool first
+) {
+    switch (config->format) {
+        case BENCH_FORMAT_TEXT: {
+            printf(
+                "%-30s %-8s %10lld %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                bench->name,
+                bench->unit,
+                (long long)result->iterations,
+                result->min,
+                result->percentiles[0],
+                result->percentiles[1],
+                result->percentiles[2],
+                result->max
+            );
+        } break;
+        case BENCH_FORMAT_JSON: {
+            printf(
+                "%s\n{\"name\":\"%s\",\"unit\":\"%s\",\"iterations\":%lld,\"samples\":%d,"
+                "\"min_ns\":%.3f,\"mean_ns\":%.3f,\"p50_ns\":%.3f,\"p90_ns\":%.3f,\"p99_ns\":%.3f,\"max_ns\":%.3f}",
+                first ? "" : ",",
+                bench->name,
+                bench->unit,
+                (long long)result->iterations,
+                result->samples,
+                result->min,
+                result->mean,
+                result->percentiles[0],
+                result->percentiles[1],
+                result->percentiles[2],
+                result->max
+            );
+        } break;
+        case BENCH_FORMAT_CSV: {
+            printf(
+                "%s,%s,%lld,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                bench->name,
+                bench->unit,
+                (long long)result->iterations,
+                result->samples,
+                result->min,
+                result->mean,
+                result->percentiles[0],
+                result->percentiles[1],
+                result->percentiles[2],
+                result->max
+            );
+        } break;
+    }
+    fflush(stdout);
+}
+
+static void Bench_PrintFooter(const BenchConfig *const config) {
+    if (config->format == BENCH_FORMAT_JSON) {
+        printf("\n]}\n");
+    }
+}
@@ -0,0 +1,169 @@
+// Build-time generator for the command table used by Action_Parse().
+// Collects every command word (each action's name plus the aliases below) and all of their unambiguous prefixes,
+// then searches for a hash seed that gives every word its own slot, so parsing is a single hash and compare.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/game.h"
+
+// Longest command word that can be recognised:
+#define TABLE_MAX_LENGTH 15
+#define TABLE_MAX_WORDS 256
+
+typedef struct Alias {
+    const char* word;
+    Action action;
+} Alias;
+
+// Extra words accepted for each action (must be lowercase):
+const Alias aliases[] = {
+    { "quit", ACTION_EXIT },
+    { "?", ACTION_HELP },
+    { "hp", ACTION_HEALTH },
+    { "inv", ACTION_INVENTORY },
+    { "eat", ACTION_FOOD },
+    { "fwd", ACTION_FORWARD },
+    { "attack", ACTION_FIGHT },
+    { "run", ACTION_FLEE },
+};
+
+typedef struct Word {
+    char text[TABLE_MAX_LENGTH + 1];
+    int32_t length;
+    Action action;
+    // Full names and aliases always win - prefixes are dropped if they could mean more than one action:
+    bool isPrefix;
+    bool ambiguous;
+} Word;
+
+static int32_t totalWords = 0;
+static Word words[TABLE_MAX_WORDS];
+
+static void AddWord(const char* text, int32_t length, Action action, bool isPrefix);
+static bool TryBuildTable(uint32_t seed, int32_t tableSize, int32_t slots[]);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s OUTPUT_HEADER\n", argv[0]);
+        return 1;
+    }
+
+    for (Action action = ACTION_NONE + 1; action < _ACTION_COUNT; ++action) {
+        const char *const name = Action_ToString(action);
+        for (int32_t length = 1; name[length - 1] != '\0'; ++length) {
+            AddWord(name, length, action, name[length] != '\0');
+        }
+    }
+    for (size_t i = 0; i < sizeof(aliases) / sizeof(aliases[0]); ++i) {
+        const char *const word = aliases[i].word;
+        for (int32_t length = 1; word[length - 1] != '\0'; ++length) {
+            AddWord(word, length, aliases[i].action, word[length] != '\0');
+        }
+    }
+
+    // Keep the table at most half full, so a collision-free seed turns up quickly:
+    int32_t wordCount = 0;
+    int32_t maxLength = 0;
+    for (int32_t i = 0; i < totalWords; ++i) {
+        if (!words[i].ambiguous) {
+            wordCount += 1;
+            if (words[i].length > maxLength) {
+                maxLength = words[i].length;
+            }
+        }
+    }
+    int32_t tableSize = 1;
+    while (tableSize < wordCount * 2) {
+        tableSize *= 2;
+    }
+
+    int32_t* slots = malloc(sizeof(slots[0]) * (size_t)tableSize);
+    assert(slots != NULL);
+    uint32_t seed = 0;
+    while (!TryBuildTable(seed, tableSize, slots)) {
+        ++seed;
+        if (seed == 1000000) {
+            // Give the table more room rather than searching forever:
+            seed = 0;
+            tableSize *= 2;
+            slots = realloc(slots, sizeof(slots[0]) * (size_t)tableSize);
+            assert(slots != NULL);
+        }
+    }
+
+    FILE *const file = fopen(argv[1], "w");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(file, "// Generated by tools/gen_action_table.c - do not edit.\n");
+    fprintf(file, "#ifndef __ACTION_TABLE_H__\n#define __ACTION_TABLE_H__\n\n");
+    fprintf(file, "#include <stdint.h>\n\n");
+    fprintf(file, "#define ACTION_TABLE_SEED %uu\n", seed);
+    fprintf(file, "#define ACTION_TABLE_SIZE %d\n", tableSize);
+    fprintf(file, "#define ACTION_TABLE_MAX_LENGTH %d\n\n", maxLength);
+    fprintf(file, "typedef struct ActionTableEntry {\n");
+    fprintf(file, "    char word[ACTION_TABLE_MAX_LENGTH + 1];\n");
+    fprintf(file, "    uint8_t action;\n");
+    fprintf(file, "} ActionTableEntry;\n\n");
+    fprintf(file, "// %d words - empty slots have an empty word, which never matches:\n", wordCount);
+    fprintf(file, "static const ActionTableEntry actionTable[ACTION_TABLE_SIZE] = {\n");
+    for (int32_t slot = 0; slot < tableSize; ++slot) {
+        if (slots[slot] >= 0) {
+            const Word *const word = &words[slots[slot]];
+            fprintf(file, "    [%d] = { \"%s\", %d },\n", slot, word->text, (int32_t)word->action);
+        }
+    }
+    fprintf(file, "};\n\n#endif // __ACTION_TABLE_H__\n");
+    free(slots);
+
+    return (fclose(file) == 0) ? 0 : 1;
+}
+
+static void AddWord(const char *const text, const int32_t length, const Action action, const bool isPrefix) {
+    assert(length <= TABLE_MAX_LENGTH);
+    for (int32_t i = 0; i < totalWords; ++i) {
+        Word *const word = &words[i];
+        if (word->length != length || memcmp(word->text, text, (size_t)length) != 0) {
+            continue;
+        }
+        if (!isPrefix && word->isPrefix) {
+            // A complete word replaces any prefix that happened to match it:
+            *word = (Word) { .length = length, .action = action };
+            memcpy(word->text, text, (size_t)length);
+        } else if (isPrefix && !word->isPrefix) {
+            // Already a complete word, which takes priority.
+        } else if (word->action != action) {
+            assert(isPrefix && "the same word can't be given to two different actions");
+            word->ambiguous = true;
+        }
+        return;
+    }
+
+    assert(totalWords < TABLE_MAX_WORDS);
+    Word *const word = &words[totalWords++];
+    *word = (Word) { .length = length, .action = action, .isPrefix = isPrefix };
+    memcpy(word->text, text, (size_t)length);
+}
+
+static bool TryBuildTable(const uint32_t seed, const int32_t tableSize, int32_t slots[]) {
+    for (int32_t slot = 0; slot < tableSize; ++slot) {
+        slots[slot] = -1;
+    }
+    for (int32_t i = 0; i < totalWords; ++i) {
+        if (words[i].ambiguous) {
+            continue;
+        }
+        const uint32_t slot = Action_HashCommand(words[i].text, words[i].length, seed) & (uint32_t)(tableSize - 1);
+        if (slots[slot] >= 0) {
+            return false;
+        }
+        slots[slot] = i;
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+// Headless replay of action logs recorded with `dungeon --record` - replays every game at full speed
+// (one log per thread), checking that each one still ends in exactly the state it was recorded in.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/parallel.h"
+#include "dungeon/replay.h"
+#include "dungeon/util.h"
+
+typedef struct ReplayJob {
+    const char* path;
+    ReplayStatus status;
+    ReplayStats stats;
+} ReplayJob;
+
+static void ReplayTool_PrintUsage(const char* program);
+static void ReplayTool_RunJob(void* context, int32_t index, int32_t worker);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    int32_t threads = 0;
+    int32_t firstPath = 1;
+    for (; firstPath < argc; ++firstPath) {
+        const char *const arg = argv[firstPath];
+        if (strcmp(arg, "--threads") == 0 && firstPath + 1 < argc) {
+            char* end = NULL;
+            threads = (int32_t)strtol(argv[++firstPath], &end, 10);
+            if (*end != '\0' || threads < 0) {
+                fprintf(stderr, "Invalid thread count '%s'.\n", argv[firstPath]);
+                return 1;
+            }
+        } else if (strcmp(arg, "--") == 0) {
+            ++firstPath;
+            break;
+        } else if (strncmp(arg, "--", 2) == 0) {
+            ReplayTool_PrintUsage(argv[0]);
+            return 1;
+        } else {
+            break;
+        }
+    }
+    const int32_t jobCount = argc - firstPath;
+    if (jobCount <= 0) {
+        ReplayTool_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    ReplayJob* jobs = calloc((size_t)jobCount, sizeof(ReplayJob));
+    assert(jobs != NULL);
+    for (int32_t i = 0; i < jobCount; ++i) {
+        jobs[i].path = argv[firstPath + i];
+        jobs[i].stats.firstMismatch = -1;
+    }
+
+    // Each log is replayed by a single thread, so there's no use for more threads than logs:
+    const int32_t resolvedThreads = Parallel_ResolveThreadCount(threads);
+    const int32_t threadCount = (resolvedThreads < jobCount) ? resolvedThreads : jobCount;
+    const double startTime = Time_GetSeconds();
+    Parallel_For(jobCount, threadCount, ReplayTool_RunJob, jobs);
+    const double elapsedTime = Time_GetSeconds() - startTime;
+
+    ReplayStats total = { .firstMismatch = -1 };
+    bool failed = false;
+    for (int32_t i = 0; i < jobCount; ++i) {
+        const ReplayJob *const job = &jobs[i];
+        total.games += job->stats.games;
+        total.actions += job->stats.actions;
+        total.mismatches += job->stats.mismatches;
+        if (job->status == REPLAY_CORRUPT) {
+            fprintf(
+                stderr,
+                "%s: unreadable or corrupt after %lld game(s).\n",
+                job->path,
+                (long long)job->stats.games
+            );
+            failed = true;
+        }
+        if (job->stats.mismatches > 0) {
+            fprintf(
+                stderr,
+                "%s: %lld game(s) didn't match their recording, starting with game %lld.\n",
+                job->path,
+                (long long)job->stats.mismatches,
+                (long long)job->stats.firstMismatch
+            );
+            failed = true;
+        }
+    }
+
+    printf(
+        "Replayed %lld game(s) (%lld actions) from %d log(s) in %.3fs using %d thread(s) (%.0f actions/s).\n",
+        (long long)total.games,
+        (long long)total.actions,
+        jobCount,
+        elapsedTime,
+        threadCount,
+        (elapsedTime > 0.0) ? (double)total.actions / elapsedTime : 0.0
+    );
+    printf("| matched:    %lld\n", (long long)(total.games - total.mismatches));
+    printf("| mismatched: %lld\n", (long long)total.mismatches);
+
+    free(jobs);
+    return failed ? 1 : 0;
+}
+
+static void ReplayTool_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [--threads N] LOG...\n"
+        "| --threads N        worker threads, 0 for one per processor (default: 0)\n"
+        "| LOG                a log written by `dungeon --record`, or - for stdin\n",
+        program
+    );
+}
+
+static void ReplayTool_RunJob(void *const context, const int32_t index, const int32_t worker) {
+    (void)worker;
+    ReplayJob *const job = &((ReplayJob*)context)[index];
+
+    // Far too big for a worker's stack:
+    ReplayReader* reader = malloc(sizeof(ReplayReader));
+    assert(reader != NULL);
+    if (!ReplayReader_Open(reader, job->path)) {
+        job->status = REPLAY_CORRUPT;
+    } else {
+        job->status = Replay_Run(reader, &job->stats);
+        ReplayReader_Close(reader);
+    }
+    free(reader);
+}
@@ -0,0 +1,410 @@
+// Seed search - scans a range of seeds across all cores for dungeons whose layout meets a set of conditions,
+// and prints every seed that does (in order, as soon as it's found) so it can be played with `dungeon --seed`.
+
+#include <assert.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/parallel.h"
+#include "dungeon/rng.h"
+#include "dungeon/util.h"
+
+#define SEED_MAX_FILTERS 16
+
+// Each parallel task scans this many seeds, to keep scheduling overhead negligible:
+const int64_t seedsPerTask = 4096;
+// Tasks handed out per thread before the matches found so far are printed:
+const int32_t tasksPerRound = 4;
+
+typedef enum SeedCondition {
+    // Shortest path from the spawn to the treasure (every room can be walked through) within [min,max] steps:
+    SEED_CONDITION_DISTANCE,
+    // None of the rooms next to the spawn are of 'type':
+    SEED_CONDITION_NOT_ADJACENT,
+    // At least 'min' rooms of 'type' along one of the shortest paths from the spawn to the treasure:
+    SEED_CONDITION_ON_PATH,
+} SeedCondition;
+
+// A single condition a dungeon has to meet - filters are checked in SeedCondition order (cheapest first),
+// and checking stops at the first that fails.
+typedef struct SeedFilter {
+    SeedCondition condition;
+    RoomType type;
+    int32_t min;
+    int32_t max;
+} SeedFilter;
+
+typedef struct SeedConfig {
+    uint64_t seed;
+    int64_t count;
+    // Stop once this many seeds have matched (0 for no limit):
+    int64_t maxMatches;
+    int32_t threads;
+    DungeonParams params;
+    SeedFilter filters[SEED_MAX_FILTERS];
+    int32_t filterCount;
+} SeedConfig;
+
+typedef struct SeedWorker {
+    // Scratch space for the layout being checked, and the best counts along each column for SEED_CONDITION_ON_PATH:
+    uint8_t* types;
+    int32_t* pathCounts;
+    // Keep each worker's scratch pointers on separate cache lines:
+    uint8_t _padding[64];
+} SeedWorker;
+
+typedef struct SeedJob {
+    const SeedConfig* config;
+    SeedWorker* workers;
+    // Seeds covered by this round of tasks:
+    uint64_t firstSeed;
+    int64_t seedCount;
+    // Matches found by each task of the round (up to seedsPerTask each):
+    uint64_t* matches;
+    int64_t* matchCounts;
+} SeedJob;
+
+static void Seeds_PrintUsage(const char* program);
+static bool Seeds_ParseArgs(int32_t argc, const char *const argv[], SeedConfig* config);
+static bool Seeds_AddFilter(SeedConfig* config, SeedFilter filter);
+static bool Seeds_ParseRoomType(const char* value, RoomType* outType);
+static int32_t Seeds_CompareFilters(const void* a, const void* b);
+static void Seeds_RunTask(void* context, int32_t index, int32_t worker);
+static bool Seeds_Matches(const SeedConfig* config, SeedWorker* worker, uint64_t seed);
+static int32_t Seeds_CountOnPath(
+    const SeedConfig* config,
+    SeedWorker* worker,
+    RoomType type,
+    const vec2 spawnPosition,
+    const vec2 treasurePosition
+);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    SeedConfig config = {
+        .seed = 0,
+        .count = 1000000,
+        .maxMatches = 0,
+        .threads = 0,
+        .params = DungeonParams_Default((vec2) { 10, 10 }),
+        .filterCount = 0,
+    };
+    if (!Seeds_ParseArgs(argc, argv, &config)) {
+        Seeds_PrintUsage(argv[0]);
+        return 1;
+    }
+    // Check the cheapest conditions first, so most seeds are turned down before the expensive ones run:
+    qsort(config.filters, (size_t)config.filterCount, sizeof(config.filters[0]), Seeds_CompareFilters);
+
+    const int32_t threadCount = Parallel_ResolveThreadCount(config.threads);
+    const int64_t totalRooms = (int64_t)config.params.size[0] * config.params.size[1];
+    SeedWorker *const workers = calloc(threadCount, sizeof(workers[0]));
+    assert(workers != NULL);
+    for (int32_t i = 0; i < threadCount; ++i) {
+        workers[i].types = malloc(sizeof(workers[i].types[0]) * (size_t)totalRooms);
+        workers[i].pathCounts = malloc(sizeof(workers[i].pathCounts[0]) * (size_t)config.params.size[0]);
+        assert(workers[i].types != NULL && workers[i].pathCounts != NULL);
+    }
+    const int32_t roundTasks = threadCount * tasksPerRound;
+    SeedJob job = {
+        .config = &config,
+        .workers = workers,
+    };
+    job.matches = malloc(sizeof(job.matches[0]) * (size_t)(roundTasks * seedsPerTask));
+    job.matchCounts = malloc(sizeof(job.matchCounts[0]) * (size_t)roundTasks);
+    assert(job.matches != NULL && job.matchCounts != NULL);
+
+    const double startTime = Time_GetSeconds();
+    const int64_t maxMatches = (config.maxMatches > 0) ? config.maxMatches : INT64_MAX;
+    int64_t scanned = 0, matched = 0;
+    uint64_t lastMatch = 0;
+    while (scanned < config.count && matched < maxMatches) {
+        job.firstSeed = config.seed + (uint64_t)scanned;
+        job.seedCount = Min(config.count - scanned, roundTasks * seedsPerTask);
+        const int32_t taskCount = (int32_t)((job.seedCount + seedsPerTask - 1) / seedsPerTask);
+        Parallel_For(taskCount, threadCount, Seeds_RunTask, &job);
+        scanned += job.seedCount;
+
+        // Print in seed order, no matter which thread found what, so the output only depends on the options:
+        for (int32_t task = 0; task < taskCount; ++task) {
+            for (int64_t i = 0; i < job.matchCounts[task] && matched < maxMatches; ++i) {
+                lastMatch = job.matches[task * seedsPerTask + i];
+                printf("%" PRIu64 "\n", lastMatch);
+                ++matched;
+            }
+        }
+        fflush(stdout);
+        if (matched == maxMatches) {
+            // Only count the seeds up to the last match, as if the scan had stopped right there:
+            scanned = (int64_t)(lastMatch - config.seed) + 1;
+        }
+    }
+    const double elapsedTime = Time_GetSeconds() - startTime;
+
+    for (int32_t i = 0; i < threadCount; ++i) {
+        free(workers[i].types);
+        free(workers[i].pathCounts);
+    }
+    free(workers);
+    free(job.matches);
+    free(job.matchCounts);
+
+    fprintf(
+        stderr,
+        "Scanned %" PRId64 " seeds (from %" PRIu64 ", %dx%d) in %.3fs (%.0f seeds/s) using %d thread(s): "
+        "%" PRId64 " matched\n",
+        scanned,
+        config.seed,
+        config.params.size[0],
+        config.params.size[1],
+        elapsedTime,
+        (double)scanned / Max(elapsedTime, 1e-9),
+        threadCount,
+        matched
+    );
+    return 0;
+}
+
+static void Seeds_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "| --seed N           first seed to check (default: 0)\n"
+        "| --count N          number of seeds to check (default: 1000000)\n"
+        "| --matches N        stop after this many seeds have matched (default: no limit)\n"
+        "| --threads N        worker threads, 0 for one per processor (default: 0)\n"
+        "| --size WxH         dungeon size (default: 10x10)\n"
+        "| --distribution L   comma-separated room weights in RoomType order, e.g. '50,25,10,10,15'\n"
+        "|                    (ROOM_TREASURE and ROOM_SPAWN may be omitted, and must be 0)\n"
+        "Conditions (every one given must hold, and each may be given more than once):\n"
+        "| --distance MIN,MAX the treasure is from MIN to MAX steps away from the spawn\n"
+        "| --not-adjacent T   no room of type T (e.g. 'enemy') is next to the spawn\n"
+        "| --on-path T,MIN    at least MIN rooms of type T lie along one of the shortest paths to the treasure\n"
+        "Matching seeds are printed one per line, and start the same dungeon as `dungeon --seed N` given the same\n"
+        "--size and --distribution.\n",
+        program
+    );
+}
+
+static bool Seeds_ParseArgs(const int32_t argc, const char *const argv[], SeedConfig *const config) {
+    for (int32_t i = 1; i < argc; ++i) {
+        const char *const arg = argv[i];
+        const char *const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for '%s'.\n", arg);
+            return false;
+        }
+        ++i;
+
+        char* end = NULL;
+        if (strcmp(arg, "--seed") == 0) {
+            if (!String_ParseUint64(value, &config->seed)) {
+                fprintf(stderr, "Invalid seed '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--count") == 0) {
+            config->count = strtoll(value, &end, 10);
+            if (*end != '\0' || config->count <= 0) {
+                fprintf(stderr, "Invalid seed count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--matches") == 0) {
+            config->maxMatches = strtoll(value, &end, 10);
+            if (*end != '\0' || config->maxMatches <= 0) {
+                fprintf(stderr, "Invalid match count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--threads") == 0) {
+            config->threads = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->threads < 0) {
+                fprintf(stderr, "Invalid thread count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--size") == 0) {
+            if (!String_ParseSize(value, config->params.size)) {
+                fprintf(stderr, "Invalid dungeon size '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--distribution") == 0) {
+            int32_t distribution[_ROOM_TYPE_COUNT] = { 0 };
+            const int32_t count = String_ParseWeights(value, _ROOM_TYPE_COUNT, distribution);
+            if (count < ROOM_TREASURE || distribution[ROOM_TREASURE] != 0 || distribution[ROOM_SPAWN] != 0) {
+                fprintf(stderr, "Invalid room distribution '%s'.\n", value);
+                return false;
+            }
+            memcpy(config->params.roomDistribution, distribution, sizeof(distribution));
+        } else if (strcmp(arg, "--distance") == 0) {
+            const long min = strtol(value, &end, 10);
+            const long max = (*end == ',') ? strtol(end + 1, &end, 10) : -1;
+            if (*end != '\0' || min < 0 || max < min || max > INT32_MAX) {
+                fprintf(stderr, "Invalid distance range '%s'.\n", value);
+                return false;
+            }
+            const SeedFilter filter = {
+                .condition = SEED_CONDITION_DISTANCE,
+                .min = (int32_t)min,
+                .max = (int32_t)max,
+            };
+            if (!Seeds_AddFilter(config, filter)) {
+                return false;
+            }
+        } else if (strcmp(arg, "--not-adjacent") == 0) {
+            SeedFilter filter = { .condition = SEED_CONDITION_NOT_ADJACENT };
+            if (!Seeds_ParseRoomType(value, &filter.type)) {
+                fprintf(stderr, "Invalid room type '%s'.\n", value);
+                return false;
+            }
+            if (!Seeds_AddFilter(config, filter)) {
+                return false;
+            }
+        } else if (strcmp(arg, "--on-path") == 0) {
+            SeedFilter filter = { .condition = SEED_CONDITION_ON_PATH };
+            const char *const comma = strchr(value, ',');
+            char typeName[16] = { 0 };
+            if (comma != NULL && (size_t)(comma - value) < sizeof(typeName)) {
+                memcpy(typeName, value, (size_t)(comma - value));
+            }
+            const long min = (comma != NULL) ? strtol(comma + 1, &end, 10) : -1;
+            if (comma == NULL || *end != '\0' || min < 0 || min > INT32_MAX
+                || !Seeds_ParseRoomType(typeName, &filter.type)) {
+                fprintf(stderr, "Invalid path condition '%s'.\n", value);
+                return false;
+            }
+            filter.min = (int32_t)min;
+            if (!Seeds_AddFilter(config, filter)) {
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", arg);
+            return false;
+        }
+    }
+
+    const int64_t totalRooms = (int64_t)config->params.size[0] * config->params.size[1];
+    if (totalRooms < _ROOM_TYPE_COUNT) {
+        fprintf(stderr, "Dungeon must have at least %d rooms.\n", _ROOM_TYPE_COUNT);
+        return false;
+    }
+    return true;
+}
+
+static bool Seeds_AddFilter(SeedConfig *const config, const SeedFilter filter) {
+    if (config->filterCount == SEED_MAX_FILTERS) {
+        fprintf(stderr, "Too many conditions (at most %d).\n", SEED_MAX_FILTERS);
+        return false;
+    }
+    config->filters[config->filterCount++] = filter;
+    return true;
+}
+
+// Parse a RoomType by name, ignoring case (e.g. 'enemy' or 'ENEMY').
+static bool Seeds_ParseRoomType(const char *const value, RoomType *const outType) {
+    for (RoomType type = 0; type < _ROOM_TYPE_COUNT; ++type) {
+        const char *const name = RoomType_ToString(type);
+        size_t i = 0;
+        while (name[i] != '\0' && toupper((unsigned char)value[i]) == name[i]) {
+            ++i;
+        }
+        if (name[i] == '\0' && value[i] == '\0') {
+            *outType = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t Seeds_CompareFilters(const void *const a, const void *const b) {
+    const SeedFilter *const filterA = a;
+    const SeedFilter *const filterB = b;
+    return (int32_t)filterA->condition - (int32_t)filterB->condition;
+}
+
+static void Seeds_RunTask(void *const context, const int32_t index, const int32_t worker) {
+    const SeedJob *const job = context;
+    const int64_t first = (int64_t)index * seedsPerTask;
+    const int64_t last = Min(first + seedsPerTask, job->seedCount);
+    uint64_t *const matches = &job->matches[index * seedsPerTask];
+    int64_t matchCount = 0;
+    for (int64_t i = first; i < last; ++i) {
+        const uint64_t seed = job->firstSeed + (uint64_t)i;
+        if (Seeds_Matches(job->config, &job->workers[worker], seed)) {
+            matches[matchCount++] = seed;
+        }
+    }
+    job->matchCounts[index] = matchCount;
+}
+
+static bool Seeds_Matches(const SeedConfig *const config, SeedWorker *const worker, const uint64_t seed) {
+    // Seeded exactly as a new game of `dungeon --seed` is (see ReplaySetup_CreateGame()):
+    Rng rng;
+    Rng_Seed(&rng, seed, 0);
+    vec2 spawnPosition, treasurePosition;
+    Dungeon_GenerateLayout(&config->params, &rng, worker->types, spawnPosition, treasurePosition);
+
+    const vec2_scalar *const size = config->params.size;
+    for (int32_t i = 0; i < config->filterCount; ++i) {
+        const SeedFilter *const filter = &config->filters[i];
+        switch (filter->condition) {
+            case SEED_CONDITION_DISTANCE: {
+                const int64_t distance = (int64_t)abs(treasurePosition[0] - spawnPosition[0])
+                    + abs(treasurePosition[1] - spawnPosition[1]);
+                if (distance < filter->min || distance > filter->max) {
+                    return false;
+                }
+            } break;
+            case SEED_CONDITION_NOT_ADJACENT: {
+                const vec2 offsets[4] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+                for (int32_t j = 0; j < 4; ++j) {
+                    const int64_t x = (int64_t)spawnPosition[0] + offsets[j][0];
+                    const int64_t y = (int64_t)spawnPosition[1] + offsets[j][1];
+                    const bool inside = x >= 0 && x < size[0] && y >= 0 && y < size[1];
+                    if (inside && worker->types[y * size[0] + x] == filter->type) {
+                        return false;
+                    }
+                }
+            } break;
+            case SEED_CONDITION_ON_PATH: {
+                const int32_t count = Seeds_CountOnPath(config, worker, filter->type, spawnPosition, treasurePosition);
+                if (count < filter->min) {
+                    return false;
+                }
+            } break;
+        }
+    }
+    return true;
+}
+
+// Find the most rooms of 'type' along any shortest path from the spawn to the treasure. Every room can be walked
+// through, so those are exactly the paths that only ever step towards the treasure, and the best count into each
+// room of the rectangle between the two is its own plus the better of the rooms it can be entered from.
+static int32_t Seeds_CountOnPath(
+    const SeedConfig *const config,
+    SeedWorker *const worker,
+    const RoomType type,
+    const vec2 spawnPosition,
+    const vec2 treasurePosition
+) {
+    const int64_t width = config->params.size[0];
+    const int32_t stepX = (treasurePosition[0] >= spawnPosition[0]) ? 1 : -1;
+    const int32_t stepY = (treasurePosition[1] >= spawnPosition[1]) ? 1 : -1;
+    const int32_t columns = abs(treasurePosition[0] - spawnPosition[0]) + 1;
+    const int32_t rows = abs(treasurePosition[1] - spawnPosition[1]) + 1;
+    int32_t *const counts = worker->pathCounts;
+    for (int32_t row = 0; row < rows; ++row) {
+        const uint8_t *const types = &worker->types[(spawnPosition[1] + (int64_t)row * stepY) * width];
+        int32_t x = spawnPosition[0];
+        for (int32_t column = 0; column < columns; ++column, x += stepX) {
+            const int32_t above = (row > 0) ? counts[column] : 0;
+            const int32_t before = (column > 0) ? counts[column - 1] : 0;
+            counts[column] = (types[x] == type) + Max(above, before);
+        }
+    }
+    return counts[columns - 1];
+}
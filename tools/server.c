@@ -0,0 +1,521 @@
+// Event-driven game server - hosts thousands of concurrent games in one process on a single epoll loop.
+// Every connection gets its own dungeon and plays just like the terminal game, one command per word.
+// Linux only.
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/profile.h"
+#include "dungeon/render.h"
+#include "dungeon/rng.h"
+#include "dungeon/text.h"
+#include "dungeon/util.h"
+
+// How many readiness events to handle per epoll_wait():
+#define SERVER_MAX_EVENTS 256
+// Commands are single words (as with the terminal game), so this is plenty:
+#define SERVER_MAX_INPUT 32
+
+typedef struct ServerConfig {
+    // Listen on a UNIX socket at this path if set, otherwise on 127.0.0.1:port:
+    const char* unixPath;
+    int32_t port;
+    uint64_t seed;
+    int32_t maxSessions;
+    DungeonParams params;
+    // Where to write a Chrome trace when the server is stopped (or NULL) - only in DUNGEON_PROFILE builds:
+    const char* profilePath;
+} ServerConfig;
+
+// Everything a single connection needs beyond its Dungeon - this is kept small, as there can be thousands.
+typedef struct Session {
+    int32_t fd;
+    GameState game;
+    // The command currently being received:
+    char input[SERVER_MAX_INPUT];
+    uint8_t inputLength;
+    // Set while skipping the rest of a word that was too long to fit in 'input':
+    bool inputOverflowed;
+    // Close the connection once all pending output has been sent:
+    bool closing;
+    // Output the socket wasn't ready for yet - only allocated while the client is slow to read:
+    uint32_t pendingOffset;
+    uint32_t pendingLength;
+    char* pending;
+} Session;
+
+typedef struct Server {
+    const ServerConfig* config;
+    int32_t epollFd;
+    int32_t listenFd;
+    // Held open to be given up for a moment when out of descriptors, so that the connection waiting can be accepted
+    // and turned away rather than left queued (as the listening socket would then be reported ready forever):
+    int32_t spareFd;
+    // Set while the listening socket isn't being watched, as there were no descriptors left even to turn anyone away:
+    bool acceptPaused;
+    int32_t sessionCount;
+    uint64_t sessionsStarted;
+    // Shared by every session, as each response is sent (or moved into Session::pending) as soon as it's built:
+    RenderBuffer output;
+} Server;
+
+// Set by SIGINT/SIGTERM, so the server can shut down cleanly (e.g. to write out its profile):
+static volatile sig_atomic_t serverStopping = 0;
+
+static void Server_PrintUsage(const char* program);
+static void Server_Stop(int32_t signal);
+static bool Server_ParseArgs(int32_t argc, const char *const argv[], ServerConfig* config);
+static int32_t Server_Listen(const ServerConfig* config);
+static bool Server_WatchListener(Server* self, int32_t operation);
+static void Server_Accept(Server* self);
+static bool Server_TurnAway(Server* self);
+static void Server_Refuse(int32_t fd);
+static void Server_Read(Server* self, Session* session);
+static void Server_HandleCommand(Server* self, Session* session);
+static void Server_Send(Server* self, Session* session);
+static void Server_Flush(Server* self, Session* session);
+static void Server_WatchSession(Server* self, Session* session, int32_t operation);
+static void Server_CloseSession(Server* self, Session* session);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    ServerConfig config = {
+        .unixPath = NULL,
+        .port = 7777,
+        .seed = (uint64_t)time(NULL),
+        .maxSessions = 10000,
+        .params = DungeonParams_Default((vec2) { 10, 10 }),
+        .profilePath = NULL,
+    };
+    if (!Server_ParseArgs(argc, argv, &config)) {
+        Server_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Server server = {
+        .config = &config,
+        .epollFd = epoll_create1(EPOLL_CLOEXEC),
+        .listenFd = Server_Listen(&config),
+        .spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC),
+        .acceptPaused = false,
+    };
+    if (server.epollFd < 0 || server.listenFd < 0 || server.spareFd < 0) {
+        perror("Failed to start server");
+        return 1;
+    }
+    RenderBuffer_Init(&server.output);
+
+    if (!Server_WatchListener(&server, EPOLL_CTL_ADD)) {
+        perror("Failed to start server");
+        return 1;
+    }
+
+    if (config.unixPath != NULL) {
+        printf("Listening on %s (seed %" PRIu64 ")\n", config.unixPath, config.seed);
+    } else {
+        printf("Listening on 127.0.0.1:%d (seed %" PRIu64 ")\n", config.port, config.seed);
+    }
+    fflush(stdout);
+
+    // Without SA_RESTART, so that epoll_wait() returns as soon as a signal arrives:
+    struct sigaction stopAction = { .sa_handler = Server_Stop };
+    sigemptyset(&stopAction.sa_mask);
+    sigaction(SIGINT, &stopAction, NULL);
+    sigaction(SIGTERM, &stopAction, NULL);
+
+    int32_t exitCode = 0;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!serverStopping) {
+        const int32_t eventCount = epoll_wait(server.epollFd, events, SERVER_MAX_EVENTS, -1);
+        if (eventCount < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            exitCode = 1;
+            break;
+        }
+
+        for (int32_t i = 0; i < eventCount; ++i) {
+            Session *const session = events[i].data.ptr;
+            if (session == NULL) {
+                Server_Accept(&server);
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                Server_CloseSession(&server, session);
+            } else if (events[i].events & EPOLLOUT) {
+                Server_Flush(&server, session);
+            } else if (events[i].events & EPOLLIN) {
+                Server_Read(&server, session);
+            }
+        }
+    }
+
+    if (config.profilePath != NULL) {
+        Profile_WriteSummary(stdout);
+        if (!Profile_WriteTrace(config.profilePath)) {
+            fprintf(stderr, "Failed to write profile to '%s'.\n", config.profilePath);
+            exitCode = 1;
+        }
+    }
+    RenderBuffer_Destroy(&server.output);
+    close(server.listenFd);
+    if (server.spareFd >= 0) {
+        close(server.spareFd);
+    }
+    close(server.epollFd);
+    if (config.unixPath != NULL) {
+        unlink(config.unixPath);
+    }
+    return exitCode;
+}
+
+static void Server_Stop(const int32_t signal) {
+    (void)signal;
+    serverStopping = 1;
+}
+
+static void Server_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "| --port N           TCP port to listen on at 127.0.0.1 (default: 7777)\n"
+        "| --unix PATH        listen on a UNIX socket at PATH instead\n"
+        "| --seed N           base seed - session i always uses stream i of this seed (default: time)\n"
+        "| --size WxH         dungeon size (default: 10x10)\n"
+        "| --generation M     'dense' generates every room up-front, 'hashed' generates rooms on demand\n"
+        "|                    and 'tiled' generates every room up-front across all cores (default: dense)\n"
+        "| --max-sessions N   turn away connections beyond this many concurrent games (default: 10000)\n"
+        "| --profile PATH     on SIGINT/SIGTERM, write a Chrome trace to PATH and print a summary\n"
+        "|                    (DUNGEON_PROFILE builds only)\n",
+        program
+    );
+}
+
+static bool Server_ParseArgs(const int32_t argc, const char *const argv[], ServerConfig *const config) {
+    for (int32_t i = 1; i < argc; ++i) {
+        const char *const arg = argv[i];
+        const char *const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for '%s'.\n", arg);
+            return false;
+        }
+        ++i;
+
+        char* end = NULL;
+        if (strcmp(arg, "--port") == 0) {
+            config->port = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->port <= 0 || config->port > UINT16_MAX) {
+                fprintf(stderr, "Invalid port '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--unix") == 0) {
+            if (strlen(value) >= sizeof(((struct sockaddr_un*)NULL)->sun_path)) {
+                fprintf(stderr, "Socket path '%s' is too long.\n", value);
+                return false;
+            }
+            config->unixPath = value;
+        } else if (strcmp(arg, "--seed") == 0) {
+            if (!String_ParseUint64(value, &config->seed)) {
+                fprintf(stderr, "Invalid seed '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--size") == 0) {
+            if (!String_ParseSize(value, config->params.size)) {
+                fprintf(stderr, "Invalid dungeon size '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--generation") == 0) {
+            if (strcmp(value, "dense") == 0) {
+                config->params.generation = DUNGEON_GENERATION_DENSE;
+            } else if (strcmp(value, "hashed") == 0) {
+                config->params.generation = DUNGEON_GENERATION_HASHED;
+            } else if (strcmp(value, "tiled") == 0) {
+                config->params.generation = DUNGEON_GENERATION_TILED;
+            } else {
+                fprintf(stderr, "Invalid generation mode '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--max-sessions") == 0) {
+            config->maxSessions = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->maxSessions <= 0) {
+                fprintf(stderr, "Invalid session limit '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--profile") == 0) {
+            if (!Profile_IsEnabled()) {
+                fprintf(stderr, "This build has no profiling - configure with -DDUNGEON_PROFILE=ON.\n");
+                return false;
+            }
+            config->profilePath = value;
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", arg);
+            return false;
+        }
+    }
+
+    const int64_t totalRooms = (int64_t)config->params.size[0] * config->params.size[1];
+    if (config->params.generation != DUNGEON_GENERATION_HASHED && totalRooms < _ROOM_TYPE_COUNT) {
+        fprintf(stderr, "Dungeon must have at least %d rooms.\n", _ROOM_TYPE_COUNT);
+        return false;
+    }
+    return true;
+}
+
+static int32_t Server_Listen(const ServerConfig *const config) {
+    int32_t fd = -1;
+    if (config->unixPath != NULL) {
+        struct sockaddr_un address = { .sun_family = AF_UNIX };
+        strncpy(address.sun_path, config->unixPath, sizeof(address.sun_path) - 1);
+        // Clear out any socket left behind by a previous run:
+        unlink(config->unixPath);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (const struct sockaddr*)&address, sizeof(address)) != 0) {
+            return -1;
+        }
+    } else {
+        struct sockaddr_in address = {
+            .sin_family = AF_INET,
+            .sin_port = htons((uint16_t)config->port),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        const int32_t reuse = 1;
+        if (fd < 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+            || bind(fd, (const struct sockaddr*)&address, sizeof(address)) != 0) {
+            return -1;
+        }
+    }
+    return (listen(fd, SOMAXCONN) == 0) ? fd : -1;
+}
+
+static bool Server_WatchListener(Server *const self, const int32_t operation) {
+    // The listening socket is the only one registered without a session:
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data.ptr = NULL,
+    };
+    return epoll_ctl(self->epollFd, operation, self->listenFd, &event) == 0;
+}
+
+static void Server_Accept(Server *const self) {
+    // Accept everything that's waiting, as the listening socket is level-triggered:
+    for (;;) {
+        const int32_t fd = accept4(self->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if ((errno == EMFILE || errno == ENFILE) && Server_TurnAway(self)) {
+                continue;
+            }
+            return;
+        }
+        if (self->sessionCount >= self->config->maxSessions) {
+            Server_Refuse(fd);
+            continue;
+        }
+
+        Session *const session = calloc(1, sizeof(*session));
+        assert(session != NULL);
+        session->fd = fd;
+
+        // Every session gets its own stream, so a given seed always produces the same sequence of games:
+        Rng rng;
+        Rng_Seed(&rng, self->config->seed, self->sessionsStarted++);
+        Dungeon *const dungeon = Dungeon_CreateWithParams(&self->config->params, &rng);
+        Game_Init(&session->game, dungeon, &rng);
+
+        Server_WatchSession(self, session, EPOLL_CTL_ADD);
+        self->sessionCount += 1;
+
+        const StepResult result = Game_Start(&session->game);
+        RenderBuffer_Clear(&self->output);
+        Text_AppendWelcome(&self->output);
+        Text_AppendStepResult(&self->output, &session->game, &result, "", NULL, NULL);
+        Text_AppendPrompt(&self->output, &session->game);
+        Server_Send(self, session);
+    }
+}
+
+// Out of descriptors, so accept the next connection with the spare one just to turn it away, returning whether it
+// was. Failing that, stop watching the listening socket until a session closes and frees a descriptor up.
+static bool Server_TurnAway(Server *const self) {
+    int32_t fd = -1;
+    if (self->spareFd >= 0) {
+        close(self->spareFd);
+        fd = accept4(self->listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            Server_Refuse(fd);
+        }
+        self->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    if (fd >= 0) {
+        return true;
+    }
+    if (!self->acceptPaused && Server_WatchListener(self, EPOLL_CTL_DEL)) {
+        self->acceptPaused = true;
+    }
+    return false;
+}
+
+static void Server_Refuse(const int32_t fd) {
+    const char message[] = "The dungeon is full - please try again later.\n";
+    const ssize_t _result = send(fd, message, sizeof(message) - 1, MSG_NOSIGNAL);
+    (void)_result;
+    close(fd);
+}
+
+static void Server_Read(Server *const self, Session *const session) {
+    char chunk[4096];
+    for (;;) {
+        const ssize_t length = recv(session->fd, chunk, sizeof(chunk), 0);
+        if (length == 0 || (length < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            // Disconnected:
+            Server_CloseSession(self, session);
+            return;
+        } else if (length < 0) {
+            return;
+        }
+
+        for (ssize_t i = 0; i < length && !session->closing; ++i) {
+            const char c = chunk[i];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                if (session->inputLength > 0) {
+                    Server_HandleCommand(self, session);
+                }
+            } else if (session->inputLength < SERVER_MAX_INPUT - 1) {
+                session->input[session->inputLength++] = c;
+            } else {
+                session->inputOverflowed = true;
+            }
+        }
+
+        if (session->closing || session->pending != NULL) {
+            // Stop reading until the client has caught up (Server_Flush() picks things back up):
+            if (session->closing && session->pending == NULL) {
+                Server_CloseSession(self, session);
+            }
+            return;
+        }
+    }
+}
+
+static void Server_HandleCommand(Server *const self, Session *const session) {
+    session->input[session->inputLength] = '\0';
+    // A word that didn't fit can't be a valid command, but still gets a response:
+    const Action action = session->inputOverflowed ? ACTION_NONE : Action_Parse(session->input);
+    session->inputLength = 0;
+    session->inputOverflowed = false;
+
+    const StepResult result = Game_Step(&session->game, action);
+    RenderBuffer_Clear(&self->output);
+    Text_AppendStepResult(&self->output, &session->game, &result, session->input, NULL, NULL);
+    if (session->game.status == GAME_STATUS_PLAYING) {
+        Text_AppendPrompt(&self->output, &session->game);
+    } else {
+        session->closing = true;
+    }
+    Server_Send(self, session);
+}
+
+static void Server_Send(Server *const self, Session *const session) {
+    const char* data = self->output.data;
+    size_t length = self->output.length;
+
+    // Keep everything in order behind anything that's still waiting to go out:
+    if (session->pending == NULL) {
+        const ssize_t sent = send(session->fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            data += sent;
+            length -= (size_t)sent;
+        }
+        if (length == 0) {
+            return;
+        }
+    }
+
+    assert(length <= UINT32_MAX - session->pendingLength);
+    char *const pending = realloc(session->pending, session->pendingLength + length);
+    assert(pending != NULL);
+    memcpy(pending + session->pendingLength, data, length);
+    session->pending = pending;
+    session->pendingLength += (uint32_t)length;
+    Server_WatchSession(self, session, EPOLL_CTL_MOD);
+}
+
+static void Server_Flush(Server *const self, Session *const session) {
+    while (session->pendingOffset < session->pendingLength) {
+        const ssize_t sent = send(
+            session->fd,
+            session->pending + session->pendingOffset,
+            session->pendingLength - session->pendingOffset,
+            MSG_NOSIGNAL | MSG_DONTWAIT
+        );
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Server_CloseSession(self, session);
+            }
+            return;
+        }
+        session->pendingOffset += (uint32_t)sent;
+    }
+
+    free(session->pending);
+    session->pending = NULL;
+    session->pendingOffset = 0;
+    session->pendingLength = 0;
+    if (session->closing) {
+        Server_CloseSession(self, session);
+    } else {
+        // Back to waiting for commands:
+        Server_WatchSession(self, session, EPOLL_CTL_MOD);
+    }
+}
+
+static void Server_WatchSession(Server *const self, Session *const session, const int32_t operation) {
+    // Only wait for the socket to drain while there's pending output, otherwise wait for the next command:
+    struct epoll_event event = {
+        .events = (session->pending != NULL) ? EPOLLOUT : EPOLLIN,
+        .data.ptr = session,
+    };
+    const int32_t _result = epoll_ctl(self->epollFd, operation, session->fd, &event);
+    (void)_result;
+}
+
+static void Server_CloseSession(Server *const self, Session *const session) {
+    // Closing the socket also removes it from the epoll set:
+    close(session->fd);
+    Dungeon_Destroy(session->game.dungeon);
+    free(session->pending);
+    free(session);
+    self->sessionCount -= 1;
+
+    // That freed a descriptor up, so take back the spare (or start accepting again) if it was needed:
+    if (self->spareFd < 0) {
+        self->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    if (self->acceptPaused && Server_WatchListener(self, EPOLL_CTL_ADD)) {
+        self->acceptPaused = false;
+    }
+}
@@ -0,0 +1,448 @@
+// Monte Carlo balancing runner - plays many games with the scripted Bot policy across all cores
+// and reports how they turned out.
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dungeon/bot.h"
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/item.h"
+#include "dungeon/parallel.h"
+#include "dungeon/profile.h"
+#include "dungeon/render.h"
+#include "dungeon/rng.h"
+#include "dungeon/snapshot.h"
+#include "dungeon/solver.h"
+#include "dungeon/util.h"
+
+// Each parallel task plays this many games, to keep scheduling overhead negligible:
+const int64_t gamesPerTask = 1024;
+
+typedef struct SimConfig {
+    int64_t games;
+    int32_t threads;
+    uint64_t seed;
+    int32_t maxTurns;
+    DungeonParams params;
+    // Where to write the fully revealed map of the first game's dungeon (or NULL):
+    const char* dumpMapPath;
+    // Where to load a snapshot that every game starts from instead of generating a dungeon (or NULL):
+    const char* snapshotPath;
+    // Play encounters with the solver's optimal policy (see solver.h) instead of the bot's rules of thumb,
+    // valuing a retreat at this fraction of a win (negative to use the bot):
+    float solverRetreatValue;
+    // Where to write a Chrome trace of the run (or NULL) - only in DUNGEON_PROFILE builds:
+    const char* profilePath;
+} SimConfig;
+
+typedef struct SimStats {
+    int64_t games;
+    int64_t won;
+    int64_t died;
+    int64_t timedOut;
+    int64_t deathsBy[_ROOM_TYPE_COUNT];
+    int64_t turns;
+    int64_t wonTurns;
+    int64_t diedTurns;
+    // Keep each worker's stats on separate cache lines:
+    uint8_t _padding[64];
+} SimStats;
+
+typedef struct SimJob {
+    const SimConfig* config;
+    SimStats* workerStats;
+    // Only set when SimConfig::solverRetreatValue is in use:
+    const Solver* solver;
+} SimJob;
+
+static void Sim_PrintUsage(const char* program);
+static bool Sim_ParseArgs(int32_t argc, const char *const argv[], SimConfig* config);
+static void Sim_RunTask(void* context, int32_t index, int32_t worker);
+static void Sim_PlayGame(const SimConfig* config, const Solver* solver, int64_t gameIndex, SimStats* stats);
+static Dungeon* Sim_InitGame(const SimConfig* config, Rng* rng, GameState* game);
+static bool Sim_DumpMap(const SimConfig* config);
+static RoomType Sim_GetDeathCause(const StepResult* result);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    SimConfig config = {
+        .games = 100000,
+        .threads = 0,
+        .seed = (uint64_t)time(NULL),
+        .maxTurns = 10000,
+        .params = DungeonParams_Default((vec2) { 10, 10 }),
+        .dumpMapPath = NULL,
+        .snapshotPath = NULL,
+        .solverRetreatValue = -1.0f,
+        .profilePath = NULL,
+    };
+    if (!Sim_ParseArgs(argc, argv, &config)) {
+        Sim_PrintUsage(argv[0]);
+        return 1;
+    }
+    // Games are already spread across every thread, so each one generates its own dungeon on a single thread:
+    config.params.threadCount = 1;
+    if (config.snapshotPath != NULL) {
+        // Check the snapshot up-front, and report the dungeon it actually contains:
+        GameState game;
+        Dungeon *const dungeon = Snapshot_Load(config.snapshotPath, &game);
+        if (dungeon == NULL) {
+            fprintf(stderr, "Failed to load snapshot '%s'.\n", config.snapshotPath);
+            return 1;
+        }
+        Vec2_Set(config.params.size, dungeon->size);
+        config.params.generation = dungeon->generation;
+        Dungeon_Destroy(dungeon);
+    }
+    if (config.dumpMapPath != NULL && !Sim_DumpMap(&config)) {
+        fprintf(stderr, "Failed to write map to '%s'.\n", config.dumpMapPath);
+        return 1;
+    }
+
+    const int32_t threadCount = Parallel_ResolveThreadCount(config.threads);
+    SimStats *const workerStats = calloc(threadCount, sizeof(workerStats[0]));
+    assert(workerStats != NULL);
+
+    Solver solver;
+    SimJob job = {
+        .config = &config,
+        .workerStats = workerStats,
+        .solver = NULL,
+    };
+    if (config.solverRetreatValue >= 0.0f) {
+        Solver_Init(&solver, GAME_PLAYER_MAX_HEALTH, config.solverRetreatValue, threadCount);
+        job.solver = &solver;
+    }
+    const int32_t taskCount = (int32_t)((config.games + gamesPerTask - 1) / gamesPerTask);
+
+    const double startTime = Time_GetSeconds();
+    Parallel_For(taskCount, threadCount, Sim_RunTask, &job);
+    const double elapsedTime = Time_GetSeconds() - startTime;
+
+    SimStats total = { 0 };
+    for (int32_t i = 0; i < threadCount; ++i) {
+        const SimStats *const stats = &workerStats[i];
+        total.games += stats->games;
+        total.won += stats->won;
+        total.died += stats->died;
+        total.timedOut += stats->timedOut;
+        for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+            total.deathsBy[roomType] += stats->deathsBy[roomType];
+        }
+        total.turns += stats->turns;
+        total.wonTurns += stats->wonTurns;
+        total.diedTurns += stats->diedTurns;
+    }
+    free(workerStats);
+    if (job.solver != NULL) {
+        Solver_Destroy(&solver);
+    }
+
+    const double games = (double)Max(total.games, 1);
+    printf(
+        "Simulated %" PRId64 " games (seed %" PRIu64 ", %dx%d) in %.3fs (%.0f games/s) using %d thread(s):\n",
+        total.games,
+        config.seed,
+        config.params.size[0],
+        config.params.size[1],
+        elapsedTime,
+        (double)total.games / Max(elapsedTime, 1e-9),
+        threadCount
+    );
+    printf("| room distribution:");
+    for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+        printf(" %s=%d", RoomType_ToString(roomType), config.params.roomDistribution[roomType]);
+    }
+    printf("\n");
+    printf("| item distribution:");
+    for (ItemType item = 0; item < _ITEM_TYPE_COUNT; ++item) {
+        printf(" %s=%d", ItemType_ToString(item), config.params.itemDistribution[item]);
+    }
+    printf("\n");
+    printf("| won:       %12" PRId64 " (%6.2f%%)\n", total.won, 100.0 * (double)total.won / games);
+    printf("| died:      %12" PRId64 " (%6.2f%%)\n", total.died, 100.0 * (double)total.died / games);
+    for (RoomType roomType = 0; roomType < _ROOM_TYPE_COUNT; ++roomType) {
+        if (total.deathsBy[roomType] > 0) {
+            printf(
+                "|   by %-8s %10" PRId64 " (%6.2f%%)\n",
+                RoomType_ToString(roomType),
+                total.deathsBy[roomType],
+                100.0 * (double)total.deathsBy[roomType] / games
+            );
+        }
+    }
+    printf("| timed out: %12" PRId64 " (%6.2f%%)\n", total.timedOut, 100.0 * (double)total.timedOut / games);
+    printf(
+        "| average turns: %.2f (won: %.2f, died: %.2f)\n",
+        (double)total.turns / games,
+        (double)total.wonTurns / (double)Max(total.won, 1),
+        (double)total.diedTurns / (double)Max(total.died, 1)
+    );
+
+    if (config.profilePath != NULL) {
+        Profile_WriteSummary(stdout);
+        if (!Profile_WriteTrace(config.profilePath)) {
+            fprintf(stderr, "Failed to write profile to '%s'.\n", config.profilePath);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void Sim_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "| --games N          number of games to play (default: 100000)\n"
+        "| --threads N        worker threads, 0 for one per processor (default: 0)\n"
+        "| --seed N           base seed - game i always uses stream i of this seed (default: time)\n"
+        "| --size WxH         dungeon size (default: 10x10)\n"
+        "| --max-turns N      give up on a game after this many turns (default: 10000)\n"
+        "| --generation M     'dense' generates every room up-front, 'hashed' generates rooms on demand\n"
+        "|                    and 'tiled' generates every room up-front across all cores (default: dense)\n"
+        "| --validation M     what to do with dungeons whose treasure can't be reached without fighting or\n"
+        "|                    crossing more than one pit: 'none' keeps them, 'reject' generates another and\n"
+        "|                    'repair' clears a path to the treasure (default: none, needs dense or tiled)\n"
+        "| --distribution L   comma-separated room weights in RoomType order, e.g. '50,25,10,10,15'\n"
+        "|                    (ROOM_TREASURE and ROOM_SPAWN may be omitted, and must be 0)\n"
+        "| --items L          comma-separated item weights in ItemType order, e.g. '1,1,1,1,1,1'\n"
+        "| --dump-map PATH    write the fully revealed map of game 0's dungeon to PATH\n"
+        "| --snapshot PATH    start every game from where the game saved at PATH left off (see snapshot.h)\n"
+        "| --solver V         play pits and fights optimally (see solver.h), valuing a retreat at V (0-1) of a win\n"
+        "| --profile PATH     write a Chrome trace to PATH and print a summary (DUNGEON_PROFILE builds only)\n",
+        program
+    );
+}
+
+static bool Sim_ParseArgs(const int32_t argc, const char *const argv[], SimConfig *const config) {
+    for (int32_t i = 1; i < argc; ++i) {
+        const char *const arg = argv[i];
+        const char *const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for '%s'.\n", arg);
+            return false;
+        }
+        ++i;
+
+        char* end = NULL;
+        if (strcmp(arg, "--games") == 0) {
+            config->games = strtoll(value, &end, 10);
+            if (*end != '\0' || config->games <= 0) {
+                fprintf(stderr, "Invalid game count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--threads") == 0) {
+            config->threads = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->threads < 0) {
+                fprintf(stderr, "Invalid thread count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--seed") == 0) {
+            if (!String_ParseUint64(value, &config->seed)) {
+                fprintf(stderr, "Invalid seed '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--max-turns") == 0) {
+            config->maxTurns = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->maxTurns <= 0) {
+                fprintf(stderr, "Invalid turn limit '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--size") == 0) {
+            if (!String_ParseSize(value, config->params.size)) {
+                fprintf(stderr, "Invalid dungeon size '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--generation") == 0) {
+            if (strcmp(value, "dense") == 0) {
+                config->params.generation = DUNGEON_GENERATION_DENSE;
+            } else if (strcmp(value, "hashed") == 0) {
+                config->params.generation = DUNGEON_GENERATION_HASHED;
+            } else if (strcmp(value, "tiled") == 0) {
+                config->params.generation = DUNGEON_GENERATION_TILED;
+            } else {
+                fprintf(stderr, "Invalid generation mode '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--validation") == 0) {
+            if (strcmp(value, "none") == 0) {
+                config->params.validation = DUNGEON_VALIDATION_NONE;
+            } else if (strcmp(value, "reject") == 0) {
+                config->params.validation = DUNGEON_VALIDATION_REJECT;
+            } else if (strcmp(value, "repair") == 0) {
+                config->params.validation = DUNGEON_VALIDATION_REPAIR;
+            } else {
+                fprintf(stderr, "Invalid validation mode '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--distribution") == 0) {
+            int32_t distribution[_ROOM_TYPE_COUNT] = { 0 };
+            const int32_t count = String_ParseWeights(value, _ROOM_TYPE_COUNT, distribution);
+            if (count < ROOM_TREASURE || distribution[ROOM_TREASURE] != 0 || distribution[ROOM_SPAWN] != 0) {
+                fprintf(stderr, "Invalid room distribution '%s'.\n", value);
+                return false;
+            }
+            memcpy(config->params.roomDistribution, distribution, sizeof(distribution));
+        } else if (strcmp(arg, "--items") == 0) {
+            int32_t distribution[_ITEM_TYPE_COUNT] = { 0 };
+            if (String_ParseWeights(value, _ITEM_TYPE_COUNT, distribution) != _ITEM_TYPE_COUNT) {
+                fprintf(stderr, "Invalid item distribution '%s'.\n", value);
+                return false;
+            }
+            memcpy(config->params.itemDistribution, distribution, sizeof(distribution));
+        } else if (strcmp(arg, "--dump-map") == 0) {
+            config->dumpMapPath = value;
+        } else if (strcmp(arg, "--solver") == 0) {
+            config->solverRetreatValue = strtof(value, &end);
+            if (*end != '\0' || !(config->solverRetreatValue >= 0.0f && config->solverRetreatValue <= 1.0f)) {
+                fprintf(stderr, "Invalid retreat value '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--snapshot") == 0) {
+            config->snapshotPath = value;
+        } else if (strcmp(arg, "--profile") == 0) {
+            if (!Profile_IsEnabled()) {
+                fprintf(stderr, "This build has no profiling - configure with -DDUNGEON_PROFILE=ON.\n");
+                return false;
+            }
+            config->profilePath = value;
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", arg);
+            return false;
+        }
+    }
+
+    const int64_t totalRooms = (int64_t)config->params.size[0] * config->params.size[1];
+    if (config->params.generation != DUNGEON_GENERATION_HASHED && totalRooms < _ROOM_TYPE_COUNT) {
+        fprintf(stderr, "Dungeon must have at least %d rooms.\n", _ROOM_TYPE_COUNT);
+        return false;
+    }
+    if (config->params.generation == DUNGEON_GENERATION_HASHED
+        && config->params.validation != DUNGEON_VALIDATION_NONE) {
+        fprintf(stderr, "Hashed dungeons can't be validated.\n");
+        return false;
+    }
+    return true;
+}
+
+static void Sim_RunTask(void *const context, const int32_t index, const int32_t worker) {
+    const SimJob *const job = context;
+    SimStats *const stats = &job->workerStats[worker];
+
+    const int64_t firstGame = (int64_t)index * gamesPerTask;
+    const int64_t lastGame = Min(firstGame + gamesPerTask, job->config->games);
+    for (int64_t gameIndex = firstGame; gameIndex < lastGame; ++gameIndex) {
+        Sim_PlayGame(job->config, job->solver, gameIndex, stats);
+    }
+}
+
+static void Sim_PlayGame(
+    const SimConfig *const config,
+    const Solver *const solver,
+    const int64_t gameIndex,
+    SimStats *const stats
+) {
+    // Every game gets its own stream, so results don't depend on how games are spread across threads:
+    Rng rng;
+    Rng_Seed(&rng, config->seed, (uint64_t)gameIndex);
+
+    GameState game;
+    Dungeon *const dungeon = Sim_InitGame(config, &rng, &game);
+
+    Rng botRng;
+    Rng_Seed(&botRng, Rng_Next64(&rng), (uint64_t)gameIndex);
+
+    // Snapshots are saved part way through a game, which has already entered the room it was saved in:
+    StepResult result = (config->snapshotPath != NULL) ? Game_Resume(&game) : Game_Start(&game);
+    int32_t turns = 0;
+    while (game.status == GAME_STATUS_PLAYING && turns < config->maxTurns) {
+        Action action = (solver != NULL) ? Solver_ChooseAction(solver, &game) : ACTION_NONE;
+        if (action == ACTION_NONE) {
+            action = Bot_ChooseAction(&game, &botRng);
+        }
+        result = Game_Step(&game, action);
+        ++turns;
+    }
+
+    stats->games += 1;
+    stats->turns += turns;
+    switch (game.status) {
+        case GAME_STATUS_PLAYING: {
+            stats->timedOut += 1;
+        } break;
+        case GAME_STATUS_WON: {
+            stats->won += 1;
+            stats->wonTurns += turns;
+        } break;
+        case GAME_STATUS_DIED: {
+            stats->died += 1;
+            stats->diedTurns += turns;
+            stats->deathsBy[Sim_GetDeathCause(&result)] += 1;
+        } break;
+    }
+
+    Dungeon_Destroy(dungeon);
+}
+
+static Dungeon* Sim_InitGame(const SimConfig *const config, Rng *const rng, GameState *const game) {
+    if (config->snapshotPath == NULL) {
+        Dungeon *const dungeon = Dungeon_CreateWithParams(&config->params, rng);
+        Game_Init(game, dungeon, rng);
+        return dungeon;
+    }
+
+    // Each game changes its dungeon, so it needs a fresh copy (which is only a mapping, so cheap to make):
+    // Each game still plays out differently, so the saved Rng is swapped for this game's own:
+    Dungeon *const dungeon = Snapshot_Load(config->snapshotPath, game);
+    assert(dungeon != NULL);
+    game->rng = *rng;
+    return dungeon;
+}
+
+static bool Sim_DumpMap(const SimConfig *const config) {
+    // Generate the dungeon exactly as Sim_PlayGame() would for the first game:
+    Rng rng;
+    Rng_Seed(&rng, config->seed, 0);
+    GameState game;
+    Dungeon *const dungeon = Sim_InitGame(config, &rng, &game);
+
+    RenderBuffer frame;
+    RenderBuffer_Init(&frame);
+    Render_Map(&frame, dungeon, &game.player, false);
+    const bool written = RenderBuffer_WriteToFile(&frame, config->dumpMapPath);
+    RenderBuffer_Destroy(&frame);
+
+    Dungeon_Destroy(dungeon);
+    return written;
+}
+
+static RoomType Sim_GetDeathCause(const StepResult *const result) {
+    RoomType cause = ROOM_EMPTY;
+    for (int32_t i = 0; i < result->eventCount; ++i) {
+        switch (result->events[i].type) {
+            case GAME_EVENT_TRAP_TRIGGERED: {
+                cause = ROOM_TRAP;
+            } break;
+            case GAME_EVENT_PIT_FELL: {
+                cause = ROOM_PIT;
+            } break;
+            case GAME_EVENT_PLAYER_HIT:
+            case GAME_EVENT_SHIELD_HIT:
+            case GAME_EVENT_FLED:
+            case GAME_EVENT_FLEE_FAILED: {
+                cause = ROOM_ENEMY;
+            } break;
+            default: {
+            } break;
+        }
+    }
+    return cause;
+}
@@ -0,0 +1,199 @@
+// Exact balance numbers for the game's encounters - solves every pit and fight with the expectimax Solver
+// and prints the odds of getting past each kind of enemy or pit when playing optimally.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dungeon/dungeon.h"
+#include "dungeon/game.h"
+#include "dungeon/item.h"
+#include "dungeon/parallel.h"
+#include "dungeon/player.h"
+#include "dungeon/solver.h"
+#include "dungeon/util.h"
+
+// Range of enemies to report on (covering everything Room_InitEnemy() generates, and then some):
+const int32_t solveMaxEnemyHealth = 10;
+const int32_t solveMinEnemyDamage = 2;
+const int32_t solveMaxEnemyDamage = 6;
+
+typedef struct SolveConfig {
+    int32_t threads;
+    float retreatValue;
+    int32_t health;
+    int32_t food;
+} SolveConfig;
+
+typedef struct Loadout {
+    const char* name;
+    uint8_t swords;
+    uint8_t shields;
+} Loadout;
+
+const Loadout loadouts[] = {
+    { "bare hands", 0, 0 },
+    { "SWORD", 1, 0 },
+    { "SHIELD", 0, 1 },
+    { "SWORD + SHIELD", 1, 1 },
+};
+
+static void Solve_PrintUsage(const char* program);
+static bool Solve_ParseArgs(int32_t argc, const char *const argv[], SolveConfig* config);
+static void Solve_PrintEnemies(const Solver* solver, const SolveConfig* config, const Loadout* loadout);
+static void Solve_PrintPits(const Solver* solver, const SolveConfig* config);
+
+int32_t main(const int32_t argc, const char *const argv[]) {
+    SolveConfig config = {
+        .threads = 0,
+        .retreatValue = 0.0f,
+        .health = GAME_PLAYER_MAX_HEALTH,
+        .food = 5,
+    };
+    if (!Solve_ParseArgs(argc, argv, &config)) {
+        Solve_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const int32_t threadCount = Parallel_ResolveThreadCount(config.threads);
+    const double startTime = Time_GetSeconds();
+    Solver solver;
+    Solver_Init(&solver, GAME_PLAYER_MAX_HEALTH, config.retreatValue, threadCount);
+    const double elapsedTime = Time_GetSeconds() - startTime;
+
+    printf(
+        "Solved every encounter in %.3fs using %d thread(s), valuing a retreat at %.2f of a win.\n",
+        elapsedTime,
+        threadCount,
+        config.retreatValue
+    );
+    printf("Odds below are for a player with %d HEALTH and %d FOOD.\n\n", config.health, config.food);
+    for (size_t i = 0; i < sizeof(loadouts) / sizeof(loadouts[0]); ++i) {
+        Solve_PrintEnemies(&solver, &config, &loadouts[i]);
+    }
+    Solve_PrintPits(&solver, &config);
+
+    Solver_Destroy(&solver);
+    return 0;
+}
+
+static void Solve_PrintUsage(const char *const program) {
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "| --threads N        worker threads, 0 for one per processor (default: 0)\n"
+        "| --retreat V        value of retreating from an encounter, as a fraction (0-1) of a win (default: 0)\n"
+        "| --health N         the player's current HEALTH (default: %d)\n"
+        "| --food N           how much FOOD the player has (default: 5)\n",
+        program,
+        GAME_PLAYER_MAX_HEALTH
+    );
+}
+
+static bool Solve_ParseArgs(const int32_t argc, const char *const argv[], SolveConfig *const config) {
+    for (int32_t i = 1; i < argc; ++i) {
+        const char *const arg = argv[i];
+        const char *const value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for '%s'.\n", arg);
+            return false;
+        }
+        ++i;
+
+        char* end = NULL;
+        if (strcmp(arg, "--threads") == 0) {
+            config->threads = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->threads < 0) {
+                fprintf(stderr, "Invalid thread count '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--retreat") == 0) {
+            config->retreatValue = strtof(value, &end);
+            if (*end != '\0' || !(config->retreatValue >= 0.0f && config->retreatValue <= 1.0f)) {
+                fprintf(stderr, "Invalid retreat value '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--health") == 0) {
+            config->health = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->health <= 0 || config->health > GAME_PLAYER_MAX_HEALTH) {
+                fprintf(stderr, "Invalid health '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--food") == 0) {
+            config->food = (int32_t)strtol(value, &end, 10);
+            if (*end != '\0' || config->food < 0 || config->food > SOLVER_MAX_FOOD) {
+                fprintf(stderr, "Invalid food count '%s'.\n", value);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void Solve_PrintEnemies(
+    const Solver *const solver,
+    const SolveConfig *const config,
+    const Loadout *const loadout
+) {
+    Player player = {
+        .health = {
+            .current = (int8_t)config->health,
+            .max = GAME_PLAYER_MAX_HEALTH,
+        },
+    };
+    player.inventory[ITEM_FOOD] = (uint8_t)config->food;
+    player.inventory[ITEM_SWORD] = loadout->swords;
+    player.inventory[ITEM_SHIELD] = loadout->shields;
+
+    printf("Chance of defeating an ENEMY with %s (first action in brackets):\n", loadout->name);
+    printf("| health \\ max damage");
+    for (int32_t maxDamage = solveMinEnemyDamage; maxDamage <= solveMaxEnemyDamage; ++maxDamage) {
+        printf(" %14d", maxDamage);
+    }
+    printf("\n");
+    for (int32_t enemyHealth = 1; enemyHealth <= solveMaxEnemyHealth; ++enemyHealth) {
+        printf("| %-19d", enemyHealth);
+        for (int32_t maxDamage = solveMinEnemyDamage; maxDamage <= solveMaxEnemyDamage; ++maxDamage) {
+            const Room room = {
+                .type = ROOM_ENEMY,
+                .enemy = {
+                    .health = (int8_t)enemyHealth,
+                    .maxDamage = (int8_t)maxDamage,
+                },
+            };
+            const SolverEntry entry = Solver_SolveEnemy(solver, &player, &room);
+            printf(" %6.2f%% (%-5s)", 100.0 * entry.win, Action_ToString((Action)entry.action));
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+static void Solve_PrintPits(const Solver *const solver, const SolveConfig *const config) {
+    printf("Chance of crossing a PIT without a ROPE and HOOK, by other items carried (first action in brackets):\n");
+    for (int32_t otherItems = 0; otherItems <= 30; otherItems += 2) {
+        Player player = {
+            .health = {
+                .current = (int8_t)config->health,
+                .max = GAME_PLAYER_MAX_HEALTH,
+            },
+        };
+        player.inventory[ITEM_FOOD] = (uint8_t)config->food;
+        player.inventory[ITEM_ROCK] = (uint8_t)otherItems;
+        const SolverEntry entry = Solver_SolvePit(solver, &player);
+        printf(
+            "| %2d item(s): %6.2f%% (%s)\n",
+            otherItems,
+            100.0 * entry.win,
+            Action_ToString((Action)entry.action)
+        );
+    }
+}